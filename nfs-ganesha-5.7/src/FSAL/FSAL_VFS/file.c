@@ -40,6 +40,10 @@
 #include <unistd.h>
 #include <fcntl.h>
 #include <sys/uio.h>
+#ifdef HAVE_FICLONERANGE
+#include <sys/ioctl.h>
+#include <linux/fs.h>
+#endif
 #include "vfs_methods.h"
 #include "os/subr.h"
 #include "sal_data.h"
@@ -1639,6 +1643,337 @@ fsal_status_t vfs_fallocate(struct fsal_obj_handle *obj_hdl,
 }
 #endif
 
+#if defined(HAVE_COPY_FILE_RANGE) || defined(HAVE_FICLONERANGE)
+/**
+ * @brief Descriptors to do I/O between two files
+ */
+struct vfs_io_pair {
+	struct vfs_fd src_temp_fd;
+	struct vfs_fd dst_temp_fd;
+	struct fsal_fd *src_out_fd;
+	struct fsal_fd *dst_out_fd;
+	fsal_openflags_t dst_flags;
+	int src_fd;
+	int dst_fd;
+};
+
+/**
+ * @brief Get descriptors to read one file and write another
+ *
+ * When it succeeds, vfs_complete_io_pair() must be called.
+ *
+ * @return FSAL status.
+ */
+static fsal_status_t vfs_start_io_pair(struct vfs_io_pair *io,
+				       struct fsal_obj_handle *src_hdl,
+				       struct state_t *src_state,
+				       struct fsal_obj_handle *dst_hdl,
+				       struct state_t *dst_state)
+{
+	struct vfs_fsal_obj_handle *src, *dst;
+	fsal_status_t status;
+	bool same = src_hdl == dst_hdl;
+
+	src = container_of(src_hdl, struct vfs_fsal_obj_handle, obj_handle);
+	dst = container_of(dst_hdl, struct vfs_fsal_obj_handle, obj_handle);
+
+	io->src_temp_fd = (struct vfs_fd) { FSAL_FD_INIT, -1 };
+	io->dst_temp_fd = (struct vfs_fd) { FSAL_FD_INIT, -1 };
+	io->src_out_fd = NULL;
+	io->dst_flags = FSAL_O_WRITE;
+
+	/* Within one file, a single descriptor open for both: a second
+	 * fsal_start_io() on the same object could have to wait for the
+	 * first one to reopen the global fd.
+	 */
+	if (same)
+		io->dst_flags = FSAL_O_RDWR;
+	else {
+		status = fsal_start_io(&io->src_out_fd, src_hdl,
+				       &src->u.file.fd.fsal_fd,
+				       &io->src_temp_fd.fsal_fd, src_state,
+				       FSAL_O_READ, false, NULL, false,
+				       &src->u.file.share);
+		if (FSAL_IS_ERROR(status)) {
+			LogFullDebug(COMPONENT_FSAL,
+				     "fsal_start_io failed returning %s",
+				     fsal_err_txt(status));
+			return status;
+		}
+	}
+
+	status = fsal_start_io(&io->dst_out_fd, dst_hdl,
+			       &dst->u.file.fd.fsal_fd,
+			       &io->dst_temp_fd.fsal_fd,
+			       dst_state != NULL || !same ? dst_state : src_state,
+			       io->dst_flags, false, NULL, false,
+			       &dst->u.file.share);
+	if (FSAL_IS_ERROR(status)) {
+		LogFullDebug(COMPONENT_FSAL,
+			     "fsal_start_io failed returning %s",
+			     fsal_err_txt(status));
+
+		if (!same) {
+			fsal_complete_io(src_hdl, io->src_out_fd);
+			if (src_state == NULL)
+				update_share_counters_locked(
+					src_hdl, &src->u.file.share,
+					FSAL_O_READ, FSAL_O_CLOSED);
+		}
+		return status;
+	}
+
+	io->dst_fd = container_of(io->dst_out_fd, struct vfs_fd, fsal_fd)->fd;
+	io->src_fd = same ? io->dst_fd
+			  : container_of(io->src_out_fd, struct vfs_fd,
+					 fsal_fd)->fd;
+
+	return status;
+}
+
+/**
+ * @brief Release the descriptors from vfs_start_io_pair()
+ */
+static void vfs_complete_io_pair(struct vfs_io_pair *io,
+				 struct fsal_obj_handle *src_hdl,
+				 struct state_t *src_state,
+				 struct fsal_obj_handle *dst_hdl,
+				 struct state_t *dst_state)
+{
+	struct vfs_fsal_obj_handle *src, *dst;
+	fsal_status_t status;
+	bool same = src_hdl == dst_hdl;
+
+	src = container_of(src_hdl, struct vfs_fsal_obj_handle, obj_handle);
+	dst = container_of(dst_hdl, struct vfs_fsal_obj_handle, obj_handle);
+
+	status = fsal_complete_io(dst_hdl, io->dst_out_fd);
+
+	LogFullDebug(COMPONENT_FSAL,
+		     "fsal_complete_io returned %s",
+		     fsal_err_txt(status));
+
+	if (dst_state == NULL && (!same || src_state == NULL)) {
+		/* We did I/O without a state so we need to release the temp
+		 * share reservation acquired.
+		 */
+		update_share_counters_locked(dst_hdl, &dst->u.file.share,
+					     io->dst_flags, FSAL_O_CLOSED);
+	}
+
+	if (same)
+		return;
+
+	status = fsal_complete_io(src_hdl, io->src_out_fd);
+
+	LogFullDebug(COMPONENT_FSAL,
+		     "fsal_complete_io returned %s",
+		     fsal_err_txt(status));
+
+	if (src_state == NULL) {
+		update_share_counters_locked(src_hdl, &src->u.file.share,
+					     FSAL_O_READ, FSAL_O_CLOSED);
+	}
+}
+#endif
+
+#ifdef HAVE_COPY_FILE_RANGE
+/* Size of the bounce buffer when the kernel can not copy for us */
+#define VFS_COPY_BUFSIZE (1024 * 1024)
+
+/**
+ * @brief Copy with read and write when copy_file_range() does not apply
+ *
+ * @return 0 or an errno
+ */
+static int vfs_copy_rw(int src_fd, uint64_t src_offset,
+		       int dst_fd, uint64_t dst_offset,
+		       uint64_t count, uint64_t *copied)
+{
+	ssize_t nread, nwritten, done;
+	char *buf = gsh_malloc(MIN(count - *copied, VFS_COPY_BUFSIZE));
+	int retval = 0;
+
+	while (*copied < count) {
+		nread = pread(src_fd, buf,
+			      MIN(count - *copied, VFS_COPY_BUFSIZE),
+			      src_offset + *copied);
+		if (nread < 0) {
+			retval = errno;
+			break;
+		}
+		if (nread == 0)
+			break;
+
+		for (done = 0; done < nread; done += nwritten) {
+			nwritten = pwrite(dst_fd, buf + done, nread - done,
+					  dst_offset + *copied + done);
+			if (nwritten < 0) {
+				retval = errno;
+				goto out;
+			}
+		}
+
+		*copied += nread;
+	}
+
+out:
+	gsh_free(buf);
+	return retval;
+}
+
+/**
+ * @brief Copy a range of bytes between two files
+ *
+ * The kernel does the copy with copy_file_range(), which lets the
+ * filesystem share extents or copy on the server side for network
+ * filesystems.  Where it is not available for this pair of files, the data
+ * is copied through a bounce buffer instead.
+ *
+ * @param[in]  src_hdl     File to copy from
+ * @param[in]  src_state   state_t to use to read the source (or NULL)
+ * @param[in]  src_offset  Offset in the source
+ * @param[in]  dst_hdl     File to copy to
+ * @param[in]  dst_state   state_t to use to write the destination (or NULL)
+ * @param[in]  dst_offset  Offset in the destination
+ * @param[in]  count       Number of bytes to copy
+ * @param[out] copied      Number of bytes copied
+ *
+ * @return FSAL status.
+ */
+
+fsal_status_t vfs_copy(struct fsal_obj_handle *src_hdl,
+		       struct state_t *src_state, uint64_t src_offset,
+		       struct fsal_obj_handle *dst_hdl,
+		       struct state_t *dst_state, uint64_t dst_offset,
+		       uint64_t count, uint64_t *copied)
+{
+	struct vfs_io_pair io;
+	fsal_status_t status;
+	ssize_t nbytes;
+	int retval = 0;
+
+	*copied = 0;
+
+	status = vfs_start_io_pair(&io, src_hdl, src_state,
+				   dst_hdl, dst_state);
+	if (FSAL_IS_ERROR(status))
+		return status;
+
+	if (!vfs_set_credentials(&op_ctx->creds, dst_hdl->fsal)) {
+		status = posix2fsal_status(EPERM);
+		goto out;
+	}
+
+	while (*copied < count) {
+		loff_t src_off = src_offset + *copied;
+		loff_t dst_off = dst_offset + *copied;
+
+		nbytes = copy_file_range(io.src_fd, &src_off,
+					 io.dst_fd, &dst_off,
+					 count - *copied, 0);
+		if (nbytes < 0) {
+			retval = errno;
+			break;
+		}
+		if (nbytes == 0)
+			break;
+
+		*copied += nbytes;
+	}
+
+	/* Not supported by the kernel or across these filesystems.  Some
+	 * filesystems say EINVAL rather than EOPNOTSUPP; the ranges were
+	 * checked by the protocol layer and we never open with O_APPEND,
+	 * so EINVAL means the same here.
+	 */
+	if (retval == ENOSYS || retval == EXDEV || retval == EOPNOTSUPP ||
+	    retval == EINVAL)
+		retval = vfs_copy_rw(io.src_fd, src_offset, io.dst_fd,
+				     dst_offset, count, copied);
+
+	if (retval != 0) {
+		LogFullDebug(COMPONENT_FSAL,
+			     "copy returned %s (%d)",
+			     strerror(retval), retval);
+		status = posix2fsal_status(retval);
+	}
+
+	vfs_restore_ganesha_credentials(dst_hdl->fsal);
+
+ out:
+
+	vfs_complete_io_pair(&io, src_hdl, src_state, dst_hdl, dst_state);
+
+	return status;
+}
+#endif
+
+#ifdef HAVE_FICLONERANGE
+/**
+ * @brief Share the extents of a range of one file with another
+ *
+ * Uses the FICLONERANGE ioctl, so it works where the filesystem can
+ * reflink (XFS, Btrfs, ...).  Elsewhere the kernel says EOPNOTSUPP and
+ * the client falls back to copying.
+ *
+ * @param[in] src_hdl     File to clone from
+ * @param[in] src_state   state_t to use to read the source (or NULL)
+ * @param[in] src_offset  Offset in the source
+ * @param[in] dst_hdl     File to clone to
+ * @param[in] dst_state   state_t to use to write the destination (or NULL)
+ * @param[in] dst_offset  Offset in the destination
+ * @param[in] count       Number of bytes to clone
+ *
+ * @return FSAL status.
+ */
+
+fsal_status_t vfs_clone(struct fsal_obj_handle *src_hdl,
+			struct state_t *src_state, uint64_t src_offset,
+			struct fsal_obj_handle *dst_hdl,
+			struct state_t *dst_state, uint64_t dst_offset,
+			uint64_t count)
+{
+	struct vfs_io_pair io;
+	struct file_clone_range range;
+	fsal_status_t status;
+	int retval;
+
+	status = vfs_start_io_pair(&io, src_hdl, src_state,
+				   dst_hdl, dst_state);
+	if (FSAL_IS_ERROR(status))
+		return status;
+
+	if (!vfs_set_credentials(&op_ctx->creds, dst_hdl->fsal)) {
+		status = posix2fsal_status(EPERM);
+		goto out;
+	}
+
+	range.src_fd = io.src_fd;
+	range.src_offset = src_offset;
+	range.src_length = count;
+	range.dest_offset = dst_offset;
+
+	retval = ioctl(io.dst_fd, FICLONERANGE, &range);
+
+	if (retval < 0) {
+		retval = errno;
+		LogFullDebug(COMPONENT_FSAL,
+			     "FICLONERANGE returned %s (%d)",
+			     strerror(retval), retval);
+		status = posix2fsal_status(retval);
+	}
+
+	vfs_restore_ganesha_credentials(dst_hdl->fsal);
+
+ out:
+
+	vfs_complete_io_pair(&io, src_hdl, src_state, dst_hdl, dst_state);
+
+	return status;
+}
+#endif
+
 /**
  * @brief Commit written data
  *
@@ -1763,6 +1763,12 @@ void vfs_handle_ops_init(struct fsal_obj_ops *ops)
 	ops->close = vfs_close;
 #ifdef FALLOC_FL_PUNCH_HOLE
 	ops->fallocate = vfs_fallocate;
+#endif
+#ifdef HAVE_COPY_FILE_RANGE
+	ops->copy = vfs_copy;
+#endif
+#ifdef HAVE_FICLONERANGE
+	ops->clone = vfs_clone;
 #endif
 	ops->handle_to_wire = handle_to_wire;
 	ops->handle_to_key = handle_to_key;
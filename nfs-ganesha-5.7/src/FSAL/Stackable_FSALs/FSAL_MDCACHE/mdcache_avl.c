@@ -35,7 +35,7 @@
 
 /**
  * @file mdcache_avl.c
- * @brief AVL tree for caching directory entries
+ * @brief Dirent indexes of a cached directory
  */
 
 #include "config.h"
@@ -55,29 +55,92 @@
 #include <pthread.h>
 #include <assert.h>
 
+/**
+ * @brief Find a live dirent by name
+ *
+ * Walks the probe run of the name hash, comparing names to resolve hash
+ * collisions.
+ */
+static mdcache_dir_entry_t *
+mdc_dirent_lookup_name(struct mdc_dirent_index *idx, uint64_t namehash,
+		       const char *name)
+{
+	uint32_t i;
+
+	if (idx->slots == NULL)
+		return NULL;
+
+	for (i = mdc_dirent_index_home(idx, namehash);
+	     idx->slots[i].dirent != NULL;
+	     i = (i + 1) & idx->mask) {
+		if (idx->slots[i].key == namehash &&
+		    strcmp(idx->slots[i].dirent->name, name) == 0)
+			return idx->slots[i].dirent;
+	}
+
+	return NULL;
+}
+
 void
-mdcache_avl_init(mdcache_entry_t *entry)
+mdc_dirents_init(mdcache_entry_t *entry)
 {
-	avltree_init(&entry->fsobj.fsdir.avl.t, avl_dirent_name_cmpf,
-		     0 /* flags */);
-	avltree_init(&entry->fsobj.fsdir.avl.ck, avl_dirent_ck_cmpf,
-		     0 /* flags */);
-	avltree_init(&entry->fsobj.fsdir.avl.sorted, avl_dirent_sorted_cmpf,
+	struct mdcache_fsdir *fsdir = entry->fsobj.fsdir;
+
+	memset(&fsdir->dirents.by_name, 0, sizeof(struct mdc_dirent_index));
+	memset(&fsdir->dirents.by_ck, 0, sizeof(struct mdc_dirent_index));
+	avltree_init(&fsdir->dirents.sorted, avl_dirent_sorted_cmpf,
 		     0 /* flags */);
 }
 
-static inline struct avltree_node *
-avltree_inline_lookup_hk(const struct avltree_node *key,
-			 const struct avltree *tree)
+/**
+ * @brief Release the dirent index storage of a directory
+ *
+ * @note The name index MUST be empty, see mdc_dirents_clean.  The cookie
+ *       index need not be: mdcache_clean_dirent_chunks() only drops the
+ *       directory's ref on each chunk, and a chunk that a READDIR still
+ *       holds a ref on (taken by mdc_dirents_lookup_ck() or while it
+ *       populates the chunk) is only cleaned, and its dirents unchunked,
+ *       when that ref goes.  Those dirents are dropped from the index here,
+ *       and unchunk_dirent() removing them later from an index they are no
+ *       longer in is harmless.
+ *
+ * @param[in] entry The directory
+ */
+void
+mdc_dirents_fini(mdcache_entry_t *entry)
 {
-	return avltree_inline_lookup(key, tree, avl_dirent_name_cmpf);
+	struct mdcache_fsdir *fsdir = entry->fsobj.fsdir;
+
+	assert(fsdir->dirents.by_name.count == 0);
+
+#ifdef DEBUG_MDCACHE
+	/* Anything left in the cookie index must be in a referenced chunk */
+	if (fsdir->dirents.by_ck.slots != NULL) {
+		uint32_t i;
+
+		for (i = 0; i <= fsdir->dirents.by_ck.mask; i++) {
+			mdcache_dir_entry_t *dirent =
+					fsdir->dirents.by_ck.slots[i].dirent;
+
+			if (dirent == NULL)
+				continue;
+
+			assert(dirent->chunk != NULL);
+			assert(atomic_fetch_int32_t(
+				&dirent->chunk->chunk_lru.refcnt) > 0);
+		}
+	}
+#endif
+
+	mdc_dirent_index_free(&fsdir->dirents.by_name);
+	mdc_dirent_index_free(&fsdir->dirents.by_ck);
 }
 
 void
-avl_dirent_set_deleted(mdcache_entry_t *entry, mdcache_dir_entry_t *v)
+mdc_dirent_set_deleted(mdcache_entry_t *entry, mdcache_dir_entry_t *v)
 {
-	struct avltree_node *node;
 	mdcache_dir_entry_t *next;
+	bool found;
 
 	LogFullDebugAlt(COMPONENT_NFS_READDIR, COMPONENT_MDCACHE,
 			"Delete dir entry %p %s",
@@ -88,10 +151,10 @@ avl_dirent_set_deleted(mdcache_entry_t *entry, mdcache_dir_entry_t *v)
 #endif
 	assert(!(v->flags & DIR_ENTRY_FLAG_DELETED));
 
-	node = avltree_inline_lookup_hk(&v->node_name,
-					&entry->fsobj.fsdir.avl.t);
-	assert(node);
-	avltree_remove(&v->node_name, &entry->fsobj.fsdir.avl.t);
+	found = mdc_dirent_index_remove(&entry->fsobj.fsdir->dirents.by_name,
+					v->namehash, v);
+	assert(found);
+	(void) found;
 
 	v->flags |= DIR_ENTRY_FLAG_DELETED;
 	mdcache_key_delete(&v->ckey);
@@ -101,7 +164,7 @@ avl_dirent_set_deleted(mdcache_entry_t *entry, mdcache_dir_entry_t *v)
 		struct dir_chunk *chunk = v->chunk;
 		mdcache_entry_t *parent = chunk->parent;
 
-		if (v->ck == parent->fsobj.fsdir.first_ck) {
+		if (v->ck == parent->fsobj.fsdir->first_ck) {
 			/* This is no longer the first entry in the directory...
 			 * Find the first non-deleted entry.
 			 */
@@ -129,7 +192,7 @@ avl_dirent_set_deleted(mdcache_entry_t *entry, mdcache_dir_entry_t *v)
 
 				/* Look for the next chunk */
 				if (chunk->next_ck != 0 &&
-				    mdcache_avl_lookup_ck(parent,
+				    mdc_dirents_lookup_ck(parent,
 							  chunk->next_ck,
 							  &next)) {
 					chunk = next->chunk;
@@ -141,10 +204,10 @@ avl_dirent_set_deleted(mdcache_entry_t *entry, mdcache_dir_entry_t *v)
 
 			if (next != NULL) {
 				/* This entry is now the first_ck. */
-				parent->fsobj.fsdir.first_ck = next->ck;
+				parent->fsobj.fsdir->first_ck = next->ck;
 			} else {
 				/* There are no more cached chunks */
-				parent->fsobj.fsdir.first_ck = 0;
+				parent->fsobj.fsdir->first_ck = 0;
 			}
 		}
 
@@ -153,7 +216,7 @@ avl_dirent_set_deleted(mdcache_entry_t *entry, mdcache_dir_entry_t *v)
 		 * enumeration will have to skip deleted entries.
 		 */
 	} else {
-		mdcache_avl_remove(entry, v);
+		mdc_dirents_remove(entry, v);
 	}
 }
 
@@ -182,20 +245,21 @@ void unchunk_dirent(mdcache_dir_entry_t *dirent)
 	/* Remove from chunk */
 	glist_del(&dirent->chunk_list);
 
-	/* Remove from FSAL cookie AVL tree */
-	avltree_remove(&dirent->node_ck, &parent->fsobj.fsdir.avl.ck);
+	/* Remove from FSAL cookie index */
+	(void) mdc_dirent_index_remove(&parent->fsobj.fsdir->dirents.by_ck,
+				       dirent->ck, dirent);
 
 	/* Check if this was the first dirent in the directory. */
-	if (parent->fsobj.fsdir.first_ck == dirent->ck) {
+	if (parent->fsobj.fsdir->first_ck == dirent->ck) {
 		/* The first dirent in the directory is no longer chunked... */
-		parent->fsobj.fsdir.first_ck = 0;
+		parent->fsobj.fsdir->first_ck = 0;
 	}
 
 	/* Check if this entry was in the sorted AVL tree */
 	if (dirent->flags & DIR_ENTRY_SORTED) {
 		/* It was, remove it. */
 		avltree_remove(&dirent->node_sorted,
-			       &parent->fsobj.fsdir.avl.sorted);
+			       &parent->fsobj.fsdir->dirents.sorted);
 	}
 
 	/* Just make sure... */
@@ -211,14 +275,16 @@ void unchunk_dirent(mdcache_dir_entry_t *dirent)
  * @param[in] dirent    The dirent to remove
  *
  */
-void mdcache_avl_remove(mdcache_entry_t *parent,
+void mdc_dirents_remove(mdcache_entry_t *parent,
 			mdcache_dir_entry_t *dirent)
 {
 	struct dir_chunk *chunk = dirent->chunk;
 
 	if ((dirent->flags & DIR_ENTRY_FLAG_DELETED) == 0) {
-		/* Remove from active names tree */
-		avltree_remove(&dirent->node_name, &parent->fsobj.fsdir.avl.t);
+		/* Remove from active names index */
+		(void) mdc_dirent_index_remove(
+				&parent->fsobj.fsdir->dirents.by_name,
+				dirent->namehash, dirent);
 	}
 
 	if (dirent->mde_entry) {
@@ -246,7 +312,7 @@ void mdcache_avl_remove(mdcache_entry_t *parent,
 }
 
 /**
- * @brief Insert a dirent into the lookup by FSAL cookie AVL tree.
+ * @brief Insert a dirent into the lookup by FSAL cookie index.
  *
  * @param[in] entry The directory
  * @param[in] v     The dirent
@@ -255,9 +321,9 @@ void mdcache_avl_remove(mdcache_entry_t *parent,
  * @retval -1 Failure
  *
  */
-int mdcache_avl_insert_ck(mdcache_entry_t *entry, mdcache_dir_entry_t *v)
+int mdc_dirents_insert_ck(mdcache_entry_t *entry, mdcache_dir_entry_t *v)
 {
-	struct avltree_node *node;
+	struct mdc_dirent_index *idx = &entry->fsobj.fsdir->dirents.by_ck;
 
 	LogFullDebugAlt(COMPONENT_NFS_READDIR, COMPONENT_MDCACHE,
 			"Insert dirent %p for %s on entry=%p FSAL cookie=%"
@@ -267,10 +333,8 @@ int mdcache_avl_insert_ck(mdcache_entry_t *entry, mdcache_dir_entry_t *v)
 #ifdef DEBUG_MDCACHE
 	assert(entry->content_lock.__data.__cur_writer);
 #endif
-	node = avltree_inline_insert(&v->node_ck, &entry->fsobj.fsdir.avl.ck,
-				     avl_dirent_ck_cmpf);
-
-	if (!node) {
+	if (mdc_dirent_index_lookup(idx, v->ck) == NULL) {
+		mdc_dirent_index_insert(idx, v->ck, v);
 		LogDebugAlt(COMPONENT_NFS_READDIR, COMPONENT_MDCACHE,
 			    "inserted dirent %p for %s on entry=%p FSAL cookie=%"
 			    PRIx64,
@@ -287,11 +351,33 @@ int mdcache_avl_insert_ck(mdcache_entry_t *entry, mdcache_dir_entry_t *v)
 	return -1;
 }
 
+/**
+ * @brief Change the FSAL cookie of a chunked dirent
+ *
+ * @note The caller must hold the content_lock of the directory for write.
+ *
+ * @param[in] entry The directory
+ * @param[in] v     The dirent, which MUST be in the cookie index
+ * @param[in] ck    The new cookie
+ */
+void mdc_dirents_rekey_ck(mdcache_entry_t *entry, mdcache_dir_entry_t *v,
+			  uint64_t ck)
+{
+	struct mdc_dirent_index *idx = &entry->fsobj.fsdir->dirents.by_ck;
+
+#ifdef DEBUG_MDCACHE
+	assert(entry->content_lock.__data.__cur_writer);
+#endif
+	(void) mdc_dirent_index_remove(idx, v->ck, v);
+	v->ck = ck;
+	mdc_dirent_index_insert(idx, ck, v);
+}
+
 #define MIN_COOKIE_VAL 3
 
 /*
- * Insert into avl tree using key combination of hash of name with strcmp
- * of name to disambiguate hash collision.
+ * Insert into the name index using key combination of hash of name with
+ * strcmp of name to disambiguate hash collision.
  *
  * In the case of a name collision, assuming the ckey in the dirents matches,
  * and the flags are the same,  then this will be treated as a success and the
@@ -309,13 +395,12 @@ int mdcache_avl_insert_ck(mdcache_entry_t *entry, mdcache_dir_entry_t *v)
  *
  **/
 int
-mdcache_avl_insert(mdcache_entry_t *entry, mdcache_dir_entry_t **dirent)
+mdc_dirents_insert(mdcache_entry_t *entry, mdcache_dir_entry_t **dirent)
 {
 	mdcache_dir_entry_t *v = *dirent, *v2;
 #if AVL_HASH_MURMUR3
 	uint32_t hk[4];
 #endif
-	struct avltree_node *node;
 	int code;
 
 	LogFullDebugAlt(COMPONENT_NFS_READDIR, COMPONENT_MDCACHE,
@@ -335,21 +420,25 @@ mdcache_avl_insert(mdcache_entry_t *entry, mdcache_dir_entry_t **dirent)
 
 again:
 
-	node = avltree_insert(&v->node_name, &entry->fsobj.fsdir.avl.t);
+	v2 = mdc_dirent_lookup_name(&entry->fsobj.fsdir->dirents.by_name,
+				    v->namehash, v->name);
 
-	if (!node) {
+	if (!v2) {
 		/* success */
+		mdc_dirent_index_insert(&entry->fsobj.fsdir->dirents.by_name,
+					v->namehash, v);
+
 		if (v->chunk != NULL) {
 			/* This directory entry is part of a chunked directory
-			 * enter it into the "by FSAL cookie" avl also.
+			 * enter it into the "by FSAL cookie" index also.
 			 */
-			if (mdcache_avl_insert_ck(entry, v) < 0) {
+			if (mdc_dirents_insert_ck(entry, v) < 0) {
 				/* We failed to insert into FSAL cookie
-				 * AVL tree, remove from lookup by name
-				 * AVL tree.
+				 * index, remove from lookup by name index.
 				 */
-				avltree_remove(&v->node_name,
-					       &entry->fsobj.fsdir.avl.t);
+				(void) mdc_dirent_index_remove(
+					&entry->fsobj.fsdir->dirents.by_name,
+					v->namehash, v);
 				v2 = NULL;
 				code = -4;
 				goto out;
@@ -373,7 +462,6 @@ again:
 	}
 
 	/* Deal with name collision. */
-	v2 = avltree_container_of(node, mdcache_dir_entry_t, node_name);
 
 	/* Same name, probably already inserted. */
 	LogDebugAlt(COMPONENT_NFS_READDIR, COMPONENT_MDCACHE,
@@ -403,7 +491,7 @@ again:
 		}
 
 		/* Remove the found dirent. */
-		mdcache_avl_remove(entry, v2);
+		mdc_dirents_remove(entry, v2);
 		v2 = NULL;
 		goto again;
 	}
@@ -413,17 +501,18 @@ again:
 
 	if (v->chunk != NULL && v2->chunk == NULL) {
 		/* This directory entry is part of a chunked directory enter the
-		 * old dirent into the "by FSAL cookie" AVL tree also.
+		 * old dirent into the "by FSAL cookie" index also.
 		 * We need to update the old dirent for the FSAL cookie
 		 * bits...
 		 */
 		v2->chunk = v->chunk;
 		v2->ck = v->ck;
-		v2->eod = v->eod;
+		v2->flags = (v2->flags & ~DIR_ENTRY_EOD) |
+			    (v->flags & DIR_ENTRY_EOD);
 
-		if (mdcache_avl_insert_ck(entry, v2) < 0) {
-			/* We failed to insert into FSAL cookie AVL
-			 * tree, leave in lookup by name AVL tree but
+		if (mdc_dirents_insert_ck(entry, v2) < 0) {
+			/* We failed to insert into FSAL cookie index,
+			 * leave in lookup by name index but
 			 * don't return a dirent. Also, undo the changes
 			 * to the old dirent.
 			 */
@@ -446,7 +535,8 @@ again:
 						PRIx64
 						" and chunk %p eod=%s ckey=%s",
 						v2, v2->ck, v2->chunk,
-						v2->eod ? "true" : "false",
+						(v2->flags & DIR_ENTRY_EOD)
+							? "true" : "false",
 						str);
 			}
 
@@ -515,27 +605,21 @@ out:
  * @retval true if found
  * @retval false if not found
  */
-bool mdcache_avl_lookup_ck(mdcache_entry_t *entry, uint64_t ck,
+bool mdc_dirents_lookup_ck(mdcache_entry_t *entry, uint64_t ck,
 			   mdcache_dir_entry_t **dirent)
 {
-	struct avltree *tck = &entry->fsobj.fsdir.avl.ck;
-	mdcache_dir_entry_t dirent_key[1];
 	mdcache_dir_entry_t *ent;
-	struct avltree_node *node;
 
 	*dirent = NULL;
-	dirent_key->ck = ck;
 
-	node = avltree_inline_lookup(&dirent_key->node_ck, tck,
-				     avl_dirent_ck_cmpf);
+	ent = mdc_dirent_index_lookup(&entry->fsobj.fsdir->dirents.by_ck, ck);
 
-	if (node) {
+	if (ent) {
 		struct dir_chunk *chunk;
 		/* This is the entry we are looking for... This function is
 		 * passed the cookie of the next entry of interest in the
 		 * directory.
 		 */
-		ent = avltree_container_of(node, mdcache_dir_entry_t, node_ck);
 		chunk = ent->chunk;
 		if (chunk == NULL) {
 			/* This entry doesn't belong to a chunk, something
@@ -552,12 +636,11 @@ bool mdcache_avl_lookup_ck(mdcache_entry_t *entry, uint64_t ck,
 	return false;
 }
 
-mdcache_dir_entry_t *mdcache_avl_lookup(mdcache_entry_t *entry,
+mdcache_dir_entry_t *mdc_dirents_lookup(mdcache_entry_t *entry,
 					const char *name)
 {
-	struct avltree_node *node;
 	mdcache_dir_entry_t *v2;
-	mdcache_dir_entry_t v;
+	uint64_t namehash;
 #if AVL_HASH_MURMUR3
 	uint32_t hashbuff[4];
 #endif
@@ -568,20 +651,16 @@ mdcache_dir_entry_t *mdcache_avl_lookup(mdcache_entry_t *entry,
 
 #if AVL_HASH_MURMUR3
 	MurmurHash3_x64_128(name, namelen, 67, hashbuff);
-	/* This seems to be correct.  The avltree_lookup function looks
-	   as hk.k, but does no namecmp on its own, so there's no need to
-	   allocate space for or copy the name in the key. */
-	memcpy(&v.namehash, hashbuff, 8);
+	memcpy(&namehash, hashbuff, 8);
 #else
-	v.namehash = CityHash64WithSeed(name, namelen, 67);
+	namehash = CityHash64WithSeed(name, namelen, 67);
 #endif
-	v.name = name;
 
-	node = avltree_lookup(&v.node_name, &entry->fsobj.fsdir.avl.t);
+	v2 = mdc_dirent_lookup_name(&entry->fsobj.fsdir->dirents.by_name,
+				    namehash, name);
 
-	if (node) {
+	if (v2) {
 		/* return dirent */
-		v2 = avltree_container_of(node, mdcache_dir_entry_t, node_name);
 		assert(!(v2->flags & DIR_ENTRY_FLAG_DELETED));
 		return v2;
 	}
@@ -593,27 +672,39 @@ mdcache_dir_entry_t *mdcache_avl_lookup(mdcache_entry_t *entry,
 }
 
 /**
- * @brief Remove and free all dirents from the dirent trees for a directory
+ * @brief Remove and free all dirents from the dirent indexes for a directory
+ *
+ * Once the directory is empty, the index storage is released as well.
+ *
+ * @note The chunks MUST have been cleaned first.
  *
  * @param[in] parent    The directory removing from
  */
-void mdcache_avl_clean_trees(mdcache_entry_t *parent)
+void mdc_dirents_clean(mdcache_entry_t *parent)
 {
-	struct avltree_node *dirent_node;
+	struct mdc_dirent_index *idx = &parent->fsobj.fsdir->dirents.by_name;
 	mdcache_dir_entry_t *dirent;
+	uint32_t i;
 
 #ifdef DEBUG_MDCACHE
 	assert(parent->content_lock.__data.__cur_writer);
 #endif
 
-	while ((dirent_node = avltree_first(&parent->fsobj.fsdir.avl.t))) {
-		dirent = avltree_container_of(dirent_node, mdcache_dir_entry_t,
-					      node_name);
-		LogFullDebugAlt(COMPONENT_NFS_READDIR, COMPONENT_MDCACHE,
-				"Invalidate %p %s", dirent, dirent->name);
+	/* Removal shifts later slots of a probe run back into the freed
+	 * slot, so keep draining a slot until it is empty.
+	 */
+	for (i = 0; idx->slots != NULL && i <= idx->mask; i++) {
+		while ((dirent = idx->slots[i].dirent) != NULL) {
+			LogFullDebugAlt(COMPONENT_NFS_READDIR,
+					COMPONENT_MDCACHE,
+					"Invalidate %p %s",
+					dirent, dirent->name);
 
-		mdcache_avl_remove(parent, dirent);
+			mdc_dirents_remove(parent, dirent);
+		}
 	}
+
+	mdc_dirents_fini(parent);
 }
 
 /** @} */
@@ -38,14 +38,16 @@
 /**
  * @page AVLOverview Overview
  *
- * Definitions supporting AVL dirent representation.  The current
- * design represents dirents as a single AVL tree ordered by a
- * collision-resistent hash function (currently, Murmur3, which
- * appears to be several times faster than lookup3 on x86_64
- * architecture).  Quadratic probing is used to emulate perfect
- * hashing.  Worst case behavior is challenging to reproduce.
- * Heuristic methods are used to detect worst-case scenarios and fall
- * back to tractable (e.g., lookup) algorithms.
+ * Definitions supporting the dirent representation.  Dirents are
+ * indexed by a collision-resistent hash of their name (currently,
+ * Murmur3, which appears to be several times faster than lookup3 on
+ * x86_64 architecture) and, once chunked, by FSAL cookie.  Both
+ * indexes are open addressing tables with linear probing (see
+ * mdcache_dirent_index.h), which keep lookups in huge directories to a
+ * handful of adjacent cache lines.
+ * Name hash collisions are resolved by comparing the names.  Dirents
+ * in FSAL sorted order (for FSALs that compute readdir cookies) are
+ * still kept in an AVL tree since that order needs neighbour lookups.
  *
  */
 
@@ -57,40 +59,6 @@
 #include "mdcache_int.h"
 #include "avltree.h"
 
-static inline int avl_dirent_name_cmpf(const struct avltree_node *lhs,
-				       const struct avltree_node *rhs)
-{
-	mdcache_dir_entry_t *lk, *rk;
-
-	lk = avltree_container_of(lhs, mdcache_dir_entry_t, node_name);
-	rk = avltree_container_of(rhs, mdcache_dir_entry_t, node_name);
-
-	if (lk->namehash < rk->namehash)
-		return -1;
-
-	if (lk->namehash > rk->namehash)
-		return 1;
-
-	return strcmp(lk->name, rk->name);
-}
-
-static inline int avl_dirent_ck_cmpf(const struct avltree_node *lhs,
-				     const struct avltree_node *rhs)
-{
-	mdcache_dir_entry_t *lk, *rk;
-
-	lk = avltree_container_of(lhs, mdcache_dir_entry_t, node_ck);
-	rk = avltree_container_of(rhs, mdcache_dir_entry_t, node_ck);
-
-	if (lk->ck < rk->ck)
-		return -1;
-
-	if (lk->ck == rk->ck)
-		return 0;
-
-	return 1;
-}
-
 static inline int avl_dirent_sorted_cmpf(const struct avltree_node *lhs,
 					 const struct avltree_node *rhs)
 {
@@ -119,17 +87,20 @@ static inline int avl_dirent_sorted_cmpf(const struct avltree_node *lhs,
 	return rc;
 }
 
-void mdcache_avl_remove(mdcache_entry_t *parent, mdcache_dir_entry_t *dirent);
-void avl_dirent_set_deleted(mdcache_entry_t *entry, mdcache_dir_entry_t *v);
-void mdcache_avl_init(mdcache_entry_t *entry);
-int mdcache_avl_insert(mdcache_entry_t *entry, mdcache_dir_entry_t **dirent);
-int mdcache_avl_insert_ck(mdcache_entry_t *entry, mdcache_dir_entry_t *v);
+void mdc_dirents_remove(mdcache_entry_t *parent, mdcache_dir_entry_t *dirent);
+void mdc_dirent_set_deleted(mdcache_entry_t *entry, mdcache_dir_entry_t *v);
+void mdc_dirents_init(mdcache_entry_t *entry);
+void mdc_dirents_fini(mdcache_entry_t *entry);
+int mdc_dirents_insert(mdcache_entry_t *entry, mdcache_dir_entry_t **dirent);
+int mdc_dirents_insert_ck(mdcache_entry_t *entry, mdcache_dir_entry_t *v);
+void mdc_dirents_rekey_ck(mdcache_entry_t *entry, mdcache_dir_entry_t *v,
+			  uint64_t ck);
 
-bool mdcache_avl_lookup_ck(mdcache_entry_t *entry, uint64_t ck,
+bool mdc_dirents_lookup_ck(mdcache_entry_t *entry, uint64_t ck,
 			   mdcache_dir_entry_t **dirent);
-mdcache_dir_entry_t *mdcache_avl_lookup(mdcache_entry_t *entry,
+mdcache_dir_entry_t *mdc_dirents_lookup(mdcache_entry_t *entry,
 					const char *name);
-void mdcache_avl_clean_trees(mdcache_entry_t *parent);
+void mdc_dirents_clean(mdcache_entry_t *parent);
 
 void unchunk_dirent(mdcache_dir_entry_t *dirent);
 #endif				/* MDCACHE_AVL_H */
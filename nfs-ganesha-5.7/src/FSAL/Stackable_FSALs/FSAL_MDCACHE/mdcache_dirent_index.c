@@ -0,0 +1,177 @@
+// SPDX-License-Identifier: LGPL-3.0-or-later
+/*
+ * vim:noexpandtab:shiftwidth=8:tabstop=8:
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 3 of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA
+ * 02110-1301 USA
+ *
+ * -------------
+ */
+
+/**
+ * @addtogroup FSAL_MDCACHE
+ * @{
+ */
+
+/**
+ * @file mdcache_dirent_index.c
+ * @brief Open addressing index of the dirents of a directory
+ */
+
+#include "config.h"
+#include "abstract_mem.h"
+#include "mdcache_dirent_index.h"
+
+/* Initial capacity of a dirent index, must be a power of 2 */
+#define MDC_IDX_MIN_SLOTS 16
+
+static void mdc_idx_put(struct mdc_dirent_index *idx, uint64_t key,
+			struct mdcache_dir_entry__ *dirent)
+{
+	uint32_t i = mdc_dirent_index_home(idx, key);
+
+	while (idx->slots[i].dirent != NULL)
+		i = (i + 1) & idx->mask;
+
+	idx->slots[i].key = key;
+	idx->slots[i].dirent = dirent;
+	idx->count++;
+}
+
+/**
+ * @brief Double the capacity of an index, keeping the load under 3/4
+ */
+static void mdc_idx_grow(struct mdc_dirent_index *idx)
+{
+	struct mdc_dirent_slot *old = idx->slots;
+	uint32_t old_slots = old != NULL ? idx->mask + 1 : 0;
+	uint32_t nslots = old_slots != 0 ? old_slots * 2 : MDC_IDX_MIN_SLOTS;
+	uint32_t i;
+
+	idx->slots = gsh_calloc(nslots, sizeof(*idx->slots));
+	idx->mask = nslots - 1;
+	idx->count = 0;
+
+	for (i = 0; i < old_slots; i++) {
+		if (old[i].dirent != NULL)
+			mdc_idx_put(idx, old[i].key, old[i].dirent);
+	}
+
+	gsh_free(old);
+}
+
+/**
+ * @brief Add a dirent to an index
+ *
+ * @param[in] idx	The index
+ * @param[in] key	Key of the dirent, need not be unique
+ * @param[in] dirent	The dirent
+ */
+void mdc_dirent_index_insert(struct mdc_dirent_index *idx, uint64_t key,
+			     struct mdcache_dir_entry__ *dirent)
+{
+	if (idx->slots == NULL || (idx->count + 1) * 4 > (idx->mask + 1) * 3)
+		mdc_idx_grow(idx);
+
+	mdc_idx_put(idx, key, dirent);
+}
+
+/**
+ * @brief Remove a dirent from an index
+ *
+ * Entries following the freed slot in its probe run are shifted back so
+ * that no tombstones are needed.
+ *
+ * @param[in] idx	The index
+ * @param[in] key	Key the dirent was inserted with
+ * @param[in] dirent	The dirent
+ *
+ * @return true if the dirent was found and removed.
+ */
+bool mdc_dirent_index_remove(struct mdc_dirent_index *idx, uint64_t key,
+			     struct mdcache_dir_entry__ *dirent)
+{
+	uint32_t i, j, home;
+
+	if (idx->slots == NULL)
+		return false;
+
+	for (i = mdc_dirent_index_home(idx, key);
+	     idx->slots[i].dirent != dirent;
+	     i = (i + 1) & idx->mask) {
+		if (idx->slots[i].dirent == NULL)
+			return false;
+	}
+
+	for (j = (i + 1) & idx->mask; idx->slots[j].dirent != NULL;
+	     j = (j + 1) & idx->mask) {
+		home = mdc_dirent_index_home(idx, idx->slots[j].key);
+
+		/* Leave the slot alone if its home lies cyclically in
+		 * (i, j], the hole does not break its probe run.
+		 */
+		if (((j - home) & idx->mask) < ((j - i) & idx->mask))
+			continue;
+
+		idx->slots[i] = idx->slots[j];
+		i = j;
+	}
+
+	idx->slots[i].dirent = NULL;
+	idx->count--;
+	return true;
+}
+
+/**
+ * @brief Find the first dirent with a key
+ *
+ * @param[in] idx	The index
+ * @param[in] key	Key to look for
+ *
+ * @return The dirent, or NULL if there is none.
+ */
+struct mdcache_dir_entry__ *
+mdc_dirent_index_lookup(const struct mdc_dirent_index *idx, uint64_t key)
+{
+	uint32_t i;
+
+	if (idx->slots == NULL)
+		return NULL;
+
+	for (i = mdc_dirent_index_home(idx, key); idx->slots[i].dirent != NULL;
+	     i = (i + 1) & idx->mask) {
+		if (idx->slots[i].key == key)
+			return idx->slots[i].dirent;
+	}
+
+	return NULL;
+}
+
+/**
+ * @brief Release the storage of an index
+ *
+ * Any dirents still in it are dropped, not freed.
+ *
+ * @param[in] idx	The index
+ */
+void mdc_dirent_index_free(struct mdc_dirent_index *idx)
+{
+	gsh_free(idx->slots);
+	idx->slots = NULL;
+	idx->mask = 0;
+	idx->count = 0;
+}
+
+/** @} */
@@ -0,0 +1,88 @@
+/* SPDX-License-Identifier: LGPL-3.0-or-later */
+/*
+ * vim:noexpandtab:shiftwidth=8:tabstop=8:
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 3 of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA
+ * 02110-1301 USA
+ *
+ * -------------
+ */
+
+/**
+ * @addtogroup FSAL_MDCACHE
+ * @{
+ */
+
+/**
+ * @file mdcache_dirent_index.h
+ * @brief Open addressing index of the dirents of a directory
+ *
+ * Linear probing table of (key, dirent) pairs with a power of two
+ * capacity.  A probe sequence walks adjacent slots, so a lookup usually
+ * touches one or two cache lines rather than one node per tree level.
+ * Empty slots have a NULL dirent.  Deletion shifts the rest of the probe
+ * run back, so no tombstones are needed.  Several dirents may share a key;
+ * callers that need more than the first match walk the probe run from
+ * mdc_dirent_index_home() themselves.
+ *
+ * The index does no locking, a directory's indexes are protected by its
+ * content_lock.
+ */
+
+#ifndef MDCACHE_DIRENT_INDEX_H
+#define MDCACHE_DIRENT_INDEX_H
+
+#include <stdbool.h>
+#include <stdint.h>
+
+struct mdcache_dir_entry__;
+
+struct mdc_dirent_slot {
+	uint64_t key;
+	struct mdcache_dir_entry__ *dirent;
+};
+
+struct mdc_dirent_index {
+	/** Slot array, NULL until the first insert */
+	struct mdc_dirent_slot *slots;
+	/** Capacity - 1 */
+	uint32_t mask;
+	/** Number of occupied slots */
+	uint32_t count;
+};
+
+/**
+ * @brief Compute the home slot of a key
+ *
+ * Cookies are frequently small or sequential, so spread all keys with a
+ * multiplicative hash before masking.
+ */
+static inline uint32_t mdc_dirent_index_home(const struct mdc_dirent_index *idx,
+					     uint64_t key)
+{
+	return ((key * 0x9E3779B97F4A7C15ULL) >> 32) & idx->mask;
+}
+
+void mdc_dirent_index_insert(struct mdc_dirent_index *idx, uint64_t key,
+			     struct mdcache_dir_entry__ *dirent);
+bool mdc_dirent_index_remove(struct mdc_dirent_index *idx, uint64_t key,
+			     struct mdcache_dir_entry__ *dirent);
+struct mdcache_dir_entry__ *
+mdc_dirent_index_lookup(const struct mdc_dirent_index *idx, uint64_t key);
+void mdc_dirent_index_free(struct mdc_dirent_index *idx);
+
+#endif				/* MDCACHE_DIRENT_INDEX_H */
+
+/** @} */
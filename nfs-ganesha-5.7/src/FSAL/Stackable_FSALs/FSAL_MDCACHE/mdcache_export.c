@@ -101,6 +101,12 @@ static void mdcache_unexport(struct fsal_export *exp_hdl,
 	 */
 	atomic_set_uint8_t_bits(&exp->flags, MDC_UNEXPORT);
 
+	/* Save the cached handles for a warm restart, if configured.  The
+	 * periodic saves are stopped first so they don't race with this one.
+	 */
+	mdcache_snapshot_stop(exp);
+	mdcache_snapshot_save(exp);
+
 	/* Next, clean up our cache entries on the export */
 	while (true) {
 		PTHREAD_RWLOCK_rdlock(&exp->mdc_exp_lock);
@@ -126,9 +132,9 @@ static void mdcache_unexport(struct fsal_export *exp_hdl,
 				 entry);
 		}
 
-		/* Get a ref across cleanup.  This must be an initial ref, so
-		 * that it takes the LRU lane lock, keeping it from racing with
-		 * lru_lane_run() */
+		/* Get an active ref across cleanup.  While it is held the
+		 * reaper can not reclaim the entry, and lru_run_lane() leaves
+		 * it on (or moves it to) ACTIVE. */
 		mdcache_lru_ref(entry, LRU_ACTIVE_REF | LRU_PROMOTE);
 		PTHREAD_RWLOCK_unlock(&exp->mdc_exp_lock);
 
@@ -311,8 +317,9 @@ static void mdcache_exp_release(struct fsal_export *exp_hdl)
 		fsal_hdl->name, op_ctx->ctx_export->export_id,
 		ctx_export_path(op_ctx));
 
-	/* Stop the dirmap thread */
+	/* Stop the dirmap and snapshot threads */
 	dirmap_lru_stop(exp);
+	mdcache_snapshot_stop(exp);
 
 	/* Release the sub_export */
 	subcall_shutdown_raw(exp,
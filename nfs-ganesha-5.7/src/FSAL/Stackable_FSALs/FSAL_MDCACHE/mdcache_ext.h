@@ -129,6 +129,26 @@ struct mdcache_parameter {
 	/** High water mark for dirent mapping entries.  Defaults to 10000,
 	    settable by Dirmap_HWMark. */
 	uint32_t dirmap_hwmark;
+	/** Directory in which a per-export snapshot of the cached handles
+	    is written periodically and on unexport, and read back to warm
+	    the cache when the export is created again.  Unset (the default)
+	    disables snapshots.  Settable with Snapshot_Dir. */
+	char *snapshot_dir;
+	/** Maximum number of handles saved per export.  Defaults to
+	    100000, settable with Snapshot_Max_Entries. */
+	uint32_t snapshot_max_entries;
+	/** Seconds between snapshots of a running export, 0 to only
+	    save on unexport.  Defaults to 300, settable with
+	    Snapshot_Interval. */
+	uint32_t snapshot_interval;
+	/** Handles looked up per second when warming from a snapshot,
+	    0 for no limit.  Defaults to 1000, settable with
+	    Snapshot_Load_Rate. */
+	uint32_t snapshot_load_rate;
+	/** Whether active entries keep the wire encoding of their
+	    attributes for repeated GETATTRs.  Defaults to true,
+	    settable with Cache_Encoded_Attrs. */
+	bool cache_encoded_attrs;
 };
 
 extern struct mdcache_parameter mdcache_param;
@@ -914,3 +914,99 @@ fsal_status_t mdcache_fallocate(struct fsal_obj_handle *obj_hdl,
 
 	return status;
 }
+
+/**
+ * @brief Copy a range of bytes between two files
+ *
+ * Pass through to the sub-FSAL, then invalidate the destination
+ * attributes.
+ *
+ * @param[in]  src_hdl     File to copy from
+ * @param[in]  src_state   state_t to use to read the source (or NULL)
+ * @param[in]  src_offset  Offset in the source
+ * @param[in]  dst_hdl     File to copy to
+ * @param[in]  dst_state   state_t to use to write the destination (or NULL)
+ * @param[in]  dst_offset  Offset in the destination
+ * @param[in]  count       Number of bytes to copy
+ * @param[out] copied      Number of bytes copied
+ *
+ * @return FSAL status.
+ */
+fsal_status_t mdcache_copy(struct fsal_obj_handle *src_hdl,
+			   struct state_t *src_state, uint64_t src_offset,
+			   struct fsal_obj_handle *dst_hdl,
+			   struct state_t *dst_state, uint64_t dst_offset,
+			   uint64_t count, uint64_t *copied)
+{
+	mdcache_entry_t *src =
+		container_of(src_hdl, mdcache_entry_t, obj_handle);
+	mdcache_entry_t *dst =
+		container_of(dst_hdl, mdcache_entry_t, obj_handle);
+	fsal_status_t status;
+
+	subcall(
+		status = src->sub_handle->obj_ops->copy(src->sub_handle,
+							src_state, src_offset,
+							dst->sub_handle,
+							dst_state, dst_offset,
+							count, copied)
+	       );
+
+	if (status.major == ERR_FSAL_STALE) {
+		mdcache_kill_entry(src);
+		mdcache_kill_entry(dst);
+	} else {
+		atomic_clear_uint32_t_bits(&dst->mde_flags,
+					   MDCACHE_TRUST_ATTRS);
+	}
+
+	return status;
+}
+
+/**
+ * @brief Clone a range of bytes between two files
+ *
+ * Pass through to the sub-FSAL; a clone that worked invalidates the
+ * destination attributes.
+ *
+ * @param[in] src_hdl     File to clone from
+ * @param[in] src_state   state_t to use to read the source (or NULL)
+ * @param[in] src_offset  Offset in the source
+ * @param[in] dst_hdl     File to clone to
+ * @param[in] dst_state   state_t to use to write the destination (or NULL)
+ * @param[in] dst_offset  Offset in the destination
+ * @param[in] count       Number of bytes to clone
+ *
+ * @return FSAL status.
+ */
+fsal_status_t mdcache_clone(struct fsal_obj_handle *src_hdl,
+			    struct state_t *src_state, uint64_t src_offset,
+			    struct fsal_obj_handle *dst_hdl,
+			    struct state_t *dst_state, uint64_t dst_offset,
+			    uint64_t count)
+{
+	mdcache_entry_t *src =
+		container_of(src_hdl, mdcache_entry_t, obj_handle);
+	mdcache_entry_t *dst =
+		container_of(dst_hdl, mdcache_entry_t, obj_handle);
+	fsal_status_t status;
+
+	subcall(
+		status = src->sub_handle->obj_ops->clone(src->sub_handle,
+							 src_state,
+							 src_offset,
+							 dst->sub_handle,
+							 dst_state,
+							 dst_offset, count)
+	       );
+
+	if (status.major == ERR_FSAL_STALE) {
+		mdcache_kill_entry(src);
+		mdcache_kill_entry(dst);
+	} else if (!FSAL_IS_ERROR(status)) {
+		atomic_clear_uint32_t_bits(&dst->mde_flags,
+					   MDCACHE_TRUST_ATTRS);
+	}
+
+	return status;
+}
@@ -554,7 +554,8 @@ static fsal_status_t mdcache_readdir(struct fsal_obj_handle *dir_hdl,
 	if (mdcache_param.dir.avl_chunk == 0) {
 		/* Not caching dirents; pass through directly to FSAL */
 		return mdcache_readdir_uncached(directory, whence, dir_state,
-						cb, attrmask, eod_met);
+						cb, attrmask & ~ATTR_DIRENT_ONLY,
+						eod_met);
 	} else {
 		/* Dirent chunking is enabled. */
 		LogDebugAlt(COMPONENT_NFS_READDIR, COMPONENT_MDCACHE,
@@ -789,7 +790,7 @@ out:
 		 */
 		if (mdc_olddir != mdc_newdir && obj_hdl->type == DIRECTORY) {
 			PTHREAD_RWLOCK_wrlock(&mdc_obj->content_lock);
-			mdcache_free_fh(&mdc_obj->fsobj.fsdir.parent);
+			mdcache_free_fh(&mdc_obj->fsobj.fsdir->parent);
 			PTHREAD_RWLOCK_unlock(&mdc_obj->content_lock);
 		}
 
@@ -1153,7 +1154,7 @@ static fsal_status_t mdcache_unlink(struct fsal_obj_handle *dir_hdl,
 
 		if (entry->obj_handle.type == DIRECTORY) {
 			PTHREAD_RWLOCK_wrlock(&entry->content_lock);
-			mdcache_free_fh(&entry->fsobj.fsdir.parent);
+			mdcache_free_fh(&entry->fsobj.fsdir->parent);
 			PTHREAD_RWLOCK_unlock(&entry->content_lock);
 		}
 
@@ -1497,6 +1498,101 @@ out:
 	return result;
 }
 
+/**
+ * @brief Look up a cached encoding of the attributes
+ *
+ * @param[in]  obj_hdl	Handle on which to operate
+ * @param[in]  key	Caller defined key
+ * @param[out] val	Copy of the encoding
+ *
+ * @return true if an encoding was found
+ */
+static bool mdcache_encoded_attrs_get(struct fsal_obj_handle *obj_hdl,
+				      const struct gsh_buffdesc *key,
+				      struct gsh_buffdesc *val)
+{
+	mdcache_entry_t *entry =
+		container_of(obj_hdl, mdcache_entry_t, obj_handle);
+	struct mdc_encoded_attrs *enc;
+	bool found = false;
+	int i;
+
+	if (!mdcache_param.cache_encoded_attrs)
+		return false;
+
+	PTHREAD_RWLOCK_rdlock(&entry->attr_lock);
+
+	for (i = 0; i < MDC_ENCODED_ATTRS; i++) {
+		enc = entry->enc_attrs[i];
+
+		if (enc == NULL || enc->key_len != key->len ||
+		    memcmp(enc->data, key->addr, key->len) != 0)
+			continue;
+
+		val->len = enc->val_len;
+		val->addr = gsh_malloc(enc->val_len);
+		memcpy(val->addr, enc->data + enc->key_len, enc->val_len);
+		found = true;
+		break;
+	}
+
+	PTHREAD_RWLOCK_unlock(&entry->attr_lock);
+
+	return found;
+}
+
+/**
+ * @brief Keep an encoding of the attributes
+ *
+ * Only entries that were ever promoted (the ones that go to L1) keep
+ * encodings; entries only seen in a directory scan are not worth the
+ * memory.  A slot with the same key is replaced, otherwise slots are
+ * reused round robin.
+ *
+ * @param[in] obj_hdl	Handle on which to operate
+ * @param[in] key	Caller defined key
+ * @param[in] val	The encoding
+ */
+static void mdcache_encoded_attrs_put(struct fsal_obj_handle *obj_hdl,
+				      const struct gsh_buffdesc *key,
+				      const struct gsh_buffdesc *val)
+{
+	mdcache_entry_t *entry =
+		container_of(obj_hdl, mdcache_entry_t, obj_handle);
+	struct mdc_encoded_attrs *enc, *old;
+	int i;
+
+	if (!mdcache_param.cache_encoded_attrs ||
+	    !(atomic_fetch_uint32_t(&entry->lru.flags) & LRU_EVER_PROMOTED))
+		return;
+
+	enc = gsh_malloc(sizeof(*enc) + key->len + val->len);
+	enc->key_len = key->len;
+	enc->val_len = val->len;
+	memcpy(enc->data, key->addr, key->len);
+	memcpy(enc->data + key->len, val->addr, val->len);
+
+	PTHREAD_RWLOCK_wrlock(&entry->attr_lock);
+
+	for (i = 0; i < MDC_ENCODED_ATTRS; i++) {
+		old = entry->enc_attrs[i];
+
+		if (old != NULL && old->key_len == key->len &&
+		    memcmp(old->data, key->addr, key->len) == 0)
+			break;
+	}
+
+	if (i == MDC_ENCODED_ATTRS)
+		i = entry->enc_attrs_next++ % MDC_ENCODED_ATTRS;
+
+	old = entry->enc_attrs[i];
+	entry->enc_attrs[i] = enc;
+
+	PTHREAD_RWLOCK_unlock(&entry->attr_lock);
+
+	gsh_free(old);
+}
+
 void mdcache_handle_ops_init(struct fsal_obj_ops *ops)
 {
 	fsal_default_obj_ops_init(ops);
@@ -1542,6 +1638,8 @@ void mdcache_handle_ops_init(struct fsal_obj_ops *ops)
 	ops->setattr2 = mdcache_setattr2;
 	ops->close2 = mdcache_close2;
 	ops->fallocate = mdcache_fallocate;
+	ops->copy = mdcache_copy;
+	ops->clone = mdcache_clone;
 
 	/* xattr related functions */
 	ops->list_ext_attrs = mdcache_list_ext_attrs;
@@ -1558,6 +1656,8 @@ void mdcache_handle_ops_init(struct fsal_obj_ops *ops)
 	ops->listxattrs = mdcache_listxattrs;
 
 	ops->is_referral = mdcache_is_referral;
+	ops->encoded_attrs_get = mdcache_encoded_attrs_get;
+	ops->encoded_attrs_put = mdcache_encoded_attrs_put;
 }
 
 /*
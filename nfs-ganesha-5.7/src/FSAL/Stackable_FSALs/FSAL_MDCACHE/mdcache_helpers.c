@@ -118,7 +118,7 @@ static inline void add_detached_dirent(mdcache_entry_t *parent,
 #ifdef DEBUG_MDCACHE
 	assert(parent->content_lock.__data.__cur_writer);
 #endif
-	if (parent->fsobj.fsdir.detached_count ==
+	if (parent->fsobj.fsdir->detached_count ==
 	    mdcache_param.dir.avl_detached_max) {
 		/* Need to age out oldest detached dirent. */
 		mdcache_dir_entry_t *removed;
@@ -128,25 +128,25 @@ static inline void add_detached_dirent(mdcache_entry_t *parent,
 		 * Technically we don't need it since the content lock is held
 		 * for write, there can be no conflicting threads. Since we
 		 * don't have a racing thread, it's ok that the list is
-		 * unprotected by spin lock while we make the AVL call.
+		 * unprotected by spin lock while we remove the dirent.
 		 */
-		PTHREAD_SPIN_lock(&parent->fsobj.fsdir.fsd_spin);
+		PTHREAD_SPIN_lock(&parent->fsobj.fsdir->fsd_spin);
 
-		removed = glist_last_entry(&parent->fsobj.fsdir.detached,
+		removed = glist_last_entry(&parent->fsobj.fsdir->detached,
 					   mdcache_dir_entry_t,
 					   chunk_list);
 
-		PTHREAD_SPIN_unlock(&parent->fsobj.fsdir.fsd_spin);
+		PTHREAD_SPIN_unlock(&parent->fsobj.fsdir->fsd_spin);
 
 		/* Remove from active names tree */
-		mdcache_avl_remove(parent, removed);
+		mdc_dirents_remove(parent, removed);
 	}
 
 	/* Add new entry to MRU (head) of list */
-	PTHREAD_SPIN_lock(&parent->fsobj.fsdir.fsd_spin);
-	glist_add(&parent->fsobj.fsdir.detached, &dirent->chunk_list);
-	parent->fsobj.fsdir.detached_count++;
-	PTHREAD_SPIN_unlock(&parent->fsobj.fsdir.fsd_spin);
+	PTHREAD_SPIN_lock(&parent->fsobj.fsdir->fsd_spin);
+	glist_add(&parent->fsobj.fsdir->detached, &dirent->chunk_list);
+	parent->fsobj.fsdir->detached_count++;
+	PTHREAD_SPIN_unlock(&parent->fsobj.fsdir->fsd_spin);
 }
 
 /**
@@ -195,14 +195,15 @@ static mdcache_entry_t *mdcache_alloc_handle(
 	result->obj_handle.obj_ops = &MDCACHE.handle_ops;
 	/* state */
 	if (sub_handle->type == DIRECTORY) {
-		result->obj_handle.state_hdl = &result->fsobj.fsdir.dhdl;
-		/* init avl tree */
-		mdcache_avl_init(result);
+		result->fsobj.fsdir = gsh_calloc(1, sizeof(struct mdcache_fsdir));
+		result->obj_handle.state_hdl = &result->fsobj.fsdir->dhdl;
+		/* init dirent indexes */
+		mdc_dirents_init(result);
 
 		/* init chunk list and detached dirents list */
-		glist_init(&result->fsobj.fsdir.chunks);
-		glist_init(&result->fsobj.fsdir.detached);
-		PTHREAD_SPIN_init(&result->fsobj.fsdir.fsd_spin,
+		glist_init(&result->fsobj.fsdir->chunks);
+		glist_init(&result->fsobj.fsdir->detached);
+		PTHREAD_SPIN_init(&result->fsobj.fsdir->fsd_spin,
 				  PTHREAD_PROCESS_PRIVATE);
 	} else {
 		result->obj_handle.state_hdl = &result->fsobj.hdl;
@@ -309,7 +310,7 @@ void mdc_clean_entry(mdcache_entry_t *entry)
 		/* Clean up dirents */
 		mdcache_dirent_invalidate_all(entry);
 		/* Clean up parent key */
-		mdcache_free_fh(&entry->fsobj.fsdir.parent);
+		mdcache_free_fh(&entry->fsobj.fsdir->parent);
 
 		PTHREAD_RWLOCK_unlock(&entry->content_lock);
 	}
@@ -440,15 +441,15 @@ mdc_get_parent_handle(struct mdcache_fsal_export *export,
 		return status;
 
 	/* And store in the parent host-handle */
-	mdcache_copy_fh(&entry->fsobj.fsdir.parent, &fh_desc);
+	mdcache_copy_fh(&entry->fsobj.fsdir->parent, &fh_desc);
 
 	expire_time_parent = op_ctx->fsal_export->exp_ops.fs_expiretimeparent(
 							op_ctx->fsal_export);
 	if (expire_time_parent != -1)
-		entry->fsobj.fsdir.parent_time = time(NULL) +
+		entry->fsobj.fsdir->parent_time = time(NULL) +
 						 expire_time_parent;
 	else
-		entry->fsobj.fsdir.parent_time = 0;
+		entry->fsobj.fsdir->parent_time = 0;
 
 	return fsalstat(ERR_FSAL_NO_ERROR, 0);
 }
@@ -488,9 +489,9 @@ mdc_get_parent(struct mdcache_fsal_export *export, mdcache_entry_t *entry,
 		}
 	}
 
-	if (entry->fsobj.fsdir.parent.len != 0) {
+	if (entry->fsobj.fsdir->parent.len != 0) {
 		/* Already has a parent pointer */
-		if (entry->fsobj.fsdir.parent_time == 0 ||
+		if (entry->fsobj.fsdir->parent_time == 0 ||
 		    mdcache_is_parent_valid(entry)) {
 			goto copy_parent_out;
 		}
@@ -505,9 +506,9 @@ mdc_get_parent(struct mdcache_fsal_export *export, mdcache_entry_t *entry,
 		/* if we already had a parent handle, then we are
 		 * going to refresh it.
 		 */
-		mdcache_free_fh(&entry->fsobj.fsdir.parent);
+		mdcache_free_fh(&entry->fsobj.fsdir->parent);
 		mdc_get_parent_handle(export, entry, sub_handle);
-	} else if (entry->fsobj.fsdir.parent.len != 0) {
+	} else if (entry->fsobj.fsdir->parent.len != 0) {
 		/* Lookup of (..) failed, but if we had a cached
 		 * parent handle then we will keep the same and
 		 * not fail this request for getting parent.
@@ -522,7 +523,7 @@ mdc_get_parent(struct mdcache_fsal_export *export, mdcache_entry_t *entry,
 copy_parent_out:
 	if (parent_out != NULL) {
 		/* Copy the parent handle to parent_out */
-		mdcache_copy_fh(parent_out, &entry->fsobj.fsdir.parent);
+		mdcache_copy_fh(parent_out, &entry->fsobj.fsdir->parent);
 	}
 
 out:
@@ -561,7 +562,7 @@ void mdcache_clean_dirent_chunk(struct dir_chunk *chunk)
 		dirent = glist_entry(glist, mdcache_dir_entry_t, chunk_list);
 
 		/* Remove from deleted or active names tree */
-		mdcache_avl_remove(parent, dirent);
+		mdc_dirents_remove(parent, dirent);
 	}
 
 	/* Remove chunk from directory. */
@@ -600,7 +601,7 @@ void mdcache_clean_dirent_chunks(mdcache_entry_t *entry)
 #ifdef DEBUG_MDCACHE
 	assert(entry->content_lock.__data.__cur_writer);
 #endif
-	glist_for_each_safe(glist, glistn, &entry->fsobj.fsdir.chunks) {
+	glist_for_each_safe(glist, glistn, &entry->fsobj.fsdir->chunks) {
 		mdcache_lru_unref_chunk(glist_entry(glist, struct dir_chunk,
 						    chunks));
 	}
@@ -629,7 +630,7 @@ void mdcache_dirent_invalidate_all(mdcache_entry_t *entry)
 	mdcache_clean_dirent_chunks(entry);
 
 	/* Clean the active and deleted trees */
-	mdcache_avl_clean_trees(entry);
+	mdc_dirents_clean(entry);
 
 	atomic_clear_uint32_t_bits(&entry->mde_flags, MDCACHE_DIR_POPULATED);
 
@@ -1184,7 +1185,7 @@ fsal_status_t mdc_try_get_cached(mdcache_entry_t *mdc_parent,
 	if (!test_mde_flags(mdc_parent, MDCACHE_TRUST_CONTENT))
 		return fsalstat(ERR_FSAL_STALE, 0);
 
-	dirent = mdcache_avl_lookup(mdc_parent, name);
+	dirent = mdc_dirents_lookup(mdc_parent, name);
 	if (dirent) {
 		if (dirent->chunk != NULL) {
 			/* Bump the chunk in the LRU */
@@ -1203,7 +1204,7 @@ fsal_status_t mdc_try_get_cached(mdcache_entry_t *mdc_parent,
 				name, fsal_err_txt(status));
 	} else {	/* ! dirent */
 		LogFullDebugAlt(COMPONENT_NFS_READDIR, COMPONENT_MDCACHE,
-				"mdcache_avl_lookup %s failed trust negative %s",
+				"mdc_dirents_lookup %s failed trust negative %s",
 				name,
 				trust_negative_cache(mdc_parent)
 					? "yes" : "no");
@@ -1581,9 +1582,11 @@ mdcache_dirent_add(mdcache_entry_t *parent, const char *name,
 	memcpy(&new_dir_entry->name_buffer, name, namesize);
 	new_dir_entry->name = new_dir_entry->name_buffer;
 	mdcache_key_dup(&new_dir_entry->ckey, &entry->fh_hk.key);
+	new_dir_entry->type = entry->obj_handle.type;
+	new_dir_entry->fileid = entry->obj_handle.fileid;
 
 	/* add to avl */
-	code = mdcache_avl_insert(parent, &new_dir_entry);
+	code = mdc_dirents_insert(parent, &new_dir_entry);
 	if (code < 0) {
 		/** @todo: maybe we should actually invalidate the dirent cache
 		 *         at this point?
@@ -1628,16 +1631,16 @@ void mdcache_dirent_remove(mdcache_entry_t *parent, const char *name)
 	/* Don't remove if we aren't doing dirent caching or the cache is empty
 	 */
 	if (mdcache_param.dir.avl_chunk != 0 &&
-	    avltree_size(&parent->fsobj.fsdir.avl.t) != 0) {
+	    parent->fsobj.fsdir->dirents.by_name.count != 0) {
 		mdcache_dir_entry_t *dirent;
 
 		LogFullDebugAlt(COMPONENT_NFS_READDIR, COMPONENT_MDCACHE,
 				"Remove dir entry %s", name);
 
-		dirent = mdcache_avl_lookup(parent, name);
+		dirent = mdc_dirents_lookup(parent, name);
 
 		if (dirent != NULL)
-			avl_dirent_set_deleted(parent, dirent);
+			mdc_dirent_set_deleted(parent, dirent);
 	}
 }
 
@@ -1827,7 +1830,7 @@ void place_new_dirent(mdcache_entry_t *parent_dir,
 	new_dir_entry->ck = ck;
 
 	node = avltree_do_lookup(&new_dir_entry->node_sorted,
-				 &parent_dir->fsobj.fsdir.avl.sorted,
+				 &parent_dir->fsobj.fsdir->dirents.sorted,
 				 &parent, &unbalanced, &is_left,
 				 avl_dirent_sorted_cmpf);
 
@@ -1880,7 +1883,7 @@ void place_new_dirent(mdcache_entry_t *parent_dir,
 			 * will leave room to insert the new entry with cookie
 			 * of FIRST_COOKIE.
 			 */
-			right->ck = nck;
+			mdc_dirents_rekey_ck(parent_dir, right, nck);
 		} else {
 			/* This should not happen... Let's no longer trust the
 			 * chunks.
@@ -1920,7 +1923,7 @@ void place_new_dirent(mdcache_entry_t *parent_dir,
 		} else {
 			left = NULL;
 
-			if (parent_dir->fsobj.fsdir.first_ck == right->ck) {
+			if (parent_dir->fsobj.fsdir->first_ck == right->ck) {
 				/* The right node is the first entry in the
 				 * directory. Add this key to the beginning of
 				 * the first chunk and fixup the chunk.
@@ -1966,7 +1969,7 @@ void place_new_dirent(mdcache_entry_t *parent_dir,
 		} else {
 			right = NULL;
 
-			if (left->eod) {
+			if (left->flags & DIR_ENTRY_EOD) {
 				/* The right node is the last entry in the
 				 * directory. Add this key to the end of the
 				 * last chunk and fixup the chunk.
@@ -2001,7 +2004,7 @@ void place_new_dirent(mdcache_entry_t *parent_dir,
 	/* Note in the following, every dirent that is in the sorted tree MUST
 	 * be in a chunk, so we don't check for chunk != NULL.
 	 */
-	/* Set up to add to chunk and by cookie AVL tree. */
+	/* Set up to add to chunk and by cookie index. */
 	if (right == NULL) {
 		/* Will go at end of left chunk. */
 		chunk = new_dir_entry->chunk = left->chunk;
@@ -2010,10 +2013,10 @@ void place_new_dirent(mdcache_entry_t *parent_dir,
 		chunk = new_dir_entry->chunk = right->chunk;
 	}
 
-	code = mdcache_avl_insert_ck(parent_dir, new_dir_entry);
+	code = mdc_dirents_insert_ck(parent_dir, new_dir_entry);
 
 	if (code < 0) {
-		/* We failed to insert into FSAL cookie AVL tree, will fail.
+		/* We failed to insert into FSAL cookie index, will fail.
 		 * Nothing to clean up since we haven't done anything
 		 * unreversible, and we no longer trust the chunks.
 		 */
@@ -2022,7 +2025,7 @@ void place_new_dirent(mdcache_entry_t *parent_dir,
 
 	/* Get the node into the actual tree... */
 	avltree_do_insert(&new_dir_entry->node_sorted,
-			  &parent_dir->fsobj.fsdir.avl.sorted,
+			  &parent_dir->fsobj.fsdir->dirents.sorted,
 			  parent, unbalanced, is_left);
 
 	LogFullDebugAlt(COMPONENT_NFS_READDIR, COMPONENT_MDCACHE,
@@ -2045,8 +2048,8 @@ void place_new_dirent(mdcache_entry_t *parent_dir,
 			       &new_dir_entry->chunk_list);
 
 		/* Make the new entry the eod entry. */
-		new_dir_entry->eod = true;
-		left->eod = false;
+		new_dir_entry->flags |= DIR_ENTRY_EOD;
+		left->flags &= ~DIR_ENTRY_EOD;
 	} else {
 		/* Insert to left of right, which if left and right are
 		 * different chunks, inserts into the right hand chunk.
@@ -2074,7 +2077,7 @@ void place_new_dirent(mdcache_entry_t *parent_dir,
 					COMPONENT_MDCACHE,
 					"Setting directory first_ck=%"PRIx64,
 					new_dir_entry->ck);
-			parent_dir->fsobj.fsdir.first_ck = new_dir_entry->ck;
+			parent_dir->fsobj.fsdir->first_ck = new_dir_entry->ck;
 		}
 	}
 
@@ -2269,9 +2272,11 @@ mdc_readdir_chunk_object(const char *name, struct fsal_obj_handle *sub_handle,
 	memcpy(&new_dir_entry->name_buffer, name, namesize);
 	new_dir_entry->name = new_dir_entry->name_buffer;
 	mdcache_key_dup(&new_dir_entry->ckey, &new_entry->fh_hk.key);
+	new_dir_entry->type = new_entry->obj_handle.type;
+	new_dir_entry->fileid = new_entry->obj_handle.fileid;
 
 	/* add to avl */
-	code = mdcache_avl_insert(state->dir, &new_dir_entry);
+	code = mdc_dirents_insert(state->dir, &new_dir_entry);
 
 	if (code < 0) {
 		/* We can get here with the following possibilities:
@@ -2307,10 +2312,10 @@ mdc_readdir_chunk_object(const char *name, struct fsal_obj_handle *sub_handle,
 		return DIR_CONTINUE;
 	}
 
-	/* Note that if this dirent was already in the lookup by name AVL
-	 * tree (state->dir->fsobj.fsdir.avl.t), then mdcache_avl_qp_insert
-	 * freed the dirent we allocated above, and returned the one that was
-	 * in tree. It will have set chunk, ck, and nk.
+	/* Note that if this dirent was already in the lookup by name
+	 * index (state->dir->fsobj.fsdir->dirents.by_name), then
+	 * mdc_dirents_insert freed the dirent we allocated above, and returned
+	 * the one that was in the index. It will have set chunk, ck, and nk.
 	 *
 	 * The existing dirent might or might not be part of a chunk already.
 	 */
@@ -2348,7 +2353,7 @@ mdc_readdir_chunk_object(const char *name, struct fsal_obj_handle *sub_handle,
 
 		node = avltree_inline_insert(
 					&new_dir_entry->node_sorted,
-					&state->dir->fsobj.fsdir.avl.sorted,
+					&state->dir->fsobj.fsdir->dirents.sorted,
 					avl_dirent_sorted_cmpf);
 
 		if (node != NULL) {
@@ -2538,7 +2543,7 @@ static struct dir_chunk *mdcache_skip_chunks(mdcache_entry_t *directory,
 
 	/* We need to skip chunks that are already cached. */
 	while (chunk->next_ck != 0 &&
-	       mdcache_avl_lookup_ck(directory, chunk->next_ck, &dirent)) {
+	       mdc_dirents_lookup_ck(directory, chunk->next_ck, &dirent)) {
 		/* Drop ref on chunk; dirent->chunk has a new ref from above */
 		mdcache_lru_unref_chunk(chunk);
 		chunk = dirent->chunk;
@@ -2759,7 +2764,7 @@ again:
 
 		last = glist_last_entry(&state.cur_chunk->dirents,
 					mdcache_dir_entry_t, chunk_list);
-		last->eod = true;
+		last->flags |= DIR_ENTRY_EOD;
 	}
 
 	LogFullDebugAlt(COMPONENT_NFS_READDIR, COMPONENT_MDCACHE,
@@ -2927,6 +2932,9 @@ fsal_status_t mdcache_readdir_chunked(mdcache_entry_t *directory,
 	bool reload_chunk = false;
 	bool whence_is_name = op_ctx->fsal_export->exp_ops.fs_supports(
 				op_ctx->fsal_export, fso_whence_is_name);
+	bool dirent_only = (attrmask & ATTR_DIRENT_ONLY) != 0;
+
+	attrmask &= ~ATTR_DIRENT_ONLY;
 
 
 #ifdef USE_LTTNG
@@ -2971,7 +2979,7 @@ restart:
 		 * directory instead, this is only non-zero if the first
 		 * chunk of the directory is still present.
 		 */
-		look_ck = directory->fsobj.fsdir.first_ck;
+		look_ck = directory->fsobj.fsdir->first_ck;
 	}
 
 	/* We need to know if we need to set first_ck. */
@@ -2987,7 +2995,7 @@ again:
 			next_ck, look_ck);
 
 	if (look_ck == 0 ||
-	    !mdcache_avl_lookup_ck(directory, look_ck, &dirent)) {
+	    !mdc_dirents_lookup_ck(directory, look_ck, &dirent)) {
 		fsal_status_t status;
 		/* This starting position isn't in our cache...
 		 * Go populate the cache and process from there.
@@ -3019,7 +3027,7 @@ again:
 
 		if (save_ck) {
 			/* Try to get the chunk back for whence_is_name */
-			if (mdcache_avl_lookup_ck(directory, save_ck,
+			if (mdc_dirents_lookup_ck(directory, save_ck,
 						  &dirent)) {
 				chunk = dirent->chunk;
 				LogFullDebugAlt(COMPONENT_NFS_READDIR,
@@ -3034,7 +3042,7 @@ again:
 		dirent = NULL;
 
 		if (look_ck != 0 &&
-		    look_ck == directory->fsobj.fsdir.first_ck) {
+		    look_ck == directory->fsobj.fsdir->first_ck) {
 			/* We failed to find the first dentry in the directory,
 			 * and will load this chunk.  Make sure we save
 			 * whatever is the new first_ck. */
@@ -3128,7 +3136,7 @@ again:
 					COMPONENT_MDCACHE,
 					"Setting directory first_ck=%"PRIx64,
 					dirent->ck);
-			directory->fsobj.fsdir.first_ck = dirent->ck;
+			directory->fsobj.fsdir->first_ck = dirent->ck;
 			set_first_ck = false;
 		}
 	} else {
@@ -3181,6 +3189,41 @@ again:
 		}
 
 		status.major = ERR_FSAL_NO_ERROR;
+
+		if (dirent_only && dirent->type != NO_FILE_TYPE &&
+		    dirent->type != DIRECTORY) {
+			/* The caller only wants what the dirent already knows,
+			 * don't look up or revalidate the entry. Directories
+			 * still go the long way since junctions and referrals
+			 * need the object.
+			 */
+			if (has_write && dirent->mde_entry) {
+				mdcache_lru_unref(dirent->mde_entry,
+						  LRU_ACTIVE_REF);
+				dirent->mde_entry = NULL;
+			}
+
+			if (reload_chunk && look_ck != 0 &&
+			    dirent->ck != look_ck)
+				continue;
+
+			next_ck = dirent->ck;
+
+			if (dirent->ck == whence) {
+				reload_chunk = false;
+				continue;
+			}
+
+			fsal_prepare_attrs(&attrs, ATTRS_DIRENT);
+			attrs.valid_mask = ATTRS_DIRENT;
+			attrs.type = dirent->type;
+			attrs.fileid = dirent->fileid;
+
+			cb_result = cb(dirent->name, NULL, &attrs, dir_state,
+				       dirent->ck);
+			goto cb_done;
+		}
+
 		/* We have the content_lock for at least read. */
 		if (dirent->mde_entry) {
 			/* Take a ref for our use */
@@ -3356,6 +3399,7 @@ again:
 		cb_result = cb(dirent->name, &entry->obj_handle, &attrs,
 			       dir_state, dirent->ck);
 
+cb_done:
 		fsal_release_attrs(&attrs);
 
 		if (whence_is_name) {
@@ -3372,9 +3416,11 @@ again:
 				"dirent = %p %s, cb_result = %s, eod = %s",
 				dirent, dirent->name,
 				fsal_dir_result_str(cb_result),
-				dirent->eod ? "true" : "false");
+				(dirent->flags & DIR_ENTRY_EOD)
+					? "true" : "false");
 
-		if (cb_result >= DIR_TERMINATE || dirent->eod) {
+		if (cb_result >= DIR_TERMINATE ||
+		    (dirent->flags & DIR_ENTRY_EOD)) {
 			/* Caller is done, or we have reached the end of
 			 * the directory, no need to get another dirent.
 			 */
@@ -3383,7 +3429,8 @@ again:
 			 * not consume this entry, so we can not have reached
 			 * end of directory.
 			 */
-			*eod_met = cb_result != DIR_TERMINATE && dirent->eod;
+			*eod_met = cb_result != DIR_TERMINATE &&
+				   (dirent->flags & DIR_ENTRY_EOD);
 
 			if (*eod_met && whence == 0) {
 				/* Since eod is true and whence is 0, we know
@@ -3417,8 +3464,9 @@ again:
 
 	if (chunk->next_ck != 0) {
 		/* If the chunk has a known chunk following it, use the first
-		 * cookie in that chunk for AVL tree lookup, which will succeed
-		 * rather than having to do a readdir to find the next entry.
+		 * cookie in that chunk for the cookie index lookup, which will
+		 * succeed rather than having to do a readdir to find the next
+		 * entry.
 		 *
 		 * If the chunk is no longer present, the lookup will fail, in
 		 * which case next_ck is the right cookie to use as the whence
@@ -42,6 +42,7 @@
 #include "fsal_convert.h"
 #include "display.h"
 #include "common_utils.h"
+#include "mdcache_dirent_index.h"
 
 typedef struct mdcache_fsal_obj_handle mdcache_entry_t;
 
@@ -98,6 +99,12 @@ struct mdcache_fsal_export {
 	mdc_dirmap_t dirent_map;
 	/** Thread for dirmap processing */
 	struct fridgethr *dirmap_fridge;
+	/** Thread for periodic cache snapshots */
+	struct fridgethr *snapshot_fridge;
+	/** Export ID the snapshot thread saves for */
+	uint16_t snapshot_export_id;
+	/** When the snapshot was last written */
+	time_t snapshot_time;
 };
 
 /**
@@ -161,6 +168,7 @@ enum lru_q_id {
 				   * last active reference (never cleared).
 				   */
 #define LRU_SENTINEL_HELD 0x00000008 /* true if sentinel reference is held */
+#define LRU_REFERENCED 0x00000010 /* Chunk used since the last LRU sweep */
 
 typedef struct mdcache_lru__ {
 	struct glist_head q;	/*< Link in the physical deque
@@ -229,6 +237,8 @@ struct entry_export_map {
 #define MDCACHE_TRUST_SEC_LABEL FSAL_UP_INVALIDATE_SEC_LABEL
 /** The entry has been removed, but not unhashed due to state */
 static const uint32_t MDCACHE_UNREACHABLE = 0x100;
+/** The sub-FSAL holds an attribute lease, trusted attributes never expire */
+static const uint32_t MDCACHE_ATTR_LEASE = 0x1000;
 
 
 /**
@@ -271,42 +281,97 @@ static const uint32_t MDCACHE_UNREACHABLE = 0x100;
  * fsal_obj_handle are two parts of the same thing, a cached inode.
  * mdcache_entry holds the cache stuff and fsal_obj_handle holds the
  * stuff the fsal has to manage, i.e. filesystem bits.
+ *
+ * @note Field order matters.  The members touched by a handle lookup,
+ * an LRU ref/unref and a cached GETATTR are grouped at the start of the
+ * structure so they share the leading cache lines.  Directory-only
+ * content lives in a separately allocated struct mdcache_fsdir so the
+ * far more numerous non-directory entries do not carry it.
+ */
+
+struct mdcache_fsdir {
+	/** List of chunks in this directory, ordered */
+	struct glist_head chunks;
+	/** List of detached directory entries. */
+	struct glist_head detached;
+	/** Spin lock to protect the detached list. */
+	pthread_spinlock_t fsd_spin;
+	/** Count of detached directory entries. */
+	int detached_count;
+	/** The first dirent cookie in this directory.
+	 *  0 if not known.
+	 */
+	fsal_cookie_t first_ck;
+	/** The parent host-handle of this directory ('..') */
+	struct gsh_buffdesc parent;
+	/** Time at which we last refreshed parent host-handle. */
+	time_t parent_time;
+	struct {
+		/** Live children by name hash */
+		struct mdc_dirent_index by_name;
+		/** Chunked children by FSAL cookie */
+		struct mdc_dirent_index by_ck;
+		/** Chunked children in FSAL sorted order, only for FSALs
+		 *  that compute readdir cookies.  This one needs neighbour
+		 *  lookups, so it stays an AVL tree. */
+		struct avltree sorted;
+		/** Heuristic. Expect 0. */
+		uint32_t collisions;
+	} dirents;
+	/** Storage for dir state */
+	struct state_hdl dhdl;
+};
+
+/** Encodings kept per entry, GETATTR from Linux uses one or two masks */
+#define MDC_ENCODED_ATTRS 2
+
+/**
+ * @brief Wire encoding of attributes, with the caller's key
  */
+struct mdc_encoded_attrs {
+	uint32_t key_len;
+	uint32_t val_len;
+	char data[];	/*< key followed by value */
+};
 
 struct mdcache_fsal_obj_handle {
-	/** Reader-writer lock for attributes */
-	pthread_rwlock_t attr_lock;
-	/** MDCache FSAL Handle */
-	struct fsal_obj_handle obj_handle;
-	/** Sub-FSAL handle */
-	struct fsal_obj_handle *sub_handle;
-	/** Cached attributes */
-	struct fsal_attrlist attrs;
-	/** Attribute generation, increased for every write */
-	uint32_t attr_generation;
 	/** FH hash linkage */
 	struct {
 		struct avltree_node node_k;	/*< AVL node in tree */
 		mdcache_key_t key;	/*< Key of this entry */
 		bool inavl;
 	} fh_hk;
+	/** New style LRU link */
+	mdcache_lru_t lru;
 	/** Flags for this entry */
 	uint32_t mde_flags;
+	/** Attribute generation, increased for every write */
+	uint32_t attr_generation;
 	/** Time at which we last refreshed attributes. */
 	time_t attr_time;
 	/** Time at which we last refreshed acl. */
 	time_t acl_time;
-	/** Time at which we last refreshed fs locations */
-	time_t fs_locations_time;
-	/** New style LRU link */
-	mdcache_lru_t lru;
-	/** Exports per entry (protected by attr_lock) */
-	struct glist_head export_list;
+	/** Sub-FSAL handle */
+	struct fsal_obj_handle *sub_handle;
 	/** ID of the first mapped export for fast path
 	 *  This is an int32_t because we need it to be -1 to indicate
 	 *  no mapped export.
 	 */
 	int32_t first_export_id;
+	/** Reader-writer lock for attributes */
+	pthread_rwlock_t attr_lock;
+	/** Cached attributes */
+	struct fsal_attrlist attrs;
+	/** Encoded attributes, see mdcache_encoded_attrs_get() (protected
+	    by attr_lock) */
+	struct mdc_encoded_attrs *enc_attrs[MDC_ENCODED_ATTRS];
+	uint32_t enc_attrs_next;
+	/** MDCache FSAL Handle */
+	struct fsal_obj_handle obj_handle;
+	/** Exports per entry (protected by attr_lock) */
+	struct glist_head export_list;
+	/** Time at which we last refreshed fs locations */
+	time_t fs_locations_time;
 	/** Lock on type-specific cached content.  See locking
 	    discipline for details. */
 	pthread_rwlock_t content_lock;
@@ -315,51 +380,8 @@ struct mdcache_fsal_obj_handle {
 	    attributes.rawdev */
 	union mdcache_fsobj {
 		struct state_hdl hdl;
-		struct {
-			/** List of chunks in this directory, ordered */
-			struct glist_head chunks;
-			/** List of detached directory entries. */
-			struct glist_head detached;
-			/** Spin lock to protect the detached list. */
-			pthread_spinlock_t fsd_spin;
-			/** Count of detached directory entries. */
-			int detached_count;
-			/** @todo FSF
-			 *
-			 * This is somewhat fragile, however, a reorganization
-			 * is possible. If state_lock was to be moved into
-			 * state_file and state_dir, and the state code was
-			 * made clear which it was working with, dhdl could
-			 * be replaced with a state_dir which would be
-			 * smaller than state_file, and then the additional
-			 * members of fsdir would basically overlay
-			 * the larger state_file that hdl is.
-			 *
-			 * Such a reorg could save memory AND make for a
-			 * crisper interface.
-			 */
-			struct state_hdl dhdl; /**< Storage for dir state */
-			/** The parent host-handle of this directory ('..') */
-			struct gsh_buffdesc parent;
-			/** Time at which we last refreshed parent
-			  * host-handle.
-			  */
-			time_t parent_time;
-			/** The first dirent cookie in this directory.
-			 *  0 if not known.
-			 */
-			fsal_cookie_t first_ck;
-			struct {
-				/** Children by name hash */
-				struct avltree t;
-				/** Table of dirents by FSAL cookie */
-				struct avltree ck;
-				/** Table of dirents in sorted order. */
-				struct avltree sorted;
-				/** Heuristic. Expect 0. */
-				uint32_t collisions;
-			} avl;
-		} fsdir;		/**< DIRECTORY data */
+		/** DIRECTORY data, allocated with the entry */
+		struct mdcache_fsdir *fsdir;
 	} fsobj;
 };
 
@@ -392,16 +414,14 @@ struct dir_chunk {
 #define DIR_ENTRY_FLAG_NONE     0x0000
 #define DIR_ENTRY_FLAG_DELETED  0x0001
 #define DIR_ENTRY_SORTED        0x0004
+/* Last dirent in a chunked directory */
+#define DIR_ENTRY_EOD           0x0008
 
 typedef struct mdcache_dir_entry__ {
 	/** This dirent is part of a chunk */
 	struct glist_head chunk_list;
 	/** The chunk this entry belongs to */
 	struct dir_chunk *chunk;
-	/** node in tree by name */
-	struct avltree_node node_name;
-	/** AVL node in tree by cookie */
-	struct avltree_node node_ck;
 	/** AVL node in tree by sorted order */
 	struct avltree_node node_sorted;
 	/** Cookie value from FSAL
@@ -409,20 +429,21 @@ typedef struct mdcache_dir_entry__ {
 	 *  a readdir with whence will be looking for the NEXT entry.
 	 */
 	uint64_t ck;
-	/** Indicates if this dirent is the last dirent in a chunked directory.
-	 */
-	bool eod;
 	/** Name Hash */
 	uint64_t namehash;
 	/** Key of cache entry */
 	mdcache_key_t ckey;
-	/** Flags
-	 * Protected by write content_lock or atomics. */
-	uint32_t flags;
 	/** Temporary entry pointer
 	 * Only valid while the entry is ref'd.  Must be NULL otherwise.
 	 * Protected by the parent content_lock */
 	mdcache_entry_t *mde_entry;
+	/** Fileid of the object, valid if type is known */
+	uint64_t fileid;
+	/** Flags
+	 * Protected by write content_lock or atomics. */
+	uint32_t flags;
+	/** Type of the object, NO_FILE_TYPE if not known */
+	object_file_type_t type;
 	const char *name;
 	/** The NUL-terminated filename */
 	char name_buffer[];
@@ -438,13 +459,13 @@ typedef struct mdcache_dir_entry__ {
 static inline void bump_detached_dirent(mdcache_entry_t *parent,
 					mdcache_dir_entry_t *dirent)
 {
-	PTHREAD_SPIN_lock(&parent->fsobj.fsdir.fsd_spin);
-	if (glist_first_entry(&parent->fsobj.fsdir.detached,
+	PTHREAD_SPIN_lock(&parent->fsobj.fsdir->fsd_spin);
+	if (glist_first_entry(&parent->fsobj.fsdir->detached,
 			      mdcache_dir_entry_t, chunk_list) != dirent) {
 		glist_del(&dirent->chunk_list);
-		glist_add(&parent->fsobj.fsdir.detached, &dirent->chunk_list);
+		glist_add(&parent->fsobj.fsdir->detached, &dirent->chunk_list);
 	}
-	PTHREAD_SPIN_unlock(&parent->fsobj.fsdir.fsd_spin);
+	PTHREAD_SPIN_unlock(&parent->fsobj.fsdir->fsd_spin);
 }
 
 /**
@@ -457,15 +478,15 @@ static inline void bump_detached_dirent(mdcache_entry_t *parent,
 static inline void rmv_detached_dirent(mdcache_entry_t *parent,
 				       mdcache_dir_entry_t *dirent)
 {
-	PTHREAD_SPIN_lock(&parent->fsobj.fsdir.fsd_spin);
+	PTHREAD_SPIN_lock(&parent->fsobj.fsdir->fsd_spin);
 	/* Note that the dirent might not be on the detached list if it
 	 * was being reaped by another thread. All is well here...
 	 */
 	if (!glist_null(&dirent->chunk_list)) {
 		glist_del(&dirent->chunk_list);
-		parent->fsobj.fsdir.detached_count--;
+		parent->fsobj.fsdir->detached_count--;
 	}
-	PTHREAD_SPIN_unlock(&parent->fsobj.fsdir.fsd_spin);
+	PTHREAD_SPIN_unlock(&parent->fsobj.fsdir->fsd_spin);
 }
 
 /* Helpers */
@@ -577,6 +598,11 @@ void _mdcache_kill_entry(mdcache_entry_t *entry,
 	_mdcache_kill_entry(entry, \
 			    (char *) __FILE__, __LINE__, (char *) __func__)
 
+void mdcache_snapshot_save(struct mdcache_fsal_export *exp);
+void mdcache_snapshot_load(void);
+void mdcache_snapshot_start(struct mdcache_fsal_export *exp);
+void mdcache_snapshot_stop(struct mdcache_fsal_export *exp);
+
 fsal_status_t
 mdc_get_parent_handle(struct mdcache_fsal_export *exp,
 		      mdcache_entry_t *entry,
@@ -679,7 +705,7 @@ mdcache_is_parent_valid(mdcache_entry_t *entry)
 {
 	time_t current_time = time(NULL);
 
-	if (current_time > entry->fsobj.fsdir.parent_time)
+	if (current_time > entry->fsobj.fsdir->parent_time)
 		return false;
 	return true;
 }
@@ -695,14 +721,14 @@ mdcache_is_parent_valid(mdcache_entry_t *entry)
 static inline void
 mdc_dir_add_parent(mdcache_entry_t *entry, mdcache_entry_t *mdc_parent)
 {
-	if (entry->fsobj.fsdir.parent.len != 0) {
+	if (entry->fsobj.fsdir->parent.len != 0) {
 		/* Already has a parent pointer */
-		if (entry->fsobj.fsdir.parent_time == 0 ||
+		if (entry->fsobj.fsdir->parent_time == 0 ||
 		    mdcache_is_parent_valid(entry)) {
 			return;
 		} else {
 			/* Clean up parent key */
-			mdcache_free_fh(&entry->fsobj.fsdir.parent);
+			mdcache_free_fh(&entry->fsobj.fsdir->parent);
 		}
 	}
 
@@ -884,6 +910,12 @@ mdcache_is_attrs_valid(mdcache_entry_t *entry, attrmask_t mask)
 	    && mdcache_param.getattr_dir_invalidation)
 		return false;
 
+	/* The sub-FSAL will tell us about any change, the trust flags
+	 * checked above are all that matters.
+	 */
+	if (test_mde_flags(entry, MDCACHE_ATTR_LEASE))
+		return true;
+
 	file_deleg = (entry->obj_handle.state_hdl &&
 	  entry->obj_handle.state_hdl->file.fdeleg_stats.fds_curr_delegations);
 
@@ -960,9 +992,9 @@ mdc_has_state(mdcache_entry_t *entry)
 			return true;
 		return false;
 	case DIRECTORY:
-		if (entry->fsobj.fsdir.dhdl.dir.junction_export)
+		if (entry->fsobj.fsdir->dhdl.dir.junction_export)
 			return true;
-		if (entry->fsobj.fsdir.dhdl.dir.exp_root_refcount)
+		if (entry->fsobj.fsdir->dhdl.dir.exp_root_refcount)
 			return true;
 		return false;
 	default:
@@ -1101,6 +1133,16 @@ fsal_status_t mdcache_close2(struct fsal_obj_handle *obj_hdl,
 fsal_status_t mdcache_fallocate(struct fsal_obj_handle *obj_hdl,
 				struct state_t *state, uint64_t offset,
 				uint64_t length, bool allocate);
+fsal_status_t mdcache_copy(struct fsal_obj_handle *src_hdl,
+			   struct state_t *src_state, uint64_t src_offset,
+			   struct fsal_obj_handle *dst_hdl,
+			   struct state_t *dst_state, uint64_t dst_offset,
+			   uint64_t count, uint64_t *copied);
+fsal_status_t mdcache_clone(struct fsal_obj_handle *src_hdl,
+			    struct state_t *src_state, uint64_t src_offset,
+			    struct fsal_obj_handle *dst_hdl,
+			    struct state_t *dst_state, uint64_t dst_offset,
+			    uint64_t count);
 
 /* extended attributes management */
 fsal_status_t mdcache_list_ext_attrs(struct fsal_obj_handle *obj_hdl,
@@ -421,6 +421,12 @@ lru_insert_chunk(struct dir_chunk *chunk, struct lru_q *q)
 /*
  * @brief Move an entry from LRU L1 or L2 queues to the ACTIVE queue.
  *
+ * Taking or dropping an active reference does not move the entry, so an
+ * idle entry can be used without the lane lock.  Entries found in use on
+ * L1 or L2 by the reaper or the LRU thread are moved here instead.
+ *
+ * Assumes qlane lock is held.
+ *
  * @param [in] entry  Entry to adjust.
  */
 static inline void
@@ -430,7 +436,6 @@ make_active_lru(mdcache_entry_t *entry)
 	struct lru_q_lane *qlane = &LRU[lru->lane];
 	struct lru_q *q;
 
-	QLOCK(qlane);
 	switch (lru->qid) {
 	case LRU_ENTRY_L1:
 		q = lru_queue_of(entry);
@@ -456,13 +461,14 @@ make_active_lru(mdcache_entry_t *entry)
 		/* do nothing */
 		break;
 	}	/* switch qid */
-	QUNLOCK(qlane);
 }
 
 /*
  * @brief Move an active entry from ACTIVE queue to MRU of L1 or L2.
  *
- * If the entry is in the cleanup queue, do nothing.
+ * If the entry is in the cleanup queue, do nothing.  Called by the LRU
+ * thread for entries left on ACTIVE once their last active reference is
+ * gone.
  *
  * Assumes qlane lock is held.
  *
@@ -476,10 +482,6 @@ make_inactive_lru(mdcache_entry_t *entry)
 	struct lru_q *q;
 
 	switch (lru->qid) {
-	case LRU_ENTRY_L1:
-	case LRU_ENTRY_L2:
-		assert(false);
-		break;
 	case LRU_ENTRY_ACTIVE:
 		/* Move entry to MRU of L1 or L2 */
 		q = lru_queue_of(entry);
@@ -516,6 +518,7 @@ static inline void
 mdcache_lru_clean(mdcache_entry_t *entry)
 {
 	fsal_status_t status = {0, 0};
+	int i;
 
 	/* Free SubFSAL resources */
 	if (entry->sub_handle) {
@@ -642,6 +645,12 @@ mdcache_lru_clean(mdcache_entry_t *entry)
 	/* Done with the attrs */
 	fsal_release_attrs(&entry->attrs);
 
+	for (i = 0; i < MDC_ENCODED_ATTRS; i++) {
+		gsh_free(entry->enc_attrs[i]);
+		entry->enc_attrs[i] = NULL;
+	}
+	entry->enc_attrs_next = 0;
+
 	/* Clean out the export mapping before deconstruction */
 	mdc_clean_entry(entry);
 
@@ -657,8 +666,12 @@ mdcache_lru_clean(mdcache_entry_t *entry)
 
 	state_hdl_cleanup(entry->obj_handle.state_hdl, entry->obj_handle.type);
 
-	if (entry->obj_handle.type == DIRECTORY)
-		PTHREAD_SPIN_destroy(&entry->fsobj.fsdir.fsd_spin);
+	if (entry->obj_handle.type == DIRECTORY && entry->fsobj.fsdir) {
+		PTHREAD_SPIN_destroy(&entry->fsobj.fsdir->fsd_spin);
+		gsh_free(entry->fsobj.fsdir);
+		entry->fsobj.fsdir = NULL;
+		entry->obj_handle.state_hdl = NULL;
+	}
 }
 
 /**
@@ -681,6 +694,9 @@ mdcache_lru_clean(mdcache_entry_t *entry)
 
 static uint32_t reap_lane;
 
+/* Busy entries the reaper moves to ACTIVE per lane before giving up */
+#define LRU_REAP_SETTLE_MAX 16
+
 static inline mdcache_lru_t *
 lru_reap_impl(enum lru_q_id qid)
 {
@@ -691,7 +707,7 @@ lru_reap_impl(enum lru_q_id qid)
 	mdcache_entry_t *entry;
 	uint32_t refcnt;
 	cih_latch_t latch;
-	int ix;
+	int ix, settled;
 
 	lane = LRU_NEXT(reap_lane);
 	for (ix = 0; ix < LRU_N_Q_LANES; ++ix, lane = LRU_NEXT(reap_lane)) {
@@ -700,6 +716,20 @@ lru_reap_impl(enum lru_q_id qid)
 
 		QLOCK(qlane);
 		lru = glist_first_entry(&lq->q, mdcache_lru_t, q);
+
+		/* Entries that got an active reference while on L1 or L2
+		 * stay there until someone looks.  Move the ones in the way
+		 * to ACTIVE now, up to a bound to keep the lock hold short.
+		 */
+		for (settled = 0;
+		     lru && settled < LRU_REAP_SETTLE_MAX &&
+		     atomic_fetch_int32_t(&lru->active_refcnt) > 0;
+		     settled++) {
+			make_active_lru(container_of(lru, mdcache_entry_t,
+						     lru));
+			lru = glist_first_entry(&lq->q, mdcache_lru_t, q);
+		}
+
 		if (!lru) {
 			QUNLOCK(qlane);
 			continue;
@@ -836,6 +866,19 @@ lru_reap_chunk_impl(enum lru_q_id qid, mdcache_entry_t *parent)
 		QLOCK(qlane);
 		lru = glist_first_entry(&lq->q, mdcache_lru_t, q);
 
+		/* Give chunks used since they were last looked at a second
+		 * chance at the MRU of L1.  Each pass clears the bit, so this
+		 * terminates.
+		 */
+		while (lru && (atomic_fetch_uint32_t(&lru->flags)
+			       & LRU_REFERENCED)) {
+			atomic_clear_uint32_t_bits(&lru->flags,
+						   LRU_REFERENCED);
+			CHUNK_LRU_DQ(lru, lq);
+			lru_insert(lru, &qlane->L1);
+			lru = glist_first_entry(&lq->q, mdcache_lru_t, q);
+		}
+
 		if (!lru) {
 			QUNLOCK(qlane);
 			continue;
@@ -967,7 +1010,7 @@ struct dir_chunk *mdcache_get_chunk(mdcache_entry_t *parent,
 
 	/* Set the chunk's parent and insert */
 	chunk->parent = parent;
-	glist_add_tail(&chunk->parent->fsobj.fsdir.chunks, &chunk->chunks);
+	glist_add_tail(&chunk->parent->fsobj.fsdir->chunks, &chunk->chunks);
 	if (prev_chunk) {
 		chunk->reload_ck = glist_last_entry(&prev_chunk->dirents,
 						    mdcache_dir_entry_t,
@@ -981,6 +1024,7 @@ struct dir_chunk *mdcache_get_chunk(mdcache_entry_t *parent,
 	}
 
 	chunk->chunk_lru.refcnt = 2;
+	chunk->chunk_lru.flags = 0;
 	chunk->chunk_lru.cf = 0;
 	chunk->chunk_lru.lane = lru_lane_of(chunk);
 
@@ -1117,6 +1161,7 @@ static inline int lru_run_lane(int lane)
 	/* Current queue lane */
 	struct lru_q_lane *qlane = &LRU[lane];
 	struct glist_head *glist, *glistn;
+	size_t visited;
 
 	q = &qlane->L1;
 
@@ -1124,9 +1169,29 @@ static inline int lru_run_lane(int lane)
 		 "Reaping up to %d entries from lane %d",
 		 lru_state.per_lane_work, lane);
 
-	/* ACTIVE */
 	QLOCK(qlane);
 
+	/* ACTIVE: entries stay here after their last active reference is
+	 * dropped, return the idle ones to L1 or L2.  Busy ones are rotated
+	 * to the other end, so that each pass looks at different entries.
+	 */
+	visited = 0;
+	glist_for_each_safe(glist, glistn, &qlane->ACTIVE.q) {
+		mdcache_lru_t *lru = glist_entry(glist, mdcache_lru_t, q);
+
+		if (visited++ >= lru_state.per_lane_work)
+			break;
+
+		if (atomic_fetch_int32_t(&lru->active_refcnt) == 0) {
+			make_inactive_lru(container_of(lru, mdcache_entry_t,
+						       lru));
+			++workdone;
+		} else {
+			glist_del(&lru->q);
+			glist_add_tail(&qlane->ACTIVE.q, &lru->q);
+		}
+	}
+
 	glist_for_each_safe(glist, glistn, &q->q) {
 		/* The entry being examined */
 		mdcache_lru_t *lru = NULL;
@@ -1153,6 +1218,13 @@ static inline int lru_run_lane(int lane)
 		   refcnt, atomic_fetch_int32_t(&entry->lru.active_refcnt));
 #endif
 
+		/* In use since it was put here, it belongs on ACTIVE */
+		if (atomic_fetch_int32_t(&lru->active_refcnt) > 0) {
+			make_active_lru(entry);
+			++workdone;
+			continue;
+		}
+
 		/* check refcnt in range */
 		if (unlikely(refcnt == 1)) {
 			struct lru_q *q;
@@ -1372,6 +1444,15 @@ static inline size_t chunk_lru_run_lane(size_t lane)
 			continue;
 		}
 
+		/* Used since the last sweep, clear the bit and leave it in
+		 * L1.  It is demoted on the next sweep unless used again.
+		 */
+		if (atomic_fetch_uint32_t(&lru->flags) & LRU_REFERENCED) {
+			atomic_clear_uint32_t_bits(&lru->flags,
+						   LRU_REFERENCED);
+			continue;
+		}
+
 		/* Move lru object to MRU of L2 */
 		q = &qlane->L1;
 		CHUNK_LRU_DQ(lru, q);
@@ -1858,10 +1939,12 @@ void _mdcache_lru_ref(mdcache_entry_t *entry, uint32_t flags, const char *func,
 		assert(flags & LRU_ACTIVE_REF);
 	}
 
-	if (flags & LRU_ACTIVE_REF) {
-		/* Move into ACTIVE queue or adjust to MRU */
-		make_active_lru(entry);
-	}
+	/* The entry is not moved to ACTIVE here, not even by the reference
+	 * that takes active_refcnt from 0 to 1, so no reference takes the lane
+	 * lock.  The reaper only reclaims entries holding nothing but the
+	 * sentinel reference, whatever queue they are on, and it or the LRU
+	 * thread moves entries found in use to ACTIVE (see lru_run_lane()).
+	 */
 }
 
 /**
@@ -1888,7 +1971,8 @@ _mdcache_lru_unref(mdcache_entry_t *entry, uint32_t flags, const char *func,
 	bool do_cleanup = false;
 	uint32_t lane = entry->lru.lane;
 	struct lru_q_lane *qlane = &LRU[lane];
-	bool other_lock_held = entry->fsobj.hdl.no_cleanup;
+	bool other_lock_held = entry->obj_handle.type != DIRECTORY &&
+			       entry->fsobj.hdl.no_cleanup;
 	bool freed = false;
 
 	if (!other_lock_held) {
@@ -1940,20 +2024,11 @@ _mdcache_lru_unref(mdcache_entry_t *entry, uint32_t flags, const char *func,
 	 * cleanup will occur.
 	 */
 
-	/* Handle active unref first */
-	if (flags & LRU_ACTIVE_REF &&
-	    PTHREAD_MUTEX_dec_int32_t_and_lock(&entry->lru.active_refcnt,
-					       &qlane->ql_mtx)) {
-		/* active_refcnt is zero and we hold the QLOCK. */
-#if 0
-		/* For clarity... */
-		QLOCK(qlane);
-#endif
-		/* Move entry to MRU of L1 or L2 or leave in cleanup queue. */
-		make_inactive_lru(entry);
-
-		QUNLOCK(qlane);
-	}
+	/* Handle active unref first.  Even the last one leaves the entry
+	 * on ACTIVE, the LRU thread returns it to L1 or L2 later.
+	 */
+	if (flags & LRU_ACTIVE_REF)
+		atomic_dec_int32_t(&entry->lru.active_refcnt);
 
 	/* Handle normal unref next for all unrefs. */
 	if (PTHREAD_MUTEX_dec_int32_t_and_lock(&entry->lru.refcnt,
@@ -2060,34 +2135,18 @@ void _mdcache_lru_unref_chunk(struct dir_chunk *chunk, const char *func,
 /**
  * @brief Indicate that a chunk is being used, bump it up in the LRU
  *
+ * This is called for every cached lookup and readdir, so it does not take
+ * the lane lock.  The chunk is only marked referenced; the LRU thread and
+ * the chunk reaper give referenced chunks a second chance at the MRU of L1
+ * (CLOCK style) instead of demoting or reaping them.
  */
 void lru_bump_chunk(struct dir_chunk *chunk)
 {
 	mdcache_lru_t *lru = &chunk->chunk_lru;
-	struct lru_q_lane *qlane = &CHUNK_LRU[lru->lane];
-	struct lru_q *q;
 
-	QLOCK(qlane);
-	q = chunk_lru_queue_of(chunk);
-
-	switch (lru->qid) {
-	case LRU_ENTRY_L1:
-		/* advance chunk to MRU (of L1) */
-		CHUNK_LRU_DQ(lru, q);
-		lru_insert(lru, q);
-		break;
-	case LRU_ENTRY_L2:
-		/* move chunk to MRU of L1 */
-		CHUNK_LRU_DQ(lru, q);
-		q = &qlane->L1;
-		lru_insert(lru, q);
-		break;
-	default:
-		/* do nothing */
-		break;
-	}
-
-	QUNLOCK(qlane);
+	/* Avoid dirtying the cache line when the bit is already set */
+	if (!(atomic_fetch_uint32_t(&lru->flags) & LRU_REFERENCED))
+		atomic_set_uint32_t_bits(&lru->flags, LRU_REFERENCED);
 }
 
 static inline void mdc_lru_dirmap_add(struct mdcache_fsal_export *exp,
@@ -236,6 +236,12 @@ mdcache_fsal_create_export(struct fsal_module *sub_fsal, void *parse_node,
 	/* Stacking is setup and ready to take upcalls now */
 	up_ready_set(&myself->up_ops);
 
+	/* Warm the cache from a previous snapshot, if there is one, and keep
+	 * saving new ones while the export runs.
+	 */
+	mdcache_snapshot_load();
+	mdcache_snapshot_start(myself);
+
 	return status;
 }
 
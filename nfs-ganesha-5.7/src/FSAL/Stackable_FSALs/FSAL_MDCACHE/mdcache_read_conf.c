@@ -94,6 +94,16 @@ static struct config_item mdcache_params[] = {
 		       mdcache_parameter, futility_count),
 	CONF_ITEM_UI32("Dirmap_HWMark", 1, UINT32_MAX, 10000,
 		       mdcache_parameter, dirmap_hwmark),
+	CONF_ITEM_PATH("Snapshot_Dir", 1, MAXPATHLEN, NULL,
+		       mdcache_parameter, snapshot_dir),
+	CONF_ITEM_UI32("Snapshot_Max_Entries", 0, UINT32_MAX, 100000,
+		       mdcache_parameter, snapshot_max_entries),
+	CONF_ITEM_UI32("Snapshot_Interval", 0, UINT32_MAX, 300,
+		       mdcache_parameter, snapshot_interval),
+	CONF_ITEM_UI32("Snapshot_Load_Rate", 0, UINT32_MAX, 1000,
+		       mdcache_parameter, snapshot_load_rate),
+	CONF_ITEM_BOOL("Cache_Encoded_Attrs", true,
+		       mdcache_parameter, cache_encoded_attrs),
 	CONFIG_EOL
 };
 
@@ -0,0 +1,580 @@
+// SPDX-License-Identifier: LGPL-3.0-or-later
+/*
+ * vim:noexpandtab:shiftwidth=8:tabstop=8:
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 3 of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc.,
+ * 51 Franklin Street, Fifth Floor, Boston, MA
+ * 02110-1301 USA
+ *
+ */
+
+/**
+ * @addtogroup FSAL_MDCACHE
+ * @{
+ */
+
+/**
+ * @file  mdcache_snapshot.c
+ * @brief Warm restart snapshot of the cached handles of an export
+ *
+ * When Snapshot_Dir is set, the wire handles of the entries mapped to an
+ * export are written out every Snapshot_Interval seconds and when the export
+ * is removed (which includes server shutdown), so that even an unclean stop
+ * leaves a recent snapshot behind.  Handles are saved hottest first.  When
+ * the export is created again, a background thread reads the snapshot back
+ * and looks each handle up through the sub-FSAL at no more than
+ * Snapshot_Load_Rate handles per second, so the cache is repopulated with
+ * the objects clients used last without flooding the backend.
+ *
+ * Only handles are saved.  Attributes and directory content would have to
+ * be revalidated against the backend after a restart anyway, so they are
+ * left to be fetched lazily on first use.
+ */
+
+#include "config.h"
+#include "fsal.h"
+#include "nfs_core.h"
+#include "export_mgr.h"
+#include "nfs_fh.h"
+#include "mdcache_int.h"
+#include "mdcache_lru.h"
+#include "fridgethr.h"
+#include <stdio.h>
+#include <unistd.h>
+
+#define MDC_SNAPSHOT_MAGIC 0x4d444353	/* "MDCS" */
+#define MDC_SNAPSHOT_VERSION 1
+
+/** Seconds to wait for the export to be published before giving up */
+#define MDC_SNAPSHOT_WAIT 30
+
+/** Recency classes entries are saved in, hottest first */
+#define MDC_SNAPSHOT_NCLASS 4
+
+struct mdc_snapshot_hdr {
+	uint32_t magic;
+	uint32_t version;
+	uint32_t export_id;
+	uint32_t count;
+};
+
+struct mdc_snapshot_arg {
+	uint16_t export_id;
+	char *path;
+};
+
+static char *mdc_snapshot_path(uint16_t export_id, const char *suffix)
+{
+	char *path;
+	int len;
+
+	len = snprintf(NULL, 0, "%s/mdcache.%u%s", mdcache_param.snapshot_dir,
+		       export_id, suffix);
+	path = gsh_malloc(len + 1);
+	(void) snprintf(path, len + 1, "%s/mdcache.%u%s",
+			mdcache_param.snapshot_dir, export_id, suffix);
+
+	return path;
+}
+
+/**
+ * @brief Rank an entry by how recently it was used
+ *
+ * Entries in use or on ACTIVE come first, then L1 and L2, then the rest.
+ * This is only a hint, the queue is read without the lane lock.
+ *
+ * @param[in] entry	Entry to rank
+ *
+ * @return Class, 0 is hottest.
+ */
+static int mdc_snapshot_class(mdcache_entry_t *entry)
+{
+	if (atomic_fetch_int32_t(&entry->lru.active_refcnt) > 0)
+		return 0;
+
+	switch (entry->lru.qid) {
+	case LRU_ENTRY_ACTIVE:
+		return 0;
+	case LRU_ENTRY_L1:
+		return 1;
+	case LRU_ENTRY_L2:
+		return 2;
+	default:
+		return 3;
+	}
+}
+
+/**
+ * @brief Append the handle of one entry to a snapshot
+ *
+ * Entries whose handle can't be encoded are skipped.
+ *
+ * @param[in] exp	Export being saved
+ * @param[in] entry	Entry to save, referenced by the caller
+ * @param[in] fp	Snapshot being written
+ * @param[in,out] count	Number of handles written
+ *
+ * @return 0, or the errno of a failed write.
+ */
+static int mdc_snapshot_write(struct mdcache_fsal_export *exp,
+			      mdcache_entry_t *entry, FILE *fp,
+			      uint32_t *count)
+{
+	char fh[NFS4_FHSIZE];
+	struct gsh_buffdesc fh_desc = {
+		.addr = fh,
+		.len = sizeof(fh),
+	};
+	uint16_t len;
+	fsal_status_t status;
+
+	subcall_raw(exp,
+		    status = entry->sub_handle->obj_ops->handle_to_wire(
+				entry->sub_handle, FSAL_DIGEST_NFSV4,
+				&fh_desc)
+		   );
+	if (FSAL_IS_ERROR(status))
+		return 0;
+
+	len = fh_desc.len;
+	if (fwrite(&len, sizeof(len), 1, fp) != 1 ||
+	    fwrite(fh_desc.addr, len, 1, fp) != 1)
+		return errno;
+
+	(*count)++;
+	return 0;
+}
+
+/**
+ * @brief Save the handles cached for an export
+ *
+ * Called periodically from the snapshot thread, and from unexport before
+ * the entries are unmapped.  The snapshot is written to a temporary file and
+ * renamed into place so that a crash in the middle never leaves a truncated
+ * snapshot behind.
+ *
+ * @param[in] exp	The export to save
+ */
+void mdcache_snapshot_save(struct mdcache_fsal_export *exp)
+{
+	uint16_t export_id = op_ctx->ctx_export->export_id;
+	struct entry_export_map *expmap;
+	struct glist_head *glist;
+	struct mdc_snapshot_hdr hdr;
+	mdcache_entry_t **entries[MDC_SNAPSHOT_NCLASS] = { NULL };
+	uint32_t nentries[MDC_SNAPSHOT_NCLASS] = { 0 };
+	uint32_t size[MDC_SNAPSHOT_NCLASS] = { 0 };
+	uint32_t i, hotter;
+	int c, write_err = 0;
+	char *tmp, *path;
+	FILE *fp;
+
+	if (mdcache_param.snapshot_dir == NULL ||
+	    mdcache_param.snapshot_max_entries == 0)
+		return;
+
+	tmp = mdc_snapshot_path(export_id, ".tmp");
+	path = mdc_snapshot_path(export_id, "");
+
+	fp = fopen(tmp, "w");
+	if (fp == NULL) {
+		LogWarn(COMPONENT_MDCACHE,
+			"Could not create cache snapshot %s: %s",
+			tmp, strerror(errno));
+		goto out;
+	}
+
+	memset(&hdr, 0, sizeof(hdr));
+	hdr.magic = MDC_SNAPSHOT_MAGIC;
+	hdr.version = MDC_SNAPSHOT_VERSION;
+	hdr.export_id = export_id;
+
+	/* Header is rewritten with the real count at the end */
+	if (fwrite(&hdr, sizeof(hdr), 1, fp) != 1)
+		goto err;
+
+	/* Take a ref on each entry under the export lock, so none of them can
+	 * be cleaned (and lose its sub-handle) while we work on it, then build
+	 * and write the handles with the lock dropped.  Entries are sorted by
+	 * recency class, and a class stops growing once it and the hotter ones
+	 * hold enough entries to fill the snapshot.
+	 */
+	PTHREAD_RWLOCK_rdlock(&exp->mdc_exp_lock);
+
+	glist_for_each(glist, &exp->entry_list) {
+		mdcache_entry_t *entry;
+
+		expmap = glist_entry(glist, struct entry_export_map,
+				     entry_per_export);
+		entry = expmap->entry;
+
+		if ((atomic_fetch_uint32_t(&entry->lru.flags) &
+		     (LRU_CLEANUP | LRU_CLEANED)) ||
+		    (atomic_fetch_uint32_t(&entry->mde_flags) &
+		     MDCACHE_UNREACHABLE))
+			continue;
+
+		c = mdc_snapshot_class(entry);
+
+		for (i = 0, hotter = 0; i <= c; i++)
+			hotter += nentries[i];
+
+		if (hotter >= mdcache_param.snapshot_max_entries)
+			continue;
+
+		if (nentries[c] == size[c]) {
+			size[c] = size[c] ? size[c] * 2 : 1024;
+			entries[c] = gsh_realloc(entries[c],
+						 size[c] * sizeof(*entries[c]));
+		}
+
+		mdcache_lru_ref(entry, LRU_ACTIVE_REF);
+		entries[c][nentries[c]++] = entry;
+	}
+
+	PTHREAD_RWLOCK_unlock(&exp->mdc_exp_lock);
+
+	/* Write out the hottest classes first, up to the limit */
+	for (c = 0; c < MDC_SNAPSHOT_NCLASS; c++) {
+		for (i = 0; i < nentries[c]; i++) {
+			if (write_err == 0 &&
+			    hdr.count < mdcache_param.snapshot_max_entries)
+				write_err = mdc_snapshot_write(exp,
+							       entries[c][i],
+							       fp, &hdr.count);
+
+			mdcache_lru_unref(entries[c][i], LRU_ACTIVE_REF);
+		}
+
+		gsh_free(entries[c]);
+	}
+
+	if (write_err) {
+		errno = write_err;
+		goto err;
+	}
+
+	if (fseek(fp, 0, SEEK_SET) != 0 ||
+	    fwrite(&hdr, sizeof(hdr), 1, fp) != 1)
+		goto err;
+
+	if (fclose(fp) != 0) {
+		fp = NULL;
+		goto err;
+	}
+
+	if (rename(tmp, path) != 0) {
+		fp = NULL;
+		goto err;
+	}
+
+	LogInfo(COMPONENT_MDCACHE,
+		"Saved %"PRIu32" cached handles for export %u to %s",
+		hdr.count, export_id, path);
+	goto out;
+
+err:
+	LogWarn(COMPONENT_MDCACHE,
+		"Could not write cache snapshot %s: %s",
+		tmp, strerror(errno));
+	if (fp != NULL)
+		fclose(fp);
+	(void) unlink(tmp);
+
+out:
+	gsh_free(tmp);
+	gsh_free(path);
+}
+
+/**
+ * @brief Warm the cache of an export from its snapshot
+ *
+ * Runs detached.  Waits for the export to be published, then looks up the
+ * saved handles, hottest first, pausing for a second after every
+ * Snapshot_Load_Rate of them so a large snapshot trickles in instead of
+ * hammering the backend.  Handles that are stale are silently skipped.  The
+ * snapshot was moved aside before this started and is removed when done; a
+ * new one is written by the snapshot thread and on unexport.
+ *
+ * @param[in] arg	struct mdc_snapshot_arg
+ */
+static void *mdc_snapshot_thread(void *arg)
+{
+	struct mdc_snapshot_arg *sarg = arg;
+	struct gsh_export *export = NULL;
+	struct mdcache_fsal_export *exp;
+	struct fsal_export *sub_export;
+	struct req_op_context op_context;
+	struct mdc_snapshot_hdr hdr;
+	uint32_t i, loaded = 0;
+	FILE *fp;
+	int wait;
+#if (BYTE_ORDER == BIG_ENDIAN)
+	int fh_flags = FH_FSAL_BIG_ENDIAN;
+#else
+	int fh_flags = 0;
+#endif
+
+	SetNameFunction("mdc_snapshot");
+	rcu_register_thread();
+
+	fp = fopen(sarg->path, "r");
+	if (fp == NULL)
+		goto out;
+
+	if (fread(&hdr, sizeof(hdr), 1, fp) != 1 ||
+	    hdr.magic != MDC_SNAPSHOT_MAGIC ||
+	    hdr.version != MDC_SNAPSHOT_VERSION ||
+	    hdr.export_id != sarg->export_id) {
+		LogWarn(COMPONENT_MDCACHE,
+			"Ignoring invalid cache snapshot %s", sarg->path);
+		goto close;
+	}
+
+	for (wait = 0; wait < MDC_SNAPSHOT_WAIT && !admin_shutdown; wait++) {
+		export = get_gsh_export(sarg->export_id);
+		if (export != NULL)
+			break;
+		sleep(1);
+	}
+
+	if (export == NULL)
+		goto close;
+
+	if (export->fsal_export->fsal != &MDCACHE.module) {
+		put_gsh_export(export);
+		goto close;
+	}
+
+	init_op_context_simple(&op_context, export, export->fsal_export);
+	exp = mdc_cur_export();
+	sub_export = exp->mfe_exp.sub_export;
+
+	for (i = 0; i < hdr.count; i++) {
+		char fh[NFS4_FHSIZE];
+		struct gsh_buffdesc fh_desc = { .addr = fh };
+		mdcache_entry_t *entry;
+		fsal_status_t status;
+		uint16_t len;
+
+		if (admin_shutdown ||
+		    (atomic_fetch_uint8_t(&exp->flags) & MDC_UNEXPORT))
+			break;
+
+		if (mdcache_param.snapshot_load_rate != 0 && i != 0 &&
+		    i % mdcache_param.snapshot_load_rate == 0)
+			sleep(1);
+
+		if (fread(&len, sizeof(len), 1, fp) != 1 ||
+		    len > sizeof(fh) ||
+		    fread(fh, len, 1, fp) != 1)
+			break;
+
+		fh_desc.len = len;
+
+		/* The snapshot holds wire handles, and lookups want host
+		 * handles.
+		 */
+		subcall_raw(exp,
+			    status = sub_export->exp_ops.wire_to_host(
+					sub_export, FSAL_DIGEST_NFSV4,
+					&fh_desc, fh_flags)
+			   );
+		if (FSAL_IS_ERROR(status))
+			continue;
+
+		status = mdcache_locate_host(&fh_desc, exp, &entry, NULL);
+		if (FSAL_IS_ERROR(status))
+			continue;
+
+		mdcache_lru_unref(entry, LRU_ACTIVE_REF);
+		loaded++;
+	}
+
+	release_op_context();
+
+	LogEvent(COMPONENT_MDCACHE,
+		 "Warmed %"PRIu32" of %"PRIu32" cached handles for export %u",
+		 loaded, hdr.count, sarg->export_id);
+
+close:
+	fclose(fp);
+	(void) unlink(sarg->path);
+
+out:
+	rcu_unregister_thread();
+	gsh_free(sarg->path);
+	gsh_free(sarg);
+	return NULL;
+}
+
+/**
+ * @brief Start warming an export from its snapshot, if there is one
+ *
+ * Called from create_export.  The export is not published yet, so the
+ * work is handed off to a detached thread.  The snapshot is first renamed
+ * out of the way, so the snapshot thread of the new export can't replace it
+ * with a nearly empty one while it is still being read.
+ */
+void mdcache_snapshot_load(void)
+{
+	struct mdc_snapshot_arg *sarg;
+	char *path;
+	pthread_attr_t attr;
+	pthread_t tid;
+	int rc;
+
+	if (mdcache_param.snapshot_dir == NULL ||
+	    mdcache_param.snapshot_max_entries == 0)
+		return;
+
+	sarg = gsh_malloc(sizeof(*sarg));
+	sarg->export_id = op_ctx->ctx_export->export_id;
+	path = mdc_snapshot_path(sarg->export_id, "");
+	sarg->path = mdc_snapshot_path(sarg->export_id, ".load");
+
+	rc = rename(path, sarg->path);
+	gsh_free(path);
+
+	if (rc != 0) {
+		gsh_free(sarg->path);
+		gsh_free(sarg);
+		return;
+	}
+
+	PTHREAD_ATTR_init(&attr);
+	PTHREAD_ATTR_setdetachstate(&attr, PTHREAD_CREATE_DETACHED);
+
+	rc = pthread_create(&tid, &attr, mdc_snapshot_thread, sarg);
+	if (rc != 0) {
+		LogWarn(COMPONENT_MDCACHE,
+			"Could not start cache snapshot thread: %s",
+			strerror(rc));
+		gsh_free(sarg->path);
+		gsh_free(sarg);
+	}
+
+	PTHREAD_ATTR_destroy(&attr);
+}
+
+/**
+ * @brief Periodically save the cache of an export
+ *
+ * Looper for the per-export snapshot fridge.  Does nothing until the export
+ * has been published and Snapshot_Interval has passed since the last save.
+ *
+ * @param[in] ctx	Fridge context, arg is the export
+ */
+static void mdc_snapshot_run(struct fridgethr_context *ctx)
+{
+	struct mdcache_fsal_export *exp = ctx->arg;
+	struct gsh_export *export;
+	struct req_op_context op_context;
+	time_t now = time(NULL);
+
+	if (now - exp->snapshot_time < mdcache_param.snapshot_interval ||
+	    (atomic_fetch_uint8_t(&exp->flags) & MDC_UNEXPORT))
+		return;
+
+	export = get_gsh_export(exp->snapshot_export_id);
+	if (export == NULL)
+		return;
+
+	if (export->fsal_export != &exp->mfe_exp) {
+		put_gsh_export(export);
+		return;
+	}
+
+	init_op_context_simple(&op_context, export, export->fsal_export);
+	mdcache_snapshot_save(exp);
+	release_op_context();
+
+	exp->snapshot_time = now;
+}
+
+/**
+ * @brief Start the periodic snapshots of an export
+ *
+ * Called from create_export, with op_ctx set for the new export.
+ *
+ * @param[in] exp	The export being created
+ */
+void mdcache_snapshot_start(struct mdcache_fsal_export *exp)
+{
+	struct fridgethr_params frp;
+	int rc;
+
+	if (mdcache_param.snapshot_dir == NULL ||
+	    mdcache_param.snapshot_max_entries == 0 ||
+	    mdcache_param.snapshot_interval == 0)
+		return;
+
+	exp->snapshot_export_id = op_ctx->ctx_export->export_id;
+	exp->snapshot_time = time(NULL);
+
+	memset(&frp, 0, sizeof(struct fridgethr_params));
+	frp.thr_max = 1;
+	frp.thr_min = 1;
+	frp.thread_delay = mdcache_param.snapshot_interval;
+	frp.flavor = fridgethr_flavor_looper;
+
+	rc = fridgethr_init(&exp->snapshot_fridge, exp->name, &frp);
+	if (rc != 0) {
+		LogWarn(COMPONENT_MDCACHE,
+			"Unable to initialize %s snapshot fridge, error code %d.",
+			exp->name, rc);
+		return;
+	}
+
+	rc = fridgethr_submit(exp->snapshot_fridge, mdc_snapshot_run, exp);
+	if (rc != 0) {
+		LogWarn(COMPONENT_MDCACHE,
+			"Unable to start %s snapshot thread, error code %d.",
+			exp->name, rc);
+		fridgethr_destroy(exp->snapshot_fridge);
+		exp->snapshot_fridge = NULL;
+	}
+}
+
+/**
+ * @brief Stop the periodic snapshots of an export
+ *
+ * Called from unexport, before the final save, and from release.
+ *
+ * @param[in] exp	The export being removed
+ */
+void mdcache_snapshot_stop(struct mdcache_fsal_export *exp)
+{
+	int rc;
+
+	if (exp->snapshot_fridge == NULL)
+		return;
+
+	/* Wait for a save in progress rather than cancel it, it holds refs on
+	 * the entries it is writing out.
+	 */
+	rc = fridgethr_sync_command(exp->snapshot_fridge, fridgethr_comm_stop,
+				    0);
+
+	if (rc != 0) {
+		LogMajor(COMPONENT_MDCACHE,
+			 "Failed shutting down snapshot thread: %d", rc);
+	}
+
+	fridgethr_destroy(exp->snapshot_fridge);
+	exp->snapshot_fridge = NULL;
+}
+
+/** @} */
@@ -82,7 +82,7 @@ mdc_up_invalidate(const struct fsal_up_vector *vec, struct gsh_buffdesc *handle,
 	    entry->obj_handle.type == DIRECTORY) {
 		PTHREAD_RWLOCK_wrlock(&entry->content_lock);
 		/* Clean up parent key */
-		mdcache_free_fh(&entry->fsobj.fsdir.parent);
+		mdcache_free_fh(&entry->fsobj.fsdir->parent);
 		PTHREAD_RWLOCK_unlock(&entry->content_lock);
 	}
 
@@ -94,6 +94,60 @@ out:
 	return status;
 }
 
+/** Grant or revoke an attribute lease on a cache entry
+ *
+ * @param[in] vec    Up ops vector
+ * @param[in] handle Handle-key of the entry
+ * @param[in] grant  true to grant the lease, false to revoke it
+ *
+ * @return FSAL status. ERR_FSAL_NOENT if the entry is not cached.
+ */
+static fsal_status_t
+mdc_up_attr_lease(const struct fsal_up_vector *vec,
+		  struct gsh_buffdesc *handle, bool grant)
+{
+	mdcache_entry_t *entry;
+	fsal_status_t status;
+	struct req_op_context op_context;
+	mdcache_key_t key;
+
+	/* Get a ref to the vec->up_gsh_export and initialize op_context for the
+	 * upcall
+	 */
+	get_gsh_export_ref(vec->up_gsh_export);
+	init_op_context_simple(&op_context, vec->up_gsh_export,
+			       vec->up_fsal_export);
+
+	key.fsal = vec->up_fsal_export->sub_export->fsal;
+	cih_hash_key(&key, vec->up_fsal_export->sub_export->fsal, handle,
+		     CIH_HASH_KEY_PROTOTYPE);
+
+	status = mdcache_find_keyed_reason(&key, &entry, LRU_ACTIVE_REF);
+	if (FSAL_IS_ERROR(status))
+		goto out;
+
+	if (grant) {
+		atomic_set_uint32_t_bits(&entry->mde_flags,
+					 MDCACHE_ATTR_LEASE);
+	} else {
+		/* Without the lease, attributes refreshed while it was held
+		 * may already be past their expiry, which is fine.
+		 */
+		atomic_clear_uint32_t_bits(&entry->mde_flags,
+					   MDCACHE_ATTR_LEASE);
+	}
+
+	LogFullDebug(COMPONENT_MDCACHE, "%s attribute lease on entry %p",
+		     grant ? "Granted" : "Revoked", entry);
+
+	mdcache_lru_unref(entry, LRU_ACTIVE_REF);
+
+out:
+
+	release_op_context();
+	return status;
+}
+
 /** Release a cache entry if it's otherwise idle.
  *
  * @param[in] vec    Up ops vector
@@ -603,6 +657,7 @@ mdcache_export_up_ops_init(struct fsal_up_vector *my_up_ops,
 	my_up_ops->update = mdc_up_update;
 	my_up_ops->invalidate_close = mdc_up_invalidate_close;
 	my_up_ops->try_release = mdc_up_try_release;
+	my_up_ops->attr_lease = mdc_up_attr_lease;
 
 	/* These are pass-through calls that set op_ctx */
 	my_up_ops->lock_grant = mdc_up_lock_grant;
@@ -1484,6 +1484,128 @@ static bool is_referral(struct fsal_obj_handle *obj_hdl,
 	return false;
 }
 
+/* encoded_attrs_get
+ * default case nothing cached
+ */
+static bool encoded_attrs_get(struct fsal_obj_handle *obj_hdl,
+			      const struct gsh_buffdesc *key,
+			      struct gsh_buffdesc *val)
+{
+	return false;
+}
+
+/* encoded_attrs_put
+ * default case do not cache
+ */
+static void encoded_attrs_put(struct fsal_obj_handle *obj_hdl,
+			      const struct gsh_buffdesc *key,
+			      const struct gsh_buffdesc *val)
+{
+}
+
+/* Size of the bounce buffer used by the copy fallback */
+#define COPY_BUFSIZE (1024 * 1024)
+
+/* copy
+ * default case copy through read2 and write2
+ */
+static fsal_status_t copy(struct fsal_obj_handle *src_hdl,
+			  struct state_t *src_state,
+			  uint64_t src_offset,
+			  struct fsal_obj_handle *dst_hdl,
+			  struct state_t *dst_state,
+			  uint64_t dst_offset,
+			  uint64_t count,
+			  uint64_t *copied)
+{
+	pthread_mutex_t mutex;
+	pthread_cond_t cond;
+	struct async_process_data data = {
+		.fsa_mutex = &mutex,
+		.fsa_cond = &cond,
+	};
+	struct fsal_io_arg *read_arg, *write_arg;
+	fsal_status_t status = {0, 0};
+	size_t len, done;
+	char *buf;
+
+	*copied = 0;
+
+	PTHREAD_MUTEX_init(&mutex, NULL);
+	PTHREAD_COND_init(&cond, NULL);
+
+	buf = gsh_malloc(MIN(count, COPY_BUFSIZE));
+	read_arg = alloca(sizeof(*read_arg) + sizeof(struct iovec));
+	write_arg = alloca(sizeof(*write_arg) + sizeof(struct iovec));
+
+	while (*copied < count) {
+		len = MIN(count - *copied, COPY_BUFSIZE);
+
+		memset(read_arg, 0, sizeof(*read_arg));
+		read_arg->state = src_state;
+		read_arg->offset = src_offset + *copied;
+		read_arg->iov_count = 1;
+		read_arg->iov[0].iov_base = buf;
+		read_arg->iov[0].iov_len = len;
+
+		data.done = false;
+		fsal_read(src_hdl, false, read_arg, &data);
+
+		status = data.ret;
+		if (FSAL_IS_ERROR(status) || read_arg->io_amount == 0)
+			break;
+
+		/* Push out everything that was read */
+		for (done = 0; done < read_arg->io_amount;
+		     done += write_arg->io_amount) {
+			memset(write_arg, 0, sizeof(*write_arg));
+			write_arg->state = dst_state;
+			write_arg->offset = dst_offset + *copied + done;
+			write_arg->iov_count = 1;
+			write_arg->iov[0].iov_base = buf + done;
+			write_arg->iov[0].iov_len =
+				read_arg->io_amount - done;
+
+			data.done = false;
+			fsal_write(dst_hdl, false, write_arg, &data);
+
+			status = data.ret;
+			if (FSAL_IS_ERROR(status))
+				goto out;
+			if (write_arg->io_amount == 0) {
+				status = fsalstat(ERR_FSAL_IO, 0);
+				goto out;
+			}
+		}
+
+		*copied += read_arg->io_amount;
+
+		if (read_arg->end_of_file)
+			break;
+	}
+
+out:
+	gsh_free(buf);
+	PTHREAD_COND_destroy(&cond);
+	PTHREAD_MUTEX_destroy(&mutex);
+
+	return status;
+}
+
+/* clone
+ * default case not supported, the client copies instead
+ */
+static fsal_status_t file_clone(struct fsal_obj_handle *src_hdl,
+				struct state_t *src_state,
+				uint64_t src_offset,
+				struct fsal_obj_handle *dst_hdl,
+				struct state_t *dst_state,
+				uint64_t dst_offset,
+				uint64_t count)
+{
+	return fsalstat(ERR_FSAL_NOTSUPP, ENOTSUP);
+}
+
 /* Default fsal handle object method vector.
  * copied to allocated vector at register time
  */
@@ -1541,6 +1663,10 @@ struct fsal_obj_ops def_handle_ops = {
 	.setattr2 = setattr2,
 	.close2 = close2,
 	.is_referral = is_referral,
+	.encoded_attrs_get = encoded_attrs_get,
+	.encoded_attrs_put = encoded_attrs_put,
+	.copy = copy,
+	.clone = file_clone,
 };
 
 /* fsal_pnfs_ds common methods */
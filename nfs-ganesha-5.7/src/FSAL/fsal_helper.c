@@ -1280,8 +1280,11 @@ populate_dirent(const char *name,
 
 out:
 
-	/* Put the ref on obj that readdir took */
-	obj->obj_ops->put_ref(obj);
+	/* Put the ref on obj that readdir took, entries served from dirent
+	 * metadata alone (ATTR_DIRENT_ONLY) come without one.
+	 */
+	if (obj != NULL)
+		obj->obj_ops->put_ref(obj);
 
 	return retval;
 }
@@ -1350,7 +1353,7 @@ fsal_status_t fsal_readdir(struct fsal_obj_handle *directory,
 			 fsal_err_txt(fsal_status));
 		return fsal_status;
 	}
-	if (attrmask != 0) {
+	if ((attrmask & ~ATTR_DIRENT_ONLY) != 0) {
 		/* Check for access permission to get attributes */
 		fsal_status_t attr_status = fsal_access(directory,
 							access_mask_attr);
@@ -1982,6 +1982,21 @@ static fsal_status_t try_release(const struct fsal_up_vector *vec,
 	return fsalstat(ERR_FSAL_NOTSUPP, 0);
 }
 
+/**
+ * @brief Grant or revoke an attribute lease
+ *
+ * @param[in] vec    Up ops vector
+ * @param[in] handle Handle-key of the object
+ * @param[in] grant  true to grant, false to revoke
+ *
+ * @return ERR_FSAL_NOTSUPP, there is no cache to hold the lease
+ */
+static fsal_status_t attr_lease(const struct fsal_up_vector *vec,
+				struct gsh_buffdesc *handle, bool grant)
+{
+	return fsalstat(ERR_FSAL_NOTSUPP, 0);
+}
+
 /**
  * @brief The top level vector of operations
  *
@@ -2002,6 +2017,7 @@ struct fsal_up_vector fsal_up_top = {
 	.delegrecall = delegrecall,
 	.invalidate_close = invalidate_close,
 	.try_release = try_release,
+	.attr_lease = attr_lease,
 };
 
 /** @} */
@@ -58,6 +58,7 @@
 #endif
 #include "conf_url.h"
 #include "nfs_rpc_callback.h"
+#include "nfs_proto_functions.h"
 
 /**
  * @brief Mutex protecting shutdown flag.
@@ -751,6 +752,9 @@ static void do_shutdown(void)
 	delayed_shutdown();
 	LogEvent(COMPONENT_MAIN, "Delayed executor stopped.");
 
+	LogEvent(COMPONENT_MAIN, "Stopping asynchronous copy threads");
+	nfs4_copy_pkgshutdown();
+
 	LogEvent(COMPONENT_MAIN, "Stopping state asynchronous request thread");
 	rc = state_async_shutdown();
 	if (rc != 0) {
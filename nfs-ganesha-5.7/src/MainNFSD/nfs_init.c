@@ -349,7 +349,8 @@ void nfs_print_param_config(void)
 #endif
 	printf("\tNFS_Program = %u ;\n", nfs_param.core_param.program[P_NFS]);
 	printf("\tMNT_Program = %u ;\n", nfs_param.core_param.program[P_NFS]);
-	printf("\tDRC_TCP_Npart = %u ;\n", nfs_param.core_param.drc.tcp.npart);
+	printf("\tDRC_Max_Memory = %" PRIu64 " ;\n",
+	       nfs_param.core_param.drc.max_memory);
 	printf("\tDRC_TCP_Size = %u ;\n", nfs_param.core_param.drc.tcp.size);
 	printf("\tDRC_TCP_Cachesz = %u ;\n",
 	       nfs_param.core_param.drc.tcp.cachesz);
@@ -891,6 +892,12 @@ static void nfs_Init(const nfs_start_info_t *p_start_info)
 	/* Save Ganesha thread credentials with Frank's routine for later use */
 	fsal_save_ganesha_credentials();
 
+	/* Worker priority classes, before any request can come in */
+	nfs_rpc_bulk_pkginit();
+
+	/* NFSv4 COMPOUND object pools */
+	nfs4_compound_pkginit();
+
 	/* RPC Initialisation - exits on failure */
 	nfs_Init_svc();
 	LogInfo(COMPONENT_INIT, "RPC resources successfully initialized");
@@ -900,6 +907,9 @@ static void nfs_Init(const nfs_start_info_t *p_start_info)
 
 	/* callback dispatch */
 	nfs_rpc_cb_pkginit();
+
+	/* asynchronous COPY */
+	nfs4_copy_pkginit();
 #ifdef _USE_CB_SIMULATOR
 	nfs_rpc_cbsim_pkginit();
 #endif				/*  _USE_CB_SIMULATOR */
@@ -103,10 +103,16 @@ enum evchan {
 
 static struct rpc_evchan rpc_evchan[EVCHAN_SIZE];
 
+/* Event channels for the additional TCP listeners, see RPC_Listen_Shards.
+ * Shard 0 is the primary listener on TCP_UREG_CHAN.
+ */
+static struct rpc_evchan tcp_shard_evchan[RPC_LISTEN_SHARDS_MAX];
+
 static enum xprt_stat nfs_rpc_tcp_user_data(SVCXPRT *);
 static enum xprt_stat nfs_rpc_free_user_data(SVCXPRT *);
 static struct svc_req *alloc_nfs_request(SVCXPRT *xprt, XDR *xdrs);
 static void free_nfs_request(struct svc_req *req, enum xprt_stat stat);
+static int tcp_socket_setopts(int fd, protos p);
 
 const char *xprt_stat_s[XPRT_DESTROYED + 1] = {
 	"XPRT_IDLE",
@@ -176,6 +182,15 @@ int tcp_socket[P_COUNT];
 SVCXPRT *udp_xprt[P_COUNT];
 SVCXPRT *tcp_xprt[P_COUNT];
 
+/* Additional SO_REUSEPORT listeners, index 0 is tcp_socket/tcp_xprt */
+static int tcp_shard_socket[P_COUNT][RPC_LISTEN_SHARDS_MAX];
+static SVCXPRT *tcp_shard_xprt[P_COUNT][RPC_LISTEN_SHARDS_MAX];
+
+/* Requests kept for reuse by each thread, see alloc_nfs_request() */
+#define NFS_REQUEST_CACHE_MAX 32
+
+static pool_t *nfs_request_pool;
+
 /* Flag to indicate if V6 interfaces on the host are enabled */
 bool v6disabled;
 bool vsock;
@@ -290,6 +305,7 @@ static inline bool nfs_protocol_enabled(protos p)
 static void close_rpc_fd(void)
 {
 	protos p;
+	uint32_t i;
 
 	for (p = P_NFS; p < P_COUNT; p++) {
 		if (udp_socket[p] != -1)
@@ -300,6 +316,12 @@ static void close_rpc_fd(void)
 			close(tcp_socket[p]);
 		if (tcp_xprt[p])
 			SVC_DESTROY(tcp_xprt[p]);
+		for (i = 1; i < nfs_param.core_param.rpc.listen_shards; i++) {
+			if (tcp_shard_socket[p][i] != -1)
+				close(tcp_shard_socket[p][i]);
+			if (tcp_shard_xprt[p][i])
+				SVC_DESTROY(tcp_shard_xprt[p][i]);
+		}
 	}
 	/* no need for special tcp_xprt[P_NFS_VSOCK] treatment */
 }
@@ -532,6 +554,50 @@ void Create_tcp(protos prot)
 				  tcp_xprt[prot], SVC_RQST_FLAG_XPRT_UREG);
 }
 
+/**
+ * @brief Create the SVCXPRTs for the additional TCP listeners of a protocol
+ *
+ * Each listener is polled by its own event channel, so that accepts are
+ * not serialized behind a single rendezvous transport.  The connections
+ * they accept are spread over the TCP event channels as usual.
+ *
+ * @param[in] prot	Protocol
+ */
+static void Create_tcp_shards(protos prot)
+{
+	uint32_t i;
+	SVCXPRT *xprt;
+
+	for (i = 1; i < nfs_param.core_param.rpc.listen_shards; i++) {
+		if (tcp_shard_socket[prot][i] == -1)
+			continue;
+
+		xprt = svc_vc_ncreatef(tcp_shard_socket[prot][i],
+				nfs_param.core_param.rpc.max_send_buffer_size,
+				nfs_param.core_param.rpc.max_recv_buffer_size,
+				SVC_CREATE_FLAG_CLOSE | SVC_CREATE_FLAG_LISTEN);
+		if (xprt == NULL) {
+			LogWarn(COMPONENT_DISPATCH,
+				"Cannot allocate %s/TCP SVCXPRT for listener %"
+				PRIu32, tags[prot], i);
+			continue;
+		}
+
+		/* SVC_CREATE_FLAG_CLOSE, the xprt owns the fd now */
+		tcp_shard_socket[prot][i] = -1;
+		tcp_shard_xprt[prot][i] = xprt;
+
+		xprt->xp_dispatch.rendezvous_cb = tcp_dispatch[prot];
+
+		/* Hook xp_free_user_data (finalize/free private data) */
+		(void)SVC_CONTROL(xprt, SVCSET_XP_FREE_USER_DATA,
+				  nfs_rpc_free_user_data);
+
+		(void)svc_rqst_evchan_reg(tcp_shard_evchan[i].chan_id,
+					  xprt, SVC_RQST_FLAG_XPRT_UREG);
+	}
+}
+
 #ifdef _USE_NFS_RDMA
 struct rpc_rdma_attr rpc_rdma_xa = {
 	.statistics_prefix = NULL,
@@ -590,6 +656,7 @@ void Create_SVCXPRTs(void)
 		if (nfs_protocol_enabled(p)) {
 			Create_udp(p);
 			Create_tcp(p);
+			Create_tcp_shards(p);
 		}
 #ifdef RPC_VSOCK
 	if (vsock)
@@ -897,6 +964,70 @@ int bind_sockets_vsock(void)
 }
 #endif /* RPC_VSOCK */
 
+/**
+ * @brief Allocate and bind the additional tcp listeners
+ *
+ * They are bound to the address the primary listener of each protocol got,
+ * relying on SO_REUSEPORT.  That is read back from the primary socket: with
+ * the configured port 0 (the default for MNT and NLM) the kernel picked
+ * one, and each shard must share it rather than get another.  Failing here
+ * is not fatal, the protocol is just served by fewer listeners.
+ */
+static void Bind_tcp_shards(void)
+{
+	protos p;
+	uint32_t i;
+	int fd;
+
+	for (p = P_NFS; p < P_COUNT; p++) {
+		proto_data *pdatap = &pdata[p];
+		sockaddr_t addr;
+		socklen_t alen = sizeof(addr);
+
+		if (!nfs_protocol_enabled(p))
+			continue;
+
+		if (getsockname(tcp_socket[p], (struct sockaddr *)&addr,
+				&alen) == -1) {
+			LogWarn(COMPONENT_DISPATCH,
+				"Cannot get the %s tcp listener address, error %d(%s)",
+				tags[p], errno, strerror(errno));
+			continue;
+		}
+
+		for (i = 1; i < nfs_param.core_param.rpc.listen_shards; i++) {
+			fd = socket(pdatap->si_tcp6.si_af, SOCK_STREAM,
+				    IPPROTO_TCP);
+			if (fd == -1) {
+				LogWarn(COMPONENT_DISPATCH,
+					"Cannot allocate a tcp socket for %s, error %d(%s)",
+					tags[p], errno, strerror(errno));
+				break;
+			}
+
+			if (tcp_socket_setopts(fd, p)) {
+				close(fd);
+				break;
+			}
+
+			if (bind(fd, (struct sockaddr *)&addr, alen) == -1) {
+				LogWarn(COMPONENT_DISPATCH,
+					"Cannot bind %s tcp listener %"PRIu32
+					", error %d(%s)",
+					tags[p], i, errno, strerror(errno));
+				close(fd);
+				break;
+			}
+
+			tcp_shard_socket[p][i] = fd;
+		}
+
+		LogInfo(COMPONENT_DISPATCH,
+			"%s is served by %"PRIu32" tcp listeners",
+			tags[p], i);
+	}
+}
+
 void Bind_sockets(void)
 {
 	int rc = 0;
@@ -916,6 +1047,8 @@ void Bind_sockets(void)
 			LogFatal(COMPONENT_DISPATCH,
 				 "Error binding to V6 interface. Cannot continue.");
 	}
+	if (nfs_param.core_param.rpc.listen_shards > 1)
+		Bind_tcp_shards();
 #ifdef RPC_VSOCK
 	if (vsock) {
 		rc = bind_sockets_vsock();
@@ -930,30 +1063,17 @@ void Bind_sockets(void)
 }
 
 /**
- * @brief Function to set the socket options on the allocated
- *	  udp and tcp sockets
+ * @brief Function to set the socket options on a tcp listener socket
  *
+ * Shared by the primary listener and the RPC_Listen_Shards ones, which all
+ * bind the same address and so need SO_REUSEPORT.
  */
-static int alloc_socket_setopts(int p)
+static int tcp_socket_setopts(int fd, protos p)
 {
 	int one = 1;
 	const struct nfs_core_param *nfs_cp = &nfs_param.core_param;
 
-	/* Use SO_REUSEADDR in order to avoid wait
-	 * the 2MSL timeout */
-	if (udp_socket[p] != -1) {
-		if (setsockopt(udp_socket[p],
-			       SOL_SOCKET, SO_REUSEADDR,
-			       &one, sizeof(one))) {
-			LogWarn(COMPONENT_DISPATCH,
-				"Bad udp socket options for %s, error %d(%s)",
-				tags[p], errno, strerror(errno));
-
-			return -1;
-		}
-	}
-
-	if (setsockopt(tcp_socket[p],
+	if (setsockopt(fd,
 		       SOL_SOCKET, SO_REUSEADDR,
 		       &one, sizeof(one))) {
 		LogWarn(COMPONENT_DISPATCH,
@@ -963,8 +1083,20 @@ static int alloc_socket_setopts(int p)
 		return -1;
 	}
 
+	if (nfs_cp->rpc.listen_shards > 1) {
+		if (setsockopt(fd,
+			       SOL_SOCKET, SO_REUSEPORT,
+			       &one, sizeof(one))) {
+			LogWarn(COMPONENT_DISPATCH,
+				"Bad tcp socket option reuseport for %s, error %d(%s)",
+				tags[p], errno, strerror(errno));
+
+			return -1;
+		}
+	}
+
 	if (nfs_cp->enable_tcp_keepalive) {
-		if (setsockopt(tcp_socket[p],
+		if (setsockopt(fd,
 			       SOL_SOCKET, SO_KEEPALIVE,
 			       &one, sizeof(one))) {
 			LogWarn(COMPONENT_DISPATCH,
@@ -975,7 +1107,7 @@ static int alloc_socket_setopts(int p)
 		}
 
 		if (nfs_cp->tcp_keepcnt) {
-			if (setsockopt(tcp_socket[p], IPPROTO_TCP, TCP_KEEPCNT,
+			if (setsockopt(fd, IPPROTO_TCP, TCP_KEEPCNT,
 				       &nfs_cp->tcp_keepcnt,
 				       sizeof(nfs_cp->tcp_keepcnt))) {
 				LogWarn(COMPONENT_DISPATCH,
@@ -987,7 +1119,7 @@ static int alloc_socket_setopts(int p)
 		}
 
 		if (nfs_cp->tcp_keepidle) {
-			if (setsockopt(tcp_socket[p], IPPROTO_TCP, TCP_KEEPIDLE,
+			if (setsockopt(fd, IPPROTO_TCP, TCP_KEEPIDLE,
 				       &nfs_cp->tcp_keepidle,
 				       sizeof(nfs_cp->tcp_keepidle))) {
 				LogWarn(COMPONENT_DISPATCH,
@@ -999,7 +1131,7 @@ static int alloc_socket_setopts(int p)
 		}
 
 		if (nfs_cp->tcp_keepintvl) {
-			if (setsockopt(tcp_socket[p], IPPROTO_TCP,
+			if (setsockopt(fd, IPPROTO_TCP,
 				       TCP_KEEPINTVL, &nfs_cp->tcp_keepintvl,
 				       sizeof(nfs_cp->tcp_keepintvl))) {
 				LogWarn(COMPONENT_DISPATCH,
@@ -1011,6 +1143,35 @@ static int alloc_socket_setopts(int p)
 		}
 	}
 
+	return 0;
+}
+
+/**
+ * @brief Function to set the socket options on the allocated
+ *	  udp and tcp sockets
+ *
+ */
+static int alloc_socket_setopts(int p)
+{
+	int one = 1;
+
+	/* Use SO_REUSEADDR in order to avoid wait
+	 * the 2MSL timeout */
+	if (udp_socket[p] != -1) {
+		if (setsockopt(udp_socket[p],
+			       SOL_SOCKET, SO_REUSEADDR,
+			       &one, sizeof(one))) {
+			LogWarn(COMPONENT_DISPATCH,
+				"Bad udp socket options for %s, error %d(%s)",
+				tags[p], errno, strerror(errno));
+
+			return -1;
+		}
+	}
+
+	if (tcp_socket_setopts(tcp_socket[p], p))
+		return -1;
+
 	if (udp_socket[p] != -1) {
 		/* We prefer using non-blocking socket
 		 * in the specific case */
@@ -1119,6 +1280,7 @@ static void Allocate_sockets(void)
 {
 	protos	p;
 	int	rc = 0;
+	int	i;
 
 	LogFullDebug(COMPONENT_DISPATCH, "Allocation of the sockets");
 
@@ -1126,6 +1288,8 @@ static void Allocate_sockets(void)
 		/* Initialize all the sockets to -1 because
 		 * it makes some code later easier */
 		udp_socket[p] = tcp_socket[p] = -1;
+		for (i = 0; i < RPC_LISTEN_SHARDS_MAX; i++)
+			tcp_shard_socket[p][i] = -1;
 
 		if (nfs_protocol_enabled(p)) {
 			if (v6disabled)
@@ -1338,17 +1502,29 @@ void nfs_Init_svc(void)
 	rdma = NFS_options & CORE_OPTION_NFS_RDMA;
 #endif
 
+	nfs_request_pool = pool_cached_init("nfs_request_t pool",
+					    sizeof(nfs_request_t),
+					    NFS_REQUEST_CACHE_MAX);
+
 	/* New TI-RPC package init function */
 	svc_params.disconnect_cb = NULL;
 	svc_params.alloc_cb = alloc_nfs_request;
 	svc_params.free_cb = free_nfs_request;
 	svc_params.flags = SVC_INIT_EPOLL;	/* use EPOLL event mgmt */
 	svc_params.flags |= SVC_INIT_NOREG_XPRTS; /* don't call xprt_register */
+	if (nfs_param.core_param.rpc.io_uring)
+		svc_params.flags |= SVC_INIT_IO_URING;
 	svc_params.max_connections = nfs_param.core_param.rpc.max_connections;
+	svc_params.xprt_inflight_max =
+		nfs_param.core_param.rpc.max_conn_requests;
+	svc_params.tls_cert_file = nfs_param.core_param.rpc.tls_cert_file;
+	svc_params.tls_key_file = nfs_param.core_param.rpc.tls_key_file;
+	svc_params.tls_ca_file = nfs_param.core_param.rpc.tls_ca_file;
 	svc_params.max_events = 1024;	/* length of epoll event queue */
 	svc_params.ioq_send_max =
 	    nfs_param.core_param.rpc.max_send_buffer_size;
-	svc_params.channels = N_EVENT_CHAN;
+	svc_params.channels = N_EVENT_CHAN +
+			      nfs_param.core_param.rpc.listen_shards - 1;
 	svc_params.idle_timeout = nfs_param.core_param.rpc.idle_timeout_s;
 	svc_params.ioq_thrd_min = nfs_param.core_param.rpc.ioq_thrd_min;
 	svc_params.ioq_thrd_max = nfs_param.core_param.rpc.ioq_thrd_max;
@@ -1376,6 +1552,17 @@ void nfs_Init_svc(void)
 		/* XXX bail?? */
 	}
 
+	for (ix = 1; ix < nfs_param.core_param.rpc.listen_shards; ++ix) {
+		tcp_shard_evchan[ix].chan_id = 0;
+		code = svc_rqst_new_evchan(&tcp_shard_evchan[ix].chan_id,
+					   NULL /* u_data */,
+					   SVC_RQST_FLAG_NONE);
+		if (code)
+			LogFatal(COMPONENT_DISPATCH,
+				 "Cannot create TI-RPC listener event channel (%d, %d)",
+				 ix, code);
+	}
+
 	/* Get the netconfig entries from /etc/netconfig */
 	netconfig_udpv4 = (struct netconfig *)getnetconfigent("udp");
 	if (netconfig_udpv4 == NULL)
@@ -1530,7 +1717,7 @@ static enum xprt_stat nfs_rpc_free_user_data(SVCXPRT *xprt)
  */
 static struct svc_req *alloc_nfs_request(SVCXPRT *xprt, XDR *xdrs)
 {
-	nfs_request_t *reqdata = gsh_calloc(1, sizeof(nfs_request_t));
+	nfs_request_t *reqdata = pool_alloc(nfs_request_pool);
 
 	if (!xprt) {
 		LogFatal(COMPONENT_DISPATCH,
@@ -1561,6 +1748,7 @@ static struct svc_req *alloc_nfs_request(SVCXPRT *xprt, XDR *xdrs)
 	reqdata->svc.rq_refcnt = 1;
 
 	TAILQ_INIT_ENTRY(reqdata, dupes);
+	TAILQ_INIT_ENTRY(reqdata, bulk_q);
 
 	return &reqdata->svc;
 }
@@ -1597,7 +1785,10 @@ static void free_nfs_request(struct svc_req *req, enum xprt_stat stat)
 		     "%s: %p fd %d xp_refcnt %" PRIu32,
 		     __func__, xprt, xprt->xp_fd, xprt->xp_refcnt);
 
-	gsh_free(reqdata);
+	/* Let the next bulk request in, if this one was holding a slot */
+	nfs_rpc_bulk_release(reqdata);
+
+	pool_free(nfs_request_pool, reqdata);
 
 	SVC_RELEASE(xprt, SVC_REF_FLAG_NONE);
 
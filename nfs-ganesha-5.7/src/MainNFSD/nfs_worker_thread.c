@@ -884,6 +884,227 @@ enum nfs_req_result process_dupreq(nfs_request_t *reqdata,
 	return NFS_REQ_OK;
 }
 
+/**
+ * @brief Bulk requests in progress and waiting
+ *
+ * Bulk requests (I/O, or anything on a Request_Class = bulk export) may only
+ * hold RPC_Bulk_Worker_Share of the workers at once, so that interactive
+ * requests always find one. Requests over the limit are suspended on the
+ * waiting queue and resumed in order as slots are released.
+ */
+static struct {
+	pthread_mutex_t mtx;
+	uint32_t active;
+	TAILQ_HEAD(, nfs_request) waiting;
+} bulk;
+
+void nfs_rpc_bulk_pkginit(void)
+{
+	PTHREAD_MUTEX_init(&bulk.mtx, NULL);
+	TAILQ_INIT(&bulk.waiting);
+}
+
+/**
+ * @brief Get the Request_Class of the export an NFSv4 handle belongs to
+ *
+ * @param[in] fh  The handle
+ *
+ * @return enum export_req_class
+ */
+static uint32_t nfs4_fh_req_class(nfs_fh4 *fh)
+{
+	file_handle_v4_t *hdl = (file_handle_v4_t *) fh->nfs_fh4_val;
+	struct gsh_export *export;
+	uint32_t req_class;
+
+	if (fh->nfs_fh4_len < sizeof(file_handle_v4_t) ||
+	    (hdl->fhflags1 & FILE_HANDLE_V4_FLAG_DS) != 0)
+		return EXPORT_REQ_CLASS_AUTO;
+
+	export = get_gsh_export(ntohs(hdl->id.exports));
+
+	if (export == NULL)
+		return EXPORT_REQ_CLASS_AUTO;
+
+	req_class = atomic_fetch_uint32_t(&export->req_class);
+	put_gsh_export(export);
+
+	return req_class;
+}
+
+/**
+ * @brief Check if a request is bulk
+ *
+ * For NFSv4 the export is that of the first PUTFH of the COMPOUND, the
+ * COMPOUND is I/O if any of its operations is.
+ *
+ * @param[in] reqdata  The request, with op_ctx set up
+ *
+ * @return true if the request is bulk.
+ */
+static bool nfs_rpc_is_bulk(nfs_request_t *reqdata)
+{
+	uint32_t req_class = EXPORT_REQ_CLASS_AUTO;
+	bool io = (reqdata->funcdesc->dispatch_behaviour & MAKES_IO) != 0;
+
+	if (op_ctx->ctx_export != NULL) {
+		req_class = atomic_fetch_uint32_t(
+					&op_ctx->ctx_export->req_class);
+#ifdef _USE_NFS3
+		if (reqdata->funcdesc == &nfs3_func_desc[NFSPROC3_COMMIT])
+			io = true;
+#endif /* _USE_NFS3 */
+	} else if (reqdata->funcdesc == &nfs4_func_desc[NFSPROC4_COMPOUND]) {
+		COMPOUND4args *args = &reqdata->arg_nfs.arg_compound4;
+		bool have_export = false;
+		u_int i;
+
+		for (i = 0; i < args->argarray.argarray_len; i++) {
+			struct nfs_argop4 *op = &args->argarray.argarray_val[i];
+
+			switch (op->argop) {
+			case NFS4_OP_PUTFH:
+				if (!have_export) {
+					req_class = nfs4_fh_req_class(
+						&op->nfs_argop4_u.opputfh.object);
+					have_export = true;
+				}
+				break;
+			case NFS4_OP_READ:
+			case NFS4_OP_WRITE:
+			case NFS4_OP_COMMIT:
+			case NFS4_OP_COPY:
+			case NFS4_OP_CLONE:
+				io = true;
+				break;
+			default:
+				break;
+			}
+		}
+	}
+
+	if (req_class != EXPORT_REQ_CLASS_AUTO)
+		return req_class == EXPORT_REQ_CLASS_BULK;
+
+	return io;
+}
+
+static enum xprt_stat nfs_rpc_bulk_resume(struct svc_req *req);
+
+/**
+ * @brief Take a bulk worker slot for a request if it needs one
+ *
+ * @param[in,out] reqdata  The request, with op_ctx set up
+ *
+ * @retval true if the request may be processed now.
+ * @retval false if it was queued, it has been suspended and must not be
+ *         touched anymore, nfs_rpc_bulk_resume() will process it.
+ */
+static bool nfs_rpc_bulk_admit(nfs_request_t *reqdata)
+{
+	uint32_t share = nfs_param.core_param.rpc.bulk_worker_share;
+	uint32_t max;
+
+	if (share >= 100 || reqdata->bulk || !nfs_rpc_is_bulk(reqdata))
+		return true;
+
+	max = MAX(nfs_param.core_param.rpc.ioq_thrd_max * share / 100, 1);
+
+	PTHREAD_MUTEX_lock(&bulk.mtx);
+
+	if (bulk.active < max) {
+		bulk.active++;
+		PTHREAD_MUTEX_unlock(&bulk.mtx);
+		reqdata->bulk = true;
+		return true;
+	}
+
+	LogFullDebug(COMPONENT_DISPATCH,
+		     "Suspending bulk request xid=%" PRIu32
+		     " with %" PRIu32 " in progress",
+		     reqdata->svc.rq_msg.rm_xid, bulk.active);
+
+	/* The request may be resumed as soon as the lock is dropped */
+	reqdata->svc.rq_resume_cb = nfs_rpc_bulk_resume;
+	suspend_op_context();
+	TAILQ_INSERT_TAIL(&bulk.waiting, reqdata, bulk_q);
+
+	PTHREAD_MUTEX_unlock(&bulk.mtx);
+
+	return false;
+}
+
+/**
+ * @brief Release the bulk worker slot of a request
+ *
+ * The slot is handed over to the first waiting request, if any.
+ *
+ * @param[in] reqdata  The request being freed
+ */
+void nfs_rpc_bulk_release(nfs_request_t *reqdata)
+{
+	nfs_request_t *next;
+
+	if (!reqdata->bulk)
+		return;
+
+	reqdata->bulk = false;
+
+	PTHREAD_MUTEX_lock(&bulk.mtx);
+
+	next = TAILQ_FIRST(&bulk.waiting);
+
+	if (next != NULL)
+		TAILQ_REMOVE(&bulk.waiting, next, bulk_q);
+	else
+		bulk.active--;
+
+	PTHREAD_MUTEX_unlock(&bulk.mtx);
+
+	if (next != NULL) {
+		next->bulk = true;
+		svc_resume(&next->svc);
+	}
+}
+
+/**
+ * @brief Process a bulk request that was waiting for a worker slot
+ *
+ * @param[in] req  The request
+ *
+ * @return the transport status.
+ */
+static enum xprt_stat nfs_rpc_bulk_resume(struct svc_req *req)
+{
+	nfs_request_t *reqdata = container_of(req, nfs_request_t, svc);
+	enum nfs_req_result rc;
+
+	/* Restore the op_ctx */
+	resume_op_context(&reqdata->op_context);
+
+	rc = reqdata->funcdesc->service_function(&reqdata->arg_nfs,
+						 &reqdata->svc,
+						 reqdata->res_nfs);
+
+	if (rc == NFS_REQ_ASYNC_WAIT) {
+		/* Same as in nfs_rpc_process_request() */
+		suspend_op_context();
+		return XPRT_SUSPEND;
+	}
+
+	complete_request_instrumentation(reqdata);
+	(void) complete_request(reqdata, rc);
+	free_args(reqdata);
+
+	/* Make sure no-one called init_op_context() without calling
+	 * release_op_context() */
+	assert(op_ctx == NULL);
+	/* Make sure we return to ntirpc without op_ctx set, or saved_op_ctx can
+	 * point to freed memory */
+	op_ctx = NULL;
+	return SVC_STAT(reqdata->svc.rq_xprt);
+}
+
 /**
  * @brief Main RPC dispatcher routine
  *
@@ -1496,6 +1717,12 @@ retry_after_drc_suspend:
 		 *        NLM4_STALE_FH (NLM doesn't have a BADHANDLE code)
 		 */
 
+		/* Hold back bulk requests over their share of the workers,
+		 * see nfs_rpc_bulk_admit().
+		 */
+		if (!nfs_rpc_bulk_admit(reqdata))
+			return XPRT_SUSPEND;
+
 #ifdef _ERROR_INJECTION
 		if (worker_delay_time != 0)
 			sleep(worker_delay_time);
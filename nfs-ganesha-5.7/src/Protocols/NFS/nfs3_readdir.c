@@ -300,7 +300,7 @@ int nfs3_readdir(nfs_arg_t *arg, struct svc_req *req, nfs_res_t *res)
 
 	/* Call readdir */
 	fsal_status = fsal_readdir(dir_obj, fsal_cookie, &num_entries, &eod_met,
-				   0,	/* no attr */
+				   ATTR_DIRENT_ONLY, /* only fileid */
 				   nfs3_readdir_callback, &tracker);
 
 	if (FSAL_IS_ERROR(fsal_status)) {
@@ -445,7 +445,7 @@ fsal_errors_t nfs3_readdir_callback(void *opaque,
 	u_int pos_start = xdr_getpos(&tracker->xdr);
 
 	memset(&e3, 0, sizeof(e3));
-	e3.fileid = obj->fileid;
+	e3.fileid = obj != NULL ? obj->fileid : attr->fileid;
 	e3.name = (char *) cb_parms->name;
 	e3.cookie = cookie;
 
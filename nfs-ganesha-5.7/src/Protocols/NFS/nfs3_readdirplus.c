@@ -70,8 +70,25 @@ struct nfs3_readdirplus_cb_data {
 	uint32_t max_count;	/*< Maximum number of entries allowed. */
 	nfsstat3 error;		/*< Set to a value other than NFS_OK if the
 				   callback function finds a fatal error. */
+	uint32_t fh_buf[NFS3_FHSIZE / sizeof(uint32_t)];
+				/*< Scratch space the handle of each entry is
+				    built in before being serialized. */
 };
 
+/**
+ * @brief Smallest possible XDR size of an entryplus3
+ *
+ * value_follows, fileid, name, cookie, attributes_follow, handle_follows,
+ * plus the boolean that must still fit after the entry to terminate the
+ * list. Attributes and the handle itself are not counted.
+ */
+static inline size_t nfs3_entryplus3_min_size(const char *name)
+{
+	return BYTES_PER_XDR_UNIT + sizeof(fileid3) + BYTES_PER_XDR_UNIT +
+	       RNDUP(strlen(name)) + sizeof(cookie3) + BYTES_PER_XDR_UNIT +
+	       BYTES_PER_XDR_UNIT + BYTES_PER_XDR_UNIT;
+}
+
 static
 nfsstat3 nfs_readdir_dot_entry(struct fsal_obj_handle *obj, const char *name,
 			       uint64_t cookie, helper_readdir_cb cb,
@@ -444,9 +461,9 @@ void nfs3_readdirplus_free(nfs_res_t *resp)
 /**
  * @brief Populate entryplus3s when called from fsal_readdir
  *
- * This function is a callback passed to fsal_readdir.  It
- * fills in a pre-allocated array of entryplys3 structures and allocates
- * space for the name and attributes.  This space must be freed.
+ * This function is a callback passed to fsal_readdir.  It serializes
+ * each entry straight into the xdrmem buffer of the tracker, building the
+ * handle in scratch space so nothing is allocated per entry.
  *
  * @param opaque [in] Pointer to a struct nfs3_readdirplus_cb_data that is
  *                    gives the location of the array and other
@@ -474,6 +491,26 @@ fsal_errors_t nfs3_readdirplus_callback(void *opaque,
 		"Callback for %s cookie %"PRIu64,
 		cb_parms->name, cookie);
 
+	/* Stop before building the handle if even the fixed part of this
+	 * entry can't fit, so the walk of the directory ends here without
+	 * any further work on an entry that will not be sent.
+	 */
+	if (tracker->count >= tracker->max_count ||
+	    pos_start + nfs3_entryplus3_min_size(cb_parms->name)
+	    >= tracker->mem_avail) {
+		bool_t res_false = false;
+
+		cb_parms->in_result = false;
+
+		if (!xdr_bool(&tracker->xdr, &res_false)) {
+			LogCrit(COMPONENT_NFS_READDIR,
+				"Unexpected XDR failure processing readdir result");
+			tracker->error = NFS3ERR_SERVERFAULT;
+		}
+
+		return ERR_FSAL_NO_ERROR;
+	}
+
 	memset(&ep3, 0, sizeof(ep3));
 	ep3.fileid = obj->fileid;
 	ep3.name = (char *) cb_parms->name;
@@ -481,8 +518,10 @@ fsal_errors_t nfs3_readdirplus_callback(void *opaque,
 
 	if (cb_parms->attr_allowed) {
 		ep3.name_handle.handle_follows = TRUE;
+		ep3.name_handle.post_op_fh3_u.handle.data.data_val =
+						(char *)tracker->fh_buf;
 
-		if (!nfs3_FSALToFhandle(true,
+		if (!nfs3_FSALToFhandle(false,
 					&ep3.name_handle.post_op_fh3_u.handle,
 					obj,
 					op_ctx->ctx_export)) {
@@ -506,10 +545,10 @@ fsal_errors_t nfs3_readdirplus_callback(void *opaque,
 	 * rather than name_attributes from entryplus3, though we will use the
 	 * boolean attributes_follow from the entryplus3.
 	 *
-	 * Before doing that though, check if the enty fits based on max_count.
+	 * The handle was built in tracker->fh_buf so there is nothing to
+	 * free once the entry has been serialized.
 	 */
-	if (tracker->count >= tracker->max_count ||
-	    !xdr_encode_entryplus3(&tracker->xdr, &ep3, attr) ||
+	if (!xdr_encode_entryplus3(&tracker->xdr, &ep3, attr) ||
 	    (xdr_getpos(&tracker->xdr) + BYTES_PER_XDR_UNIT)
 	    >= tracker->mem_avail) {
 		bool_t res_false = false;
@@ -534,8 +573,5 @@ fsal_errors_t nfs3_readdirplus_callback(void *opaque,
 		tracker->count++;
 	}
 
-	/* Now we are done with anything allocated */
-	gsh_free(ep3.name_handle.post_op_fh3_u.handle.data.data_val);
-
 	return ERR_FSAL_NO_ERROR;
 }				/* nfs3_readdirplus_callback */
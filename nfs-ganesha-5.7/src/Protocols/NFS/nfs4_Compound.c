@@ -50,6 +50,18 @@
 #include "gsh_lttng/nfs_rpc.h"
 #endif
 
+/* Objects kept for reuse by each thread */
+#define NFS4_COMPOUND_CACHE_MAX 32
+
+/* COMPOUNDs of up to this many ops take their resarray from the arena pool,
+ * which covers the usual SEQUENCE, PUTFH, op, GETATTR style requests.
+ */
+#define NFS4_RES_ARENA_OPS 8
+
+static pool_t *compound_data_pool;
+static pool_t *compound_res_pool;
+static pool_t *compound_res_arena_pool;
+
 static enum nfs_req_result nfs4_default_resume(struct nfs_argop4 *op,
 					       compound_data_t *data,
 					       struct nfs_resop4 *resp)
@@ -538,11 +550,11 @@ static const struct nfs4_op_desc optabv4[] = {
 		.exp_perm_flags = 0},
 	[NFS4_OP_COPY] = {
 		.name = "OP_COPY",
-		.funct = nfs4_op_notsupp,
+		.funct = nfs4_op_copy,
 		.resume = nfs4_default_resume,
-		.free_res = nfs4_op_notsupp_Free,
+		.free_res = nfs4_op_copy_Free,
 		.resp_size = sizeof(COPY4res),
-		.exp_perm_flags = 0},
+		.exp_perm_flags = EXPORT_OPTION_WRITE_ACCESS},
 	[NFS4_OP_COPY_NOTIFY] = {
 		.name = "OP_COPY_NOTIFY",
 		.funct = nfs4_op_notsupp,
@@ -580,16 +592,16 @@ static const struct nfs4_op_desc optabv4[] = {
 		.exp_perm_flags = 0},
 	[NFS4_OP_OFFLOAD_CANCEL] = {
 		.name = "OP_OFFLOAD_CANCEL",
-		.funct = nfs4_op_notsupp,
+		.funct = nfs4_op_offload_cancel,
 		.resume = nfs4_default_resume,
-		.free_res = nfs4_op_notsupp_Free,
+		.free_res = nfs4_op_offload_cancel_Free,
 		.resp_size = sizeof(OFFLOAD_ABORT4res),
 		.exp_perm_flags = 0},
 	[NFS4_OP_OFFLOAD_STATUS] = {
 		.name = "OP_OFFLOAD_STATUS",
-		.funct = nfs4_op_notsupp,
+		.funct = nfs4_op_offload_status,
 		.resume = nfs4_default_resume,
-		.free_res = nfs4_op_notsupp_Free,
+		.free_res = nfs4_op_offload_status_Free,
 		.resp_size = sizeof(OFFLOAD_STATUS4res),
 		.exp_perm_flags = 0},
 	[NFS4_OP_READ_PLUS] = {
@@ -615,11 +627,11 @@ static const struct nfs4_op_desc optabv4[] = {
 		.exp_perm_flags = 0},
 	[NFS4_OP_CLONE] = {
 		.name = "OP_CLONE",
-		.funct = nfs4_op_notsupp,
+		.funct = nfs4_op_clone,
 		.resume = nfs4_default_resume,
-		.free_res = nfs4_op_notsupp_Free,
-		.resp_size = sizeof(ILLEGAL4res),
-		.exp_perm_flags = 0},
+		.free_res = nfs4_op_clone_Free,
+		.resp_size = sizeof(CLONE4res),
+		.exp_perm_flags = EXPORT_OPTION_WRITE_ACCESS},
 
 	/* NFSv4.3 */
 	[NFS4_OP_GETXATTR] = {
@@ -984,8 +996,7 @@ void complete_nfs4_compound(compound_data_t *data, int status,
 		release_slot(data->slot);
 
 		/* Allocate (and zero) a new COMPOUND4res_extended */
-		data->slot->cached_result =
-			gsh_calloc(1, sizeof(*data->slot->cached_result));
+		data->slot->cached_result = pool_alloc(compound_res_pool);
 
 		/* record the latest request. */
 		set_slot_last_req(data);
@@ -1049,8 +1060,11 @@ void complete_nfs4_compound(compound_data_t *data, int status,
 		 */
 	}
 
-	/* If we have reserved a lease, update it and release it */
-	if (data->preserved_clientid != NULL) {
+	/* If we have reserved a lease, update it and release it.  Unless this
+	 * was the last reservation, that needs no lock.
+	 */
+	if (data->preserved_clientid != NULL &&
+	    !update_lease_fast(data->preserved_clientid)) {
 		/* Update and release lease */
 		PTHREAD_MUTEX_lock(&data->preserved_clientid->cid_mutex);
 
@@ -1181,8 +1195,7 @@ int nfs4_Compound(nfs_arg_t *arg, struct svc_req *req, nfs_res_t *res)
 	enum nfs_req_result result = NFS_REQ_OK;
 
 	/* Allocate (and zero) the COMPOUND4res_extended */
-	res->res_compound4_extended =
-			gsh_calloc(1, sizeof(*res->res_compound4_extended));
+	res->res_compound4_extended = pool_alloc(compound_res_pool);
 	res_compound4 = &res->res_compound4_extended->res_compound4;
 
 	/* Take initial reference to response. */
@@ -1207,7 +1220,7 @@ int nfs4_Compound(nfs_arg_t *arg, struct svc_req *req, nfs_res_t *res)
 	}
 
 	/* Initialisation of the compound request internal's data */
-	data = gsh_calloc(1, sizeof(*data));
+	data = pool_alloc(compound_data_pool);
 
 	data->req = req;
 	data->argarray_len = argarray_len;
@@ -1297,7 +1310,13 @@ int nfs4_Compound(nfs_arg_t *arg, struct svc_req *req, nfs_res_t *res)
 	    arg->arg_compound4.tag.utf8string_len;
 
 	/* Allocating the reply nfs_resop4 */
-	data->resarray = gsh_calloc(argarray_len, sizeof(struct nfs_resop4));
+	if (argarray_len <= NFS4_RES_ARENA_OPS) {
+		data->resarray = pool_alloc(compound_res_arena_pool);
+		res->res_compound4_extended->res_arena = true;
+	} else {
+		data->resarray = gsh_calloc(argarray_len,
+					    sizeof(struct nfs_resop4));
+	}
 
 	res_compound4->resarray.resarray_len = argarray_len;
 	res_compound4->resarray.resarray_val = data->resarray;
@@ -1399,6 +1418,31 @@ out:
 	return drop ? NFS_REQ_DROP : NFS_REQ_OK;
 }				/* nfs4_Compound */
 
+/**
+ * @brief Set up the COMPOUND object pools
+ *
+ * The compound data, the COMPOUND4res_extended and the resarray of a
+ * typical COMPOUND are allocated and freed on every NFSv4 request, so
+ * they come from pools with per-thread caches rather than straight from
+ * the allocator.
+ */
+void nfs4_compound_pkginit(void)
+{
+	compound_data_pool = pool_cached_init("compound_data_t pool",
+					      sizeof(compound_data_t),
+					      NFS4_COMPOUND_CACHE_MAX);
+
+	compound_res_pool =
+		pool_cached_init("COMPOUND4res_extended pool",
+				 sizeof(struct COMPOUND4res_extended),
+				 NFS4_COMPOUND_CACHE_MAX);
+
+	compound_res_arena_pool =
+		pool_cached_init("COMPOUND resarray pool",
+				 NFS4_RES_ARENA_OPS * sizeof(struct nfs_resop4),
+				 NFS4_COMPOUND_CACHE_MAX);
+}
+
 /**
  *
  * @brief Free the result for one NFS4_OP
@@ -1448,13 +1492,17 @@ void release_nfs4_res_compound(struct COMPOUND4res_extended *res_compound4_ex)
 		}
 	}
 
-	gsh_free(res_compound4->resarray.resarray_val);
+	if (res_compound4_ex->res_arena)
+		pool_free(compound_res_arena_pool,
+			  res_compound4->resarray.resarray_val);
+	else
+		gsh_free(res_compound4->resarray.resarray_val);
 	res_compound4->resarray.resarray_val = NULL;
 
 	gsh_free(res_compound4->tag.utf8string_val);
 	res_compound4->tag.utf8string_val = NULL;
 
-	gsh_free(res_compound4_ex);
+	pool_free(compound_res_pool, res_compound4_ex);
 }
 
 /**
@@ -1494,6 +1542,9 @@ void compound_data_Free(compound_data_t *data)
 	set_current_entry(data, NULL);
 	set_saved_entry(data, NULL);
 
+	/* Reads started ahead for ops the compound didn't get to */
+	nfs4_read_ahead_release(data);
+
 	gsh_free(data->tagname);
 
 	if (data->session) {
@@ -1502,7 +1553,7 @@ void compound_data_Free(compound_data_t *data)
 
 			/* Release the slot if in use */
 			slot = &data->session->fc_slots[data->slotid];
-			PTHREAD_MUTEX_unlock(&slot->slot_lock);
+			atomic_store_uint32_t(&slot->slot_busy, 0);
 		}
 
 		dec_session_ref(data->session);
@@ -1527,7 +1578,7 @@ void compound_data_Free(compound_data_t *data)
 	if (data->savedFH.nfs_fh4_val != NULL)
 		gsh_free(data->savedFH.nfs_fh4_val);
 
-	gsh_free(data);
+	pool_free(compound_data_pool, data);
 }				/* compound_data_Free */
 
 /**
@@ -0,0 +1,918 @@
+// SPDX-License-Identifier: LGPL-3.0-or-later
+/*
+ * vim:noexpandtab:shiftwidth=8:tabstop=8:
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public License
+ * as published by the Free Software Foundation; either version 3 of
+ * the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA
+ * 02110-1301 USA
+ *
+ * ---------------------------------------
+ */
+
+/**
+ * @file nfs4_op_copy.c
+ * @brief Routines used for managing the NFS4 COMPOUND functions.
+ *
+ * Routines used for managing the NFS4 COMPOUND functions COPY, CLONE,
+ * OFFLOAD_STATUS and OFFLOAD_CANCEL (RFC 7862), for copies within the
+ * server.
+ *
+ * A COPY is done in the request when it is small or the client asked for
+ * a synchronous copy; a synchronous copy that is too large is cut short
+ * and the client sends the rest again.  Otherwise the copy is handed to a
+ * background fridge, the client gets a stateid to follow it with
+ * OFFLOAD_STATUS or stop it with OFFLOAD_CANCEL, and CB_OFFLOAD tells it
+ * when the copy is done.  A client, and the server, may only have so many
+ * copies in the background; past that a COPY is done synchronously.
+ */
+
+#include "config.h"
+#include "log.h"
+#include "fsal.h"
+#include "nfs_core.h"
+#include "sal_functions.h"
+#include "nfs_proto_functions.h"
+#include "nfs_proto_tools.h"
+#include "nfs_convert.h"
+#include "nfs_file_handle.h"
+#include "nfs_rpc_callback.h"
+#include "export_mgr.h"
+#include "fridgethr.h"
+
+/** Bytes per call to the FSAL, the granularity of OFFLOAD_CANCEL */
+#define COPY_CHUNK (16 * 1024 * 1024)
+
+/** Most bytes copied within a request, larger copies go asynchronous */
+#define COPY_SYNC_MAX (64 * 1024 * 1024)
+
+/** Asynchronous copies running at the same time */
+#define COPY_THREADS 4
+
+/** Asynchronous copies of one client, queued, running or being called back */
+#define COPY_CLIENT_MAX 8
+
+/** Asynchronous copies of all clients, which bounds the fridge queue */
+#define COPY_MAX 64
+
+/**
+ * @brief An asynchronous copy
+ *
+ * On copy_list from the COPY that starts it until the client answered
+ * CB_OFFLOAD, or until it stopped after an OFFLOAD_CANCEL.
+ */
+struct nfs4_copy {
+	struct glist_head list;		/*< Link in copy_list */
+	stateid4 stateid;		/*< Callback stateid given to client */
+	nfs_client_id_t *clientid;	/*< Client that asked for the copy */
+	struct gsh_export *export;	/*< Export both files are in */
+	struct fsal_obj_handle *src_obj;
+	struct fsal_obj_handle *dst_obj;
+	state_t *src_state;		/*< Or NULL for anonymous stateids */
+	state_t *dst_state;		/*< Or NULL for anonymous stateids */
+	nfs_fh4 dst_fh;			/*< Destination handle, for CB_OFFLOAD */
+	struct user_cred creds;		/*< Caller's creds, own garray */
+	struct export_perms export_perms; /*< Caller's export permissions */
+	uint64_t src_offset;
+	uint64_t dst_offset;
+	uint64_t count;
+	uint64_t copied;		/*< Bytes copied so far (atomic) */
+	uint32_t cancelled;		/*< OFFLOAD_CANCEL received (atomic) */
+	bool done;			/*< Finished, CB_OFFLOAD sent */
+	nfsstat4 status;		/*< Final status once done */
+};
+
+static struct fridgethr *copy_fridge;
+static pthread_mutex_t copy_mutex;
+static struct glist_head copy_list;
+static uint32_t copy_counter;
+
+/**
+ * @brief Check a COPY stateid and get the open state to do I/O with
+ *
+ * @param[in]  data     Compound request's data
+ * @param[in]  stateid  Stateid from the client
+ * @param[in]  obj      File the stateid is for
+ * @param[in]  write    Whether the file is written
+ * @param[out] state    Open state, or NULL for special and delegation
+ *                      stateids
+ *
+ * @return NFS4_OK or an error.
+ */
+static nfsstat4 copy_check_stateid(compound_data_t *data, stateid4 *stateid,
+				   struct fsal_obj_handle *obj, bool write,
+				   state_t **state)
+{
+	state_t *state_found = NULL, *state_open = NULL;
+	nfsstat4 status;
+
+	*state = NULL;
+
+	status = nfs4_Check_Stateid(stateid, obj, &state_found, data,
+				    STATEID_SPECIAL_ANY, 0, false, "COPY");
+	if (status != NFS4_OK)
+		return status;
+
+	if (state_found == NULL) {
+		/* Special stateid, make sure no delegation conflicts */
+		if (state_deleg_conflict(obj, write))
+			return NFS4ERR_DELAY;
+		return NFS4_OK;
+	}
+
+	switch (state_found->state_type) {
+	case STATE_TYPE_SHARE:
+		state_open = state_found;
+		inc_state_t_ref(state_open);
+		break;
+
+	case STATE_TYPE_LOCK:
+		state_open = nfs4_State_Get_Pointer(
+				state_found->state_data.lock.openstate_key);
+		if (state_open == NULL)
+			status = NFS4ERR_BAD_STATEID;
+		break;
+
+	case STATE_TYPE_DELEG:
+		/* As for READ and WRITE, a delegation stateid only has to
+		 * allow the access.
+		 */
+		if (write && !(state_found->state_data.deleg.sd_type &
+			       OPEN_DELEGATE_WRITE))
+			status = NFS4ERR_BAD_STATEID;
+		break;
+
+	default:
+		LogDebug(COMPONENT_NFS_V4_LOCK,
+			 "COPY with invalid stateid of type %d",
+			 (int)state_found->state_type);
+		status = NFS4ERR_BAD_STATEID;
+		break;
+	}
+
+	dec_state_t_ref(state_found);
+
+	if (status != NFS4_OK || state_open == NULL)
+		return status;
+
+	if (write && !(state_open->state_data.share.share_access &
+		       OPEN4_SHARE_ACCESS_WRITE)) {
+		dec_state_t_ref(state_open);
+		return NFS4ERR_OPENMODE;
+	}
+
+	*state = state_open;
+	return NFS4_OK;
+}
+
+/**
+ * @brief Copy a range in chunks
+ *
+ * Stops at the end of the source, on error, on shutdown, or when the copy
+ * is cancelled.
+ *
+ * @param[in,out] copied     Bytes copied, updated after each chunk
+ * @param[in]     cancelled  Cancel flag to watch, or NULL
+ *
+ * @return FSAL status.
+ */
+static fsal_status_t copy_chunks(struct fsal_obj_handle *src_obj,
+				 state_t *src_state, uint64_t src_offset,
+				 struct fsal_obj_handle *dst_obj,
+				 state_t *dst_state, uint64_t dst_offset,
+				 uint64_t count, uint64_t *copied,
+				 uint32_t *cancelled)
+{
+	fsal_status_t status = {0, 0};
+	uint64_t done, len, pos;
+
+	for (pos = 0; pos < count; pos += done) {
+		if (admin_shutdown)
+			return fsalstat(ERR_FSAL_DELAY, 0);
+
+		if (cancelled != NULL && atomic_fetch_uint32_t(cancelled))
+			break;
+
+		len = MIN(count - pos, COPY_CHUNK);
+		done = 0;
+
+		status = src_obj->obj_ops->copy(src_obj, src_state,
+						src_offset + pos,
+						dst_obj, dst_state,
+						dst_offset + pos,
+						len, &done);
+
+		(void) atomic_add_uint64_t(copied, done);
+
+		if (FSAL_IS_ERROR(status) || done < len)
+			break;
+	}
+
+	return status;
+}
+
+static void copy_free(struct nfs4_copy *copy)
+{
+	if (copy->src_state != NULL)
+		dec_state_t_ref(copy->src_state);
+	if (copy->dst_state != NULL)
+		dec_state_t_ref(copy->dst_state);
+	copy->src_obj->obj_ops->put_ref(copy->src_obj);
+	copy->dst_obj->obj_ops->put_ref(copy->dst_obj);
+	put_gsh_export(copy->export);
+	dec_client_id_ref(copy->clientid);
+	nfs4_freeFH(&copy->dst_fh);
+	gsh_free(copy->creds.caller_garray);
+	gsh_free(copy);
+}
+
+static void copy_unlink_free(struct nfs4_copy *copy)
+{
+	PTHREAD_MUTEX_lock(&copy_mutex);
+	glist_del(&copy->list);
+	PTHREAD_MUTEX_unlock(&copy_mutex);
+
+	copy_free(copy);
+}
+
+/**
+ * @brief Handle the reply to a CB_OFFLOAD
+ *
+ * Whatever the outcome, the client has been told or can not be, so the
+ * copy is forgotten.
+ *
+ * @param[in] call  The RPC call being completed
+ */
+static void cb_offload_completion(rpc_call_t *call)
+{
+	struct nfs4_copy *copy = call->call_arg;
+
+	LogDebug(COMPONENT_NFS_CB, "%p %s", call,
+		 !(call->states & NFS_CB_CALL_ABORTED) ? "Success" : "Failed");
+
+	nfs41_release_single(call);
+	copy_unlink_free(copy);
+}
+
+/**
+ * @brief Send CB_OFFLOAD for a finished copy
+ *
+ * @param[in] copy     The copy
+ * @param[in] verifier Write verifier of the export
+ */
+static void copy_send_cb_offload(struct nfs4_copy *copy,
+				 const verifier4 verifier)
+{
+	nfs_cb_argop4 argop;
+	CB_OFFLOAD4args *args = &argop.nfs_cb_argop4_u.opcboffload;
+	write_response4 *resok = &args->coa_offload_info.offload_info4_u
+							.coa_resok4;
+	int ret;
+
+	memset(&argop, 0, sizeof(argop));
+	argop.argop = NFS4_OP_CB_OFFLOAD;
+
+	args->coa_fh = copy->dst_fh;
+	args->coa_stateid = copy->stateid;
+	args->coa_offload_info.coa_status = copy->status;
+
+	if (copy->status == NFS4_OK) {
+		resok->wr_count = atomic_fetch_uint64_t(&copy->copied);
+		resok->wr_committed = UNSTABLE4;
+		memcpy(resok->wr_writeverf, verifier, NFS4_VERIFIER_SIZE);
+	} else {
+		args->coa_offload_info.offload_info4_u.coa_bytes_copied =
+			atomic_fetch_uint64_t(&copy->copied);
+	}
+
+	ret = nfs_rpc_cb_single(copy->clientid, &argop, NULL,
+				cb_offload_completion, copy);
+	if (ret != 0) {
+		LogDebug(COMPONENT_NFS_CB,
+			 "CB_OFFLOAD for client %s failed: %d",
+			 copy->clientid->gsh_client->hostaddr_str, ret);
+		copy_unlink_free(copy);
+	}
+}
+
+/**
+ * @brief Run an asynchronous copy
+ *
+ * @param[in] ctx  Fridge context, ctx->arg is the copy
+ */
+static void copy_async(struct fridgethr_context *ctx)
+{
+	struct nfs4_copy *copy = ctx->arg;
+	struct req_op_context op_context;
+	struct gsh_buffdesc verf_desc;
+	fsal_status_t status;
+	verifier4 verifier;
+	bool cancelled;
+
+	get_gsh_export_ref(copy->export);
+	init_op_context_simple(&op_context, copy->export,
+			       copy->export->fsal_export);
+	/* Write as the client that asked, not as root */
+	op_context.creds = copy->creds;
+	op_context.original_creds = copy->creds;
+	op_context.export_perms = copy->export_perms;
+
+	status = copy_chunks(copy->src_obj, copy->src_state,
+			     copy->src_offset, copy->dst_obj,
+			     copy->dst_state, copy->dst_offset,
+			     copy->count, &copy->copied, &copy->cancelled);
+
+	verf_desc.addr = verifier;
+	verf_desc.len = sizeof(verifier);
+	op_ctx->fsal_export->exp_ops.get_write_verifier(op_ctx->fsal_export,
+							&verf_desc);
+
+	PTHREAD_MUTEX_lock(&copy_mutex);
+	cancelled = atomic_fetch_uint32_t(&copy->cancelled) != 0;
+	copy->status = nfs4_Errno_status(status);
+	copy->done = true;
+	PTHREAD_MUTEX_unlock(&copy_mutex);
+
+	LogDebug(COMPONENT_NFS_V4,
+		 "Copy of %" PRIu64 " bytes %s, %" PRIu64 " copied: %s",
+		 copy->count, cancelled ? "cancelled" : "done",
+		 atomic_fetch_uint64_t(&copy->copied),
+		 nfsstat4_to_str(copy->status));
+
+	/* The client gave up on a cancelled copy, don't call it back */
+	if (cancelled)
+		copy_unlink_free(copy);
+	else
+		copy_send_cb_offload(copy, verifier);
+
+	release_op_context();
+}
+
+/**
+ * @brief Find an asynchronous copy of the client by its stateid
+ *
+ * Call with copy_mutex held.
+ */
+static struct nfs4_copy *copy_lookup(compound_data_t *data,
+				     stateid4 *stateid)
+{
+	struct glist_head *glist;
+	struct nfs4_copy *copy;
+
+	if (data->session == NULL)
+		return NULL;
+
+	glist_for_each(glist, &copy_list) {
+		copy = glist_entry(glist, struct nfs4_copy, list);
+
+		if (copy->clientid == data->session->clientid_record &&
+		    memcmp(copy->stateid.other, stateid->other,
+			   sizeof(stateid->other)) == 0)
+			return copy;
+	}
+
+	return NULL;
+}
+
+/**
+ * @brief Check whether a client may start another asynchronous copy
+ *
+ * Call with copy_mutex held.  The list is bounded by COPY_MAX, so it is
+ * simply counted.
+ */
+static bool copy_may_start(nfs_client_id_t *clientid)
+{
+	struct glist_head *glist;
+	struct nfs4_copy *copy;
+	int total = 0, client = 0;
+
+	glist_for_each(glist, &copy_list) {
+		copy = glist_entry(glist, struct nfs4_copy, list);
+
+		total++;
+		if (copy->clientid == clientid)
+			client++;
+	}
+
+	return total < COPY_MAX && client < COPY_CLIENT_MAX;
+}
+
+/**
+ * @brief Start an asynchronous copy
+ *
+ * Takes over the state references.
+ *
+ * @return NFS4_OK, or NFS4ERR_DELAY when the client or the server has too
+ *         many copies in the background, in which case the caller still
+ *         owns the state references.
+ */
+static nfsstat4 copy_start_async(compound_data_t *data, COPY4args *args,
+				 state_t *src_state, state_t *dst_state,
+				 uint64_t count, write_response4 *resp)
+{
+	nfs_client_id_t *clientid = data->session->clientid_record;
+	struct nfs4_copy *copy = gsh_calloc(1, sizeof(*copy));
+	uint32_t counter;
+	int rc;
+
+	copy->clientid = clientid;
+	inc_client_id_ref(clientid);
+	copy->export = op_ctx->ctx_export;
+	get_gsh_export_ref(copy->export);
+	copy->src_obj = data->saved_obj;
+	copy->src_obj->obj_ops->get_ref(copy->src_obj);
+	copy->dst_obj = data->current_obj;
+	copy->dst_obj->obj_ops->get_ref(copy->dst_obj);
+	copy->src_state = src_state;
+	copy->dst_state = dst_state;
+	copy->src_offset = args->ca_src_offset;
+	copy->dst_offset = args->ca_dst_offset;
+	copy->count = count;
+
+	/* The request, and the group list its creds point to, is gone by
+	 * the time the copy runs.
+	 */
+	copy->creds = op_ctx->creds;
+	if (copy->creds.caller_glen != 0) {
+		copy->creds.caller_garray =
+			gsh_malloc(copy->creds.caller_glen * sizeof(gid_t));
+		memcpy(copy->creds.caller_garray, op_ctx->creds.caller_garray,
+		       copy->creds.caller_glen * sizeof(gid_t));
+	} else {
+		copy->creds.caller_garray = NULL;
+	}
+	copy->export_perms = op_ctx->export_perms;
+
+	nfs4_AllocateFH(&copy->dst_fh);
+	copy->dst_fh.nfs_fh4_len = data->currentFH.nfs_fh4_len;
+	memcpy(copy->dst_fh.nfs_fh4_val, data->currentFH.nfs_fh4_val,
+	       data->currentFH.nfs_fh4_len);
+
+	/* Unique among the copies of this client */
+	counter = atomic_inc_uint32_t(&copy_counter);
+	copy->stateid.seqid = 1;
+	memcpy(copy->stateid.other, &clientid->cid_clientid,
+	       sizeof(clientid->cid_clientid));
+	memcpy(copy->stateid.other + sizeof(clientid->cid_clientid),
+	       &counter, sizeof(counter));
+
+	PTHREAD_MUTEX_lock(&copy_mutex);
+	if (!copy_may_start(clientid)) {
+		PTHREAD_MUTEX_unlock(&copy_mutex);
+		LogDebug(COMPONENT_NFS_V4,
+			 "Too many copies in the background for client %s",
+			 clientid->gsh_client->hostaddr_str);
+		/* Give the states back to the caller */
+		copy->src_state = NULL;
+		copy->dst_state = NULL;
+		copy_free(copy);
+		return NFS4ERR_DELAY;
+	}
+	glist_add_tail(&copy_list, &copy->list);
+	PTHREAD_MUTEX_unlock(&copy_mutex);
+
+	rc = fridgethr_submit(copy_fridge, copy_async, copy);
+	if (rc != 0) {
+		LogMajor(COMPONENT_NFS_V4,
+			 "Unable to schedule copy: %d", rc);
+		/* Give the states back to the caller */
+		copy->src_state = NULL;
+		copy->dst_state = NULL;
+		copy_unlink_free(copy);
+		return NFS4ERR_DELAY;
+	}
+
+	resp->wr_ids = 1;
+	resp->wr_callback_id = copy->stateid;
+	resp->wr_count = 0;
+
+	return NFS4_OK;
+}
+
+/**
+ * @brief Checks common to COPY and CLONE
+ *
+ * The source is the saved filehandle, the destination the current one.
+ * The states are returned even on error, for the caller to release.
+ *
+ * @param[in]     data         Compound request's data
+ * @param[in]     src_stateid  Stateid to read the source
+ * @param[in]     dst_stateid  Stateid to write the destination
+ * @param[in]     src_offset   Offset in the source
+ * @param[in]     dst_offset   Offset in the destination
+ * @param[in,out] count        Count from the client, 0 is replaced by the
+ *                             bytes up to the end of the source
+ * @param[out]    src_state    Open state of the source, or NULL
+ * @param[out]    dst_state    Open state of the destination, or NULL
+ *
+ * @return NFS4_OK or an error.
+ */
+static nfsstat4 copy_prepare(compound_data_t *data, stateid4 *src_stateid,
+			     stateid4 *dst_stateid, uint64_t src_offset,
+			     uint64_t dst_offset, uint64_t *count,
+			     state_t **src_state, state_t **dst_state)
+{
+	struct fsal_obj_handle *src_obj, *dst_obj;
+	struct fsal_attrlist attrs;
+	fsal_status_t status;
+	nfsstat4 nfs_status;
+	uint64_t MaxOffsetWrite =
+		atomic_fetch_uint64_t(&op_ctx->ctx_export->MaxOffsetWrite);
+
+	*src_state = NULL;
+	*dst_state = NULL;
+
+	nfs_status = nfs4_sanity_check_FH(data, REGULAR_FILE, false);
+	if (nfs_status != NFS4_OK)
+		return nfs_status;
+
+	nfs_status = nfs4_sanity_check_saved_FH(data, REGULAR_FILE, false);
+	if (nfs_status != NFS4_OK)
+		return nfs_status;
+
+	/* Check that both handles are in the same export. */
+	if (op_ctx->ctx_export != NULL && data->saved_export != NULL &&
+	    op_ctx->ctx_export->export_id != data->saved_export->export_id)
+		return NFS4ERR_XDEV;
+
+	src_obj = data->saved_obj;
+	dst_obj = data->current_obj;
+
+	nfs_status = copy_check_stateid(data, src_stateid, src_obj, false,
+					src_state);
+	if (nfs_status != NFS4_OK)
+		return nfs_status;
+
+	nfs_status = copy_check_stateid(data, dst_stateid, dst_obj, true,
+					dst_state);
+	if (nfs_status != NFS4_OK)
+		return nfs_status;
+
+	status = src_obj->obj_ops->test_access(src_obj, FSAL_READ_ACCESS,
+					       NULL, NULL, true);
+	if (!FSAL_IS_ERROR(status))
+		status = dst_obj->obj_ops->test_access(dst_obj,
+						       FSAL_WRITE_ACCESS,
+						       NULL, NULL, true);
+	if (FSAL_IS_ERROR(status))
+		return nfs4_Errno_status(status);
+
+	/* The source range must be within the file, a count of 0 means up
+	 * to its end.
+	 */
+	fsal_prepare_attrs(&attrs, ATTR_SIZE);
+	status = src_obj->obj_ops->getattrs(src_obj, &attrs);
+	fsal_release_attrs(&attrs);
+	if (FSAL_IS_ERROR(status))
+		return nfs4_Errno_status(status);
+
+	if (src_offset > attrs.filesize ||
+	    *count > attrs.filesize - src_offset)
+		return NFS4ERR_INVAL;
+
+	if (*count == 0)
+		*count = attrs.filesize - src_offset;
+
+	/* Neither range may wrap around, which the tests below rely on */
+	if (*count > UINT64_MAX - src_offset)
+		return NFS4ERR_INVAL;
+
+	if (*count > UINT64_MAX - dst_offset)
+		return NFS4ERR_FBIG;
+
+	/* Within one file the ranges can't overlap */
+	if (src_obj == dst_obj &&
+	    src_offset < dst_offset + *count &&
+	    dst_offset < src_offset + *count)
+		return NFS4ERR_INVAL;
+
+	if (MaxOffsetWrite < UINT64_MAX &&
+	    dst_offset + *count > MaxOffsetWrite) {
+		LogEvent(COMPONENT_NFS_V4,
+			 "A client tried to violate max file size %"
+			 PRIu64 " for exportid #%hu",
+			 MaxOffsetWrite, op_ctx->ctx_export->export_id);
+		return NFS4ERR_FBIG;
+	}
+
+	return NFS4_OK;
+}
+
+/**
+ * @brief The NFS4_OP_COPY operation
+ *
+ * Copies from the file of the saved filehandle to the file of the current
+ * filehandle.
+ *
+ * @param[in]     op    Arguments for nfs4_op
+ * @param[in,out] data  Compound request's data
+ * @param[out]    resp  Results for nfs4_op
+ *
+ * @return per RFC 7862
+ */
+enum nfs_req_result nfs4_op_copy(struct nfs_argop4 *op,
+				 compound_data_t *data,
+				 struct nfs_resop4 *resp)
+{
+	COPY4args * const args = &op->nfs_argop4_u.opcopy;
+	COPY4res * const res = &resp->nfs_resop4_u.opcopy;
+	write_response4 *wr = &res->COPY4res_u.cr_resok4.cr_response;
+	copy_requirements4 *req = &res->COPY4res_u.cr_resok4.cr_requirements;
+	state_t *src_state = NULL, *dst_state = NULL;
+	struct gsh_buffdesc verf_desc;
+	fsal_status_t status;
+	uint64_t count = args->ca_count, copied = 0;
+
+	resp->resop = NFS4_OP_COPY;
+	memset(res, 0, sizeof(*res));
+
+	/* Only copies within this server */
+	if (args->ca_source_server.ca_source_server_len != 0) {
+		res->cr_status = NFS4ERR_NOTSUPP;
+		goto out;
+	}
+
+	res->cr_status = copy_prepare(data, &args->ca_src_stateid,
+				      &args->ca_dst_stateid,
+				      args->ca_src_offset, args->ca_dst_offset,
+				      &count, &src_state, &dst_state);
+	if (res->cr_status != NFS4_OK)
+		goto out;
+
+	LogFullDebug(COMPONENT_NFS_V4,
+		     "src_offset = %" PRIu64 " dst_offset = %" PRIu64
+		     " count = %" PRIu64 " synchronous = %d",
+		     args->ca_src_offset, args->ca_dst_offset, count,
+		     args->ca_synchronous);
+
+	verf_desc.addr = wr->wr_writeverf;
+	verf_desc.len = sizeof(verifier4);
+	op_ctx->fsal_export->exp_ops.get_write_verifier(op_ctx->fsal_export,
+							&verf_desc);
+	wr->wr_committed = UNSTABLE4;
+	req->cr_consecutive = TRUE;
+
+	/* Large copies go to the background if the client allows it and can
+	 * be called back.  If they can't be started, a part is copied now.
+	 */
+	if (count > COPY_SYNC_MAX && !args->ca_synchronous &&
+	    data->session != NULL &&
+	    (atomic_fetch_uint32_t(&data->session->flags) & session_bc_up)) {
+		res->cr_status = copy_start_async(data, args, src_state,
+						  dst_state, count, wr);
+		if (res->cr_status == NFS4_OK) {
+			/* The copy holds the state references now */
+			src_state = NULL;
+			dst_state = NULL;
+			req->cr_synchronous = FALSE;
+			goto out;
+		}
+	}
+
+	/* A synchronous copy may be short, the client asks for the rest */
+	status = copy_chunks(data->saved_obj, src_state, args->ca_src_offset,
+			     data->current_obj, dst_state,
+			     args->ca_dst_offset, MIN(count, COPY_SYNC_MAX),
+			     &copied, NULL);
+
+	if (FSAL_IS_ERROR(status) && copied == 0) {
+		res->cr_status = nfs4_Errno_status(status);
+		goto out;
+	}
+
+	wr->wr_ids = 0;
+	wr->wr_count = copied;
+	req->cr_synchronous = TRUE;
+	res->cr_status = NFS4_OK;
+
+out:
+	if (src_state != NULL)
+		dec_state_t_ref(src_state);
+	if (dst_state != NULL)
+		dec_state_t_ref(dst_state);
+
+	return nfsstat4_to_nfs_req_result(res->cr_status);
+}
+
+/**
+ * @brief Free memory allocated for COPY result
+ *
+ * @param[in,out] resp nfs4_op results
+ */
+void nfs4_op_copy_Free(nfs_resop4 *resp)
+{
+	/* Nothing to be done */
+}
+
+/**
+ * @brief The NFS4_OP_CLONE operation
+ *
+ * Makes the range of the file of the current filehandle share the storage
+ * of the range of the file of the saved filehandle, where the FSAL can.
+ *
+ * @param[in]     op    Arguments for nfs4_op
+ * @param[in,out] data  Compound request's data
+ * @param[out]    resp  Results for nfs4_op
+ *
+ * @return per RFC 7862
+ */
+enum nfs_req_result nfs4_op_clone(struct nfs_argop4 *op,
+				  compound_data_t *data,
+				  struct nfs_resop4 *resp)
+{
+	CLONE4args * const args = &op->nfs_argop4_u.opclone;
+	CLONE4res * const res = &resp->nfs_resop4_u.opclone;
+	state_t *src_state = NULL, *dst_state = NULL;
+	fsal_status_t status;
+	uint64_t count = args->cl_count;
+
+	resp->resop = NFS4_OP_CLONE;
+
+	res->cl_status = copy_prepare(data, &args->cl_src_stateid,
+				      &args->cl_dst_stateid,
+				      args->cl_src_offset, args->cl_dst_offset,
+				      &count, &src_state, &dst_state);
+	if (res->cl_status != NFS4_OK)
+		goto out;
+
+	LogFullDebug(COMPONENT_NFS_V4,
+		     "src_offset = %" PRIu64 " dst_offset = %" PRIu64
+		     " count = %" PRIu64,
+		     args->cl_src_offset, args->cl_dst_offset, count);
+
+	status = data->saved_obj->obj_ops->clone(data->saved_obj, src_state,
+						 args->cl_src_offset,
+						 data->current_obj, dst_state,
+						 args->cl_dst_offset, count);
+
+	res->cl_status = nfs4_Errno_status(status);
+
+out:
+	if (src_state != NULL)
+		dec_state_t_ref(src_state);
+	if (dst_state != NULL)
+		dec_state_t_ref(dst_state);
+
+	return nfsstat4_to_nfs_req_result(res->cl_status);
+}
+
+/**
+ * @brief Free memory allocated for CLONE result
+ *
+ * @param[in,out] resp nfs4_op results
+ */
+void nfs4_op_clone_Free(nfs_resop4 *resp)
+{
+	/* Nothing to be done */
+}
+
+/**
+ * @brief The NFS4_OP_OFFLOAD_STATUS operation
+ *
+ * @param[in]     op    Arguments for nfs4_op
+ * @param[in,out] data  Compound request's data
+ * @param[out]    resp  Results for nfs4_op
+ *
+ * @return per RFC 7862
+ */
+enum nfs_req_result nfs4_op_offload_status(struct nfs_argop4 *op,
+					   compound_data_t *data,
+					   struct nfs_resop4 *resp)
+{
+	OFFLOAD_STATUS4args * const args = &op->nfs_argop4_u.opoffload_status;
+	OFFLOAD_STATUS4res * const res = &resp->nfs_resop4_u.opoffload_status;
+	OFFLOAD_STATUS4resok *resok = &res->OFFLOAD_STATUS4res_u.osr_resok4;
+	struct nfs4_copy *copy;
+
+	resp->resop = NFS4_OP_OFFLOAD_STATUS;
+	memset(res, 0, sizeof(*res));
+
+	PTHREAD_MUTEX_lock(&copy_mutex);
+
+	copy = copy_lookup(data, &args->osa_stateid);
+	if (copy == NULL) {
+		res->osr_status = NFS4ERR_BAD_STATEID;
+	} else {
+		resok->osr_bytes_copied = atomic_fetch_uint64_t(&copy->copied);
+		if (copy->done) {
+			resok->osr_count_complete = 1;
+			resok->osr_complete = copy->status;
+		}
+		res->osr_status = NFS4_OK;
+	}
+
+	PTHREAD_MUTEX_unlock(&copy_mutex);
+
+	return nfsstat4_to_nfs_req_result(res->osr_status);
+}
+
+/**
+ * @brief Free memory allocated for OFFLOAD_STATUS result
+ *
+ * @param[in,out] resp nfs4_op results
+ */
+void nfs4_op_offload_status_Free(nfs_resop4 *resp)
+{
+	/* Nothing to be done */
+}
+
+/**
+ * @brief The NFS4_OP_OFFLOAD_CANCEL operation
+ *
+ * The copy stops after the chunk in progress; no CB_OFFLOAD is sent for
+ * it.
+ *
+ * @param[in]     op    Arguments for nfs4_op
+ * @param[in,out] data  Compound request's data
+ * @param[out]    resp  Results for nfs4_op
+ *
+ * @return per RFC 7862
+ */
+enum nfs_req_result nfs4_op_offload_cancel(struct nfs_argop4 *op,
+					   compound_data_t *data,
+					   struct nfs_resop4 *resp)
+{
+	OFFLOAD_ABORT4args * const args = &op->nfs_argop4_u.opoffload_abort;
+	OFFLOAD_ABORT4res * const res = &resp->nfs_resop4_u.opoffload_abort;
+	struct nfs4_copy *copy;
+
+	resp->resop = NFS4_OP_OFFLOAD_CANCEL;
+
+	PTHREAD_MUTEX_lock(&copy_mutex);
+
+	copy = copy_lookup(data, &args->oaa_stateid);
+	if (copy == NULL) {
+		res->oar_status = NFS4ERR_BAD_STATEID;
+	} else {
+		/* Too late once done, CB_OFFLOAD is on its way */
+		if (!copy->done)
+			atomic_store_uint32_t(&copy->cancelled, 1);
+		res->oar_status = NFS4_OK;
+	}
+
+	PTHREAD_MUTEX_unlock(&copy_mutex);
+
+	return nfsstat4_to_nfs_req_result(res->oar_status);
+}
+
+/**
+ * @brief Free memory allocated for OFFLOAD_CANCEL result
+ *
+ * @param[in,out] resp nfs4_op results
+ */
+void nfs4_op_offload_cancel_Free(nfs_resop4 *resp)
+{
+	/* Nothing to be done */
+}
+
+/**
+ * @brief Start the fridge for asynchronous copies
+ */
+void nfs4_copy_pkginit(void)
+{
+	struct fridgethr_params frp;
+	int rc;
+
+	PTHREAD_MUTEX_init(&copy_mutex, NULL);
+	glist_init(&copy_list);
+
+	memset(&frp, 0, sizeof(frp));
+	frp.thr_max = COPY_THREADS;
+	frp.deferment = fridgethr_defer_queue;
+
+	rc = fridgethr_init(&copy_fridge, "nfs4_copy", &frp);
+	if (rc != 0)
+		LogFatal(COMPONENT_INIT,
+			 "Unable to initialize copy thread fridge: %d", rc);
+}
+
+/**
+ * @brief Stop asynchronous copies
+ *
+ * Copies in progress notice the shutdown at the next chunk.
+ */
+void nfs4_copy_pkgshutdown(void)
+{
+	int rc;
+
+	rc = fridgethr_sync_command(copy_fridge, fridgethr_comm_stop, 120);
+
+	if (rc == ETIMEDOUT) {
+		LogMajor(COMPONENT_THREAD,
+			 "Shutdown timed out, cancelling copy threads.");
+		fridgethr_cancel(copy_fridge);
+	} else if (rc != 0) {
+		LogMajor(COMPONENT_THREAD,
+			 "Failed shutting down copy threads: %d", rc);
+	}
+}
@@ -107,7 +107,7 @@ enum nfs_req_result nfs4_op_create_session(struct nfs_argop4 *op,
 	struct display_buffer dspbuf_clientid4 = {
 		sizeof(str_clientid4), str_clientid4, str_clientid4};
 	/* Return code from clientid calls */
-	int i, rc = 0;
+	int rc = 0;
 	/* Component for logging */
 	log_components_t component = COMPONENT_CLIENTID;
 	/* Abbreviated alias for arguments */
@@ -361,8 +361,6 @@ enum nfs_req_result nfs4_op_create_session(struct nfs_argop4 *op,
 					     sizeof(nfs41_session_slot_t));
 	nfs41_session->bc_slots = gsh_calloc(nfs41_session->nb_slots,
 					     sizeof(nfs41_cb_session_slot_t));
-	for (i = 0; i < nfs41_session->nb_slots; i++)
-		PTHREAD_MUTEX_init(&nfs41_session->fc_slots[i].slot_lock, NULL);
 
 	/* Take reference to clientid record on behalf the session. */
 	inc_client_id_ref(found);
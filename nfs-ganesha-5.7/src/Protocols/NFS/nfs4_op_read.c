@@ -63,10 +63,36 @@ struct nfs4_read_data {
 	uint32_t flags;
 	/** IO Info for READ_PLUS */
 	struct io_info info;
+	/** Status of the read, set by nfs4_read_cb */
+	nfsstat4 status;
 	/** Arguments for read call - must be last */
 	struct fsal_io_arg read_arg;
 };
 
+/**
+ * Set in nfs4_read_data flags when a read started ahead of its op won't
+ * be used; whoever of the callback and the compound comes last frees it.
+ */
+#define READ_AHEAD_ORPHAN 4
+
+/**
+ * @brief READs of a COMPOUND started ahead of their turn
+ *
+ * When a READ is followed by more READs of the same file with the same
+ * stateid, their reads are handed to the FSAL together, so an FSAL that
+ * does I/O asynchronously has them all in flight at once.  Each READ still
+ * runs all its checks in order and then takes over its read, or leaves it
+ * orphaned if anything changed.
+ */
+struct nfs4_read_ahead {
+	/** Position in the compound of reads[0] */
+	uint32_t first;
+	/** Number of entries in reads */
+	uint32_t count;
+	/** The reads, NULL once taken over or orphaned */
+	struct nfs4_read_data *reads[];
+};
+
 /**
  * Indicate type of read operation this is.
  */
@@ -80,6 +106,8 @@ static enum nfs_req_result nfs4_complete_read(struct nfs4_read_data *data)
 {
 	struct fsal_io_arg *read_arg = &data->read_arg;
 
+	data->res_READ4->status = data->status;
+
 	if (data->res_READ4->status == NFS4_OK) {
 		if (nfs_param.core_param.getattrs_in_complete_read &&
 				!read_arg->end_of_file) {
@@ -173,6 +201,188 @@ static void nfs4_complete_read_plus(struct nfs_resop4 *resp,
 	}
 }
 
+static void nfs4_read_ahead_free(struct nfs4_read_data *read_data)
+{
+	gsh_free(read_data->read_arg.iov[0].iov_base);
+	if (read_data->read_arg.state != NULL)
+		dec_state_t_ref(read_data->read_arg.state);
+	read_data->obj->obj_ops->put_ref(read_data->obj);
+	gsh_free(read_data);
+}
+
+/**
+ * @brief Give up on a read started ahead
+ *
+ * @param[in] read_data  The read
+ */
+static void nfs4_read_ahead_orphan(struct nfs4_read_data *read_data)
+{
+	uint32_t flags;
+
+	flags = atomic_postset_uint32_t_bits(&read_data->flags,
+					     ASYNC_PROC_EXIT |
+					     READ_AHEAD_ORPHAN);
+
+	/* If the read is still in progress, nfs4_read_cb frees it */
+	if ((flags & ASYNC_PROC_DONE) == ASYNC_PROC_DONE)
+		nfs4_read_ahead_free(read_data);
+}
+
+/**
+ * @brief Release the reads of a COMPOUND that were started ahead
+ *
+ * @param[in,out] data  Compound request's data
+ */
+void nfs4_read_ahead_release(compound_data_t *data)
+{
+	struct nfs4_read_ahead *ahead = data->read_ahead;
+	uint32_t i;
+
+	if (ahead == NULL)
+		return;
+
+	for (i = 0; i < ahead->count; i++) {
+		if (ahead->reads[i] != NULL)
+			nfs4_read_ahead_orphan(ahead->reads[i]);
+	}
+
+	gsh_free(ahead);
+	data->read_ahead = NULL;
+}
+
+/**
+ * @brief Take over the read started ahead for the current op
+ *
+ * @param[in,out] data    Compound request's data
+ * @param[in]     offset  Offset the op reads at
+ * @param[in]     size    Bytes the op reads
+ * @param[in]     state   State the op reads with
+ *
+ * @return The read, or NULL if there is none or it doesn't match.
+ */
+static struct nfs4_read_data *nfs4_read_ahead_take(compound_data_t *data,
+						   uint64_t offset,
+						   uint64_t size,
+						   state_t *state)
+{
+	struct nfs4_read_ahead *ahead = data->read_ahead;
+	struct nfs4_read_data *read_data;
+	uint32_t i;
+
+	if (ahead == NULL || data->oppos < ahead->first ||
+	    data->oppos - ahead->first >= ahead->count)
+		return NULL;
+
+	i = data->oppos - ahead->first;
+	read_data = ahead->reads[i];
+	ahead->reads[i] = NULL;
+
+	if (read_data == NULL)
+		return NULL;
+
+	if (read_data->read_arg.offset != offset ||
+	    read_data->read_arg.iov[0].iov_len != size ||
+	    read_data->read_arg.state != state) {
+		nfs4_read_ahead_orphan(read_data);
+		return NULL;
+	}
+
+	return read_data;
+}
+
+static void nfs4_read_cb(struct fsal_obj_handle *obj, fsal_status_t ret,
+			 void *read_data, void *caller_data);
+
+/**
+ * @brief Start the READs that follow the current one
+ *
+ * Only READs right after the current op, with the very same stateid, are
+ * started: with no op in between, they are on the same file and pass the
+ * same stateid and permission checks.
+ *
+ * @param[in,out] data     Compound request's data
+ * @param[in]     obj      File being read
+ * @param[in]     stateid  Stateid of the current READ
+ * @param[in]     state    State found for it, or NULL
+ * @param[in]     bypass   Whether to bypass share reservations
+ */
+static void nfs4_read_start_ahead(compound_data_t *data,
+				  struct fsal_obj_handle *obj,
+				  stateid4 *stateid, state_t *state,
+				  bool bypass)
+{
+	uint32_t max = nfs_param.nfsv4_param.compound_parallel_reads;
+	uint64_t MaxRead, MaxOffsetRead;
+	struct nfs4_read_ahead *ahead;
+	struct nfs4_read_data *read_data;
+	READ4args *arg;
+	uint32_t count, i;
+	uint64_t size;
+
+	nfs4_read_ahead_release(data);
+
+	if (max == 0 || data->minorversion == 0)
+		return;
+
+	for (count = 0;
+	     count < max && data->oppos + 1 + count < data->argarray_len;
+	     count++) {
+		arg = &data->argarray[data->oppos + 1 + count]
+							.nfs_argop4_u.opread;
+		if (data->argarray[data->oppos + 1 + count].argop !=
+							NFS4_OP_READ ||
+		    memcmp(&arg->stateid, stateid, sizeof(*stateid)) != 0)
+			break;
+	}
+
+	if (count == 0)
+		return;
+
+	MaxRead = atomic_fetch_uint64_t(&op_ctx->ctx_export->MaxRead);
+	MaxOffsetRead =
+		atomic_fetch_uint64_t(&op_ctx->ctx_export->MaxOffsetRead);
+
+	ahead = gsh_calloc(1, sizeof(*ahead) + count * sizeof(read_data));
+	ahead->first = data->oppos + 1;
+	data->read_ahead = ahead;
+
+	for (i = 0; i < count; i++) {
+		arg = &data->argarray[ahead->first + i].nfs_argop4_u.opread;
+		size = MIN(arg->count, MaxRead);
+
+		/* Leave anything unusual to the op itself */
+		if (size == 0 || (MaxOffsetRead < UINT64_MAX &&
+				  arg->offset + size > MaxOffsetRead))
+			break;
+
+		read_data = gsh_calloc(1, sizeof(*read_data) +
+					  sizeof(struct iovec));
+		read_data->read_arg.state = state;
+		read_data->read_arg.offset = arg->offset;
+		read_data->read_arg.iov_count = 1;
+		read_data->read_arg.iov[0].iov_len = size;
+		read_data->read_arg.iov[0].iov_base =
+			gsh_malloc_aligned(4096, RNDUP(size));
+		read_data->data = data;
+		read_data->obj = obj;
+
+		if (state != NULL)
+			inc_state_t_ref(state);
+		obj->obj_ops->get_ref(obj);
+
+		ahead->reads[i] = read_data;
+		ahead->count = i + 1;
+
+		LogFullDebug(COMPONENT_NFS_V4,
+			     "Starting READ %" PRIu32 " ahead, offset = %"
+			     PRIu64 " size = %" PRIu64,
+			     ahead->first + i, arg->offset, size);
+
+		obj->obj_ops->read2(obj, bypass, nfs4_read_cb,
+				    &read_data->read_arg, read_data);
+	}
+}
+
 /**
  * @brief Callback for NFS4 read done
  *
@@ -192,11 +402,14 @@ static void nfs4_read_cb(struct fsal_obj_handle *obj, fsal_status_t ret,
 		ret = fsalstat(ERR_FSAL_LOCKED, 0);
 
 	/* Get result */
-	data->res_READ4->status = nfs4_Errno_status(ret);
+	data->status = nfs4_Errno_status(ret);
 
 	flags = atomic_postset_uint32_t_bits(&data->flags, ASYNC_PROC_DONE);
 
-	if ((flags & ASYNC_PROC_EXIT) == ASYNC_PROC_EXIT) {
+	if ((flags & READ_AHEAD_ORPHAN) == READ_AHEAD_ORPHAN) {
+		/* A read started ahead that the compound gave up on */
+		nfs4_read_ahead_free(data);
+	} else if ((flags & ASYNC_PROC_EXIT) == ASYNC_PROC_EXIT) {
 		/* nfs4_read has already exited, we will need to reschedule
 		 * the request for completion.
 		 */
@@ -486,6 +699,7 @@ static enum nfs_req_result nfs4_read(struct nfs_argop4 *op,
 	struct nfs4_read_data *read_data = NULL;
 	struct fsal_io_arg *read_arg;
 	uint32_t resp_size;
+	bool start_ahead = io == IO_READ;
 	/* In case we don't call read2, we indicate the I/O as already done
 	 * since in that case we should go ahead and exit as expected.
 	 */
@@ -719,6 +933,32 @@ static enum nfs_req_result nfs4_read(struct nfs_argop4 *op,
 		goto out;
 	}
 
+	/* The read may already have been started along with an earlier READ
+	 * of this compound.
+	 */
+	if (io == IO_READ)
+		read_data = nfs4_read_ahead_take(data, offset, size,
+						 state_found);
+
+	if (read_data != NULL) {
+		LogFullDebug(COMPONENT_NFS_V4,
+			     "Using read_data %p started ahead", read_data);
+
+		/* It holds its own references */
+		obj->obj_ops->put_ref(obj);
+		if (state_found != NULL)
+			dec_state_t_ref(state_found);
+
+		read_data->res_READ4 = res_READ4;
+		read_arg = &read_data->read_arg;
+		data->op_data = read_data;
+		start_ahead = false;
+
+		flags = atomic_postset_uint32_t_bits(&read_data->flags,
+						     ASYNC_PROC_EXIT);
+		goto out;
+	}
+
 	/* Some work is to be done */
 	bufferdata = gsh_malloc_aligned(4096, RNDUP(size));
 
@@ -759,6 +999,15 @@ again:
 	/* Do the actual read */
 	obj->obj_ops->read2(obj, bypass, nfs4_read_cb, read_arg, read_data);
 
+	/* Before this op can be resumed, hand the following READs to the
+	 * FSAL as well.
+	 */
+	if (start_ahead) {
+		start_ahead = false;
+		nfs4_read_start_ahead(data, obj, &arg_READ4->stateid,
+				      state_found, bypass);
+	}
+
 	/* Only atomically set the flags if we actually call read2, otherwise
 	 * we will have indicated as having been DONE.
 	 */
@@ -90,7 +90,7 @@ static void restore_data(struct nfs4_readdir_cb_data *tracker)
  * @param[in,out] opaque A struct nfs4_readdir_cb_data that stores the
  *                       location of the array and other bookkeeping
  *                       information
- * @param[in]     obj	 Current file
+ * @param[in]     obj	 Current file, NULL if served from the dirent alone
  * @param[in]     attrs  The current file's attributes
  * @param[in]     cookie The readdir cookie for the current entry
  */
@@ -144,7 +144,7 @@ fsal_errors_t nfs4_readdir_callback(void *opaque,
 	 *       that root inode to proceed rather than getting stuck in a
 	 *       junction crossing infinite loop.
 	 */
-	if (obj->type == DIRECTORY && cb_parms->attr_allowed &&
+	if (obj != NULL && obj->type == DIRECTORY && cb_parms->attr_allowed &&
 	    cb_state == CB_ORIGINAL) {
 		lock_dir = true;
 		PTHREAD_RWLOCK_rdlock(&obj->state_hdl->jct_lock);
@@ -289,8 +289,12 @@ not_junction:
 	args.data = data;
 	args.hdl4 = &entryFH;
 	args.mounted_on_fileid = mounted_on_fileid;
-	args.fileid = obj->fileid;
-	args.fsid = obj->fsid;
+	if (obj != NULL) {
+		args.fileid = obj->fileid;
+		args.fsid = obj->fsid;
+	} else {
+		args.fileid = attr->fileid;
+	}
 
 	/* Now process the entry */
 	memset(val_fh, 0, NFS4_FHSIZE);
@@ -365,6 +369,14 @@ not_junction:
 		goto skip;
 	}
 
+	if (obj == NULL) {
+		/* Only cheap attributes were asked for and the FSAL served
+		 * them from the dirent. There is no ACL to check access for
+		 * and only directories can be referrals.
+		 */
+		goto encode;
+	}
+
 	/* Adjust access mask if ACL is asked for.
 	 * NOTE: We intentionally do NOT check ACE4_READ_ATTR.
 	 */
@@ -411,8 +423,10 @@ not_junction:
 	 * in READDIR of a directory that contains junctions (ex:- pseudo
 	 * namespace)
 	 */
+encode:
 	saved_current_obj = data->current_obj;
-	data->current_obj = obj;
+	if (obj != NULL)
+		data->current_obj = obj;
 	if (!xdr_encode_entry4(&tracker->xdr, &args, tracker->req_attr,
 			       cookie, &name) ||
 	    (xdr_getpos(&tracker->xdr) + BYTES_PER_XDR_UNIT)
@@ -499,6 +513,34 @@ void xdr_dirlist4_uio_release(struct xdr_uio *uio, u_int flags)
 	}
 }
 
+/**
+ * @brief Check if the requested attributes can be served from dirents
+ *
+ * @param[in] req_attr The attributes requested by the client
+ *
+ * @return true if nothing beyond type and fileid of the entries is needed.
+ */
+static bool nfs4_readdir_dirent_only(struct bitmap4 *req_attr)
+{
+	int attr;
+
+	for (attr = next_attr_from_bitmap(req_attr, -1);
+	     attr != -1;
+	     attr = next_attr_from_bitmap(req_attr, attr)) {
+		switch (attr) {
+		case FATTR4_RDATTR_ERROR:
+		case FATTR4_TYPE:
+		case FATTR4_FILEID:
+		case FATTR4_MOUNTED_ON_FILEID:
+			break;
+		default:
+			return false;
+		}
+	}
+
+	return true;
+}
+
 /* Base response size includes nfsstat4, eof, verifier and termination of
  * entries list.
  */
@@ -676,6 +718,12 @@ enum nfs_req_result nfs4_op_readdir(struct nfs_argop4 *op,
 	    op_ctx_export_has_option(EXPORT_OPTION_SECLABEL_SET))
 		attrmask |= ATTR4_SEC_LABEL;
 
+	/* Name only listings (find and friends) don't need the objects, let
+	 * the FSAL serve them from its dirents if it can.
+	 */
+	if (nfs4_readdir_dirent_only(tracker.req_attr))
+		attrmask |= ATTR_DIRENT_ONLY;
+
 	/* Perform the readdir operation */
 	fsal_status = fsal_readdir(dir_obj,
 				   cookie,
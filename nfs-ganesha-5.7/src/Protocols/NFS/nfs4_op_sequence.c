@@ -121,6 +121,36 @@ errout:
 	}
 }
 
+/**
+ * @brief Compute the slot count we would like the client to use
+ *
+ * While there are no more requests in flight than worker threads, the
+ * client may use all of its slots. Past that, the target shrinks in
+ * proportion to the backlog, down to a quarter of the slots, so clients
+ * back off while the server is overloaded and come back as it drains.
+ * The highest slotid does not change, so slots already in use stay valid.
+ *
+ * @param[in] session The session
+ *
+ * @return The sr_target_highest_slotid to return.
+ */
+
+static uint32_t nfs41_target_highest_slotid(nfs41_session_t *session)
+{
+	uint32_t slots = session->fore_channel_attrs.ca_maxrequests;
+	uint64_t workers = nfs_param.core_param.rpc.ioq_thrd_max;
+	uint64_t inflight = atomic_fetch_uint64_t(&nfs_health_.enqueued_reqs) -
+			    atomic_fetch_uint64_t(&nfs_health_.dequeued_reqs);
+	uint32_t target;
+
+	if (inflight <= workers || inflight > UINT32_MAX)
+		return slots - 1;
+
+	target = MAX(slots * workers / inflight, MAX(slots / 4, 1));
+
+	return target - 1;
+}
+
 /**
  * @brief the NFS4_OP_SEQUENCE operation
  *
@@ -165,8 +195,11 @@ enum nfs_req_result nfs4_op_sequence(struct nfs_argop4 *op,
 
 	LogDebug(COMPONENT_SESSIONS, "SEQUENCE session=%p", session);
 
-	/* Check if lease is expired and reserve it */
-	if (!reserve_lease_or_expire(session->clientid_record, false)) {
+	/* Check if lease is expired and reserve it.  While the client has
+	 * other requests in progress, it can't be, and no lock is needed.
+	 */
+	if (!reserve_lease_fast(session->clientid_record) &&
+	    !reserve_lease_or_expire(session->clientid_record, false)) {
 		dec_session_ref(session);
 		res_SEQUENCE4->sr_status = NFS4ERR_EXPIRED;
 		LogDebugAlt(COMPONENT_SESSIONS, COMPONENT_CLIENTID,
@@ -191,8 +224,19 @@ enum nfs_req_result nfs4_op_sequence(struct nfs_argop4 *op,
 
 	slot = &session->fc_slots[slotid];
 
-	/* Serialize use of this slot. */
-	PTHREAD_MUTEX_lock(&slot->slot_lock);
+	/* Claim the slot. If a request is still in progress on it, the
+	 * client retried before we replied, tell it to try again later.
+	 */
+	if (atomic_postset_uint32_t_bits(&slot->slot_busy, 1) != 0) {
+		dec_session_ref(session);
+		res_SEQUENCE4->sr_status = NFS4ERR_DELAY;
+		LogDebugAlt(COMPONENT_SESSIONS, COMPONENT_CLIENTID,
+			    "SEQUENCE returning status %s for busy slot %"
+			    PRIu32,
+			    nfsstat4_to_str(res_SEQUENCE4->sr_status),
+			    slotid);
+		return NFS_REQ_ERROR;
+	}
 
 	if (slot->sequence + 1 != arg_SEQUENCE4->sa_sequenceid) {
 		/* This sequence is NOT the next sequence */
@@ -234,13 +278,13 @@ enum nfs_req_result nfs4_op_sequence(struct nfs_argop4 *op,
 						slot->cached_result,
 						refcnt);
 
-				PTHREAD_MUTEX_unlock(&slot->slot_lock);
+				atomic_store_uint32_t(&slot->slot_busy, 0);
 
 				dec_session_ref(session);
 				return NFS_REQ_REPLAY;
 			} else {
 				/* Illegal replay */
-				PTHREAD_MUTEX_unlock(&slot->slot_lock);
+				atomic_store_uint32_t(&slot->slot_busy, 0);
 
 				dec_session_ref(session);
 				res_SEQUENCE4->sr_status =
@@ -257,7 +301,7 @@ enum nfs_req_result nfs4_op_sequence(struct nfs_argop4 *op,
 			}
 		}
 
-		PTHREAD_MUTEX_unlock(&slot->slot_lock);
+		atomic_store_uint32_t(&slot->slot_busy, 0);
 
 		dec_session_ref(session);
 		res_SEQUENCE4->sr_status = NFS4ERR_SEQ_MISORDERED;
@@ -288,11 +332,13 @@ enum nfs_req_result nfs4_op_sequence(struct nfs_argop4 *op,
 	res_SEQUENCE4->SEQUENCE4res_u.sr_resok4.sr_highest_slotid =
 	    session->nb_slots - 1;
 	res_SEQUENCE4->SEQUENCE4res_u.sr_resok4.sr_target_highest_slotid =
-	    session->fore_channel_attrs.ca_maxrequests - 1;
+	    nfs41_target_highest_slotid(session);
 
 	res_SEQUENCE4->SEQUENCE4res_u.sr_resok4.sr_status_flags = 0;
 
-	if (nfs_rpc_get_chan(session->clientid_record, 0) == NULL) {
+	/* This session's own back channel will do, without cid_mutex */
+	if (!(atomic_fetch_uint32_t(&session->flags) & session_bc_up) &&
+	    nfs_rpc_get_chan(session->clientid_record, 0) == NULL) {
 		res_SEQUENCE4->SEQUENCE4res_u.sr_resok4.sr_status_flags |=
 		    SEQ4_STATUS_CB_PATH_DOWN;
 	}
@@ -322,14 +368,14 @@ enum nfs_req_result nfs4_op_sequence(struct nfs_argop4 *op,
 		/* Indicate the failed response size. */
 		data->op_resp_size = sizeof(nfsstat4);
 
-		PTHREAD_MUTEX_unlock(&slot->slot_lock);
+		atomic_store_uint32_t(&slot->slot_busy, 0);
 
 		dec_session_ref(session);
 		data->session = NULL;
 		return NFS_REQ_ERROR;
 	}
 
-	/* We keep the slot lock to serialize use of the slot. */
+	/* The slot stays busy until the COMPOUND is done with it. */
 
 	(void) check_session_conn(session, data, true);
 
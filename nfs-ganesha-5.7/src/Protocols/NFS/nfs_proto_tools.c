@@ -3538,6 +3538,163 @@ void get_mounted_on_fileid(compound_data_t *data, uint64_t *mounted_on_fileid)
 	PTHREAD_RWLOCK_unlock(&op_ctx->ctx_export->exp_lock);
 }
 
+/**
+ * @brief Key of a cached GETATTR encoding
+ *
+ * Everything the encoding of the cacheable attributes depends on.  The
+ * attribute values are part of the key, so a cached encoding stops matching
+ * once any of them changes.
+ *
+ * Owner names also depend on the idmapper.  Its generation is part of the
+ * key, and is read before encoding, so an encoding that had to look a name
+ * up (or fell back to a numeric id or "nobody") is never reused.  The
+ * idmapper's own expiry period is in the key as well: a cached name is not
+ * served longer than the idmapper would have served it from its cache.
+ */
+struct fattr_cache_key {
+	struct bitmap4 request;
+	uint32_t minorversion;
+	uint16_t export_id;
+	attrmask_t valid_mask;
+	object_file_type_t type;
+	uint64_t change;
+	uint64_t filesize;
+	uint64_t fileid;
+	uint64_t fsid_major;
+	uint64_t fsid_minor;
+	uint32_t mode;
+	uint32_t numlinks;
+	uint64_t owner;
+	uint64_t group;
+	uint64_t idmap_gen;
+	time_t idmap_period;
+	fsal_dev_t rawdev;
+	uint64_t spaceused;
+	uint64_t mounted_on_fileid;
+	struct timespec atime;
+	struct timespec creation;
+	struct timespec ctime;
+	struct timespec mtime;
+};
+
+/**
+ * @brief Check whether every requested attribute can be cached
+ *
+ * These are the attributes asked for by the usual client GETATTR, whose
+ * encoding depends only on the values captured in struct fattr_cache_key.
+ */
+static bool fattr_cacheable(struct bitmap4 *Bitmap)
+{
+	int attr;
+
+	/* Names of an idmapper that does not cache are not cached either */
+	if ((attribute_is_set(Bitmap, FATTR4_OWNER) ||
+	     attribute_is_set(Bitmap, FATTR4_OWNER_GROUP)) &&
+	    !nfs_param.nfsv4_param.only_numeric_owners &&
+	    nfs_param.core_param.manage_gids_expiration <= 0)
+		return false;
+
+	if (Bitmap->bitmap4_len == 0 ||
+	    Bitmap->bitmap4_len > BITMAP4_MAPLEN)
+		return false;
+
+	for (attr = next_attr_from_bitmap(Bitmap, -1);
+	     attr != -1;
+	     attr = next_attr_from_bitmap(Bitmap, attr)) {
+		switch (attr) {
+		case FATTR4_TYPE:
+		case FATTR4_FH_EXPIRE_TYPE:
+		case FATTR4_CHANGE:
+		case FATTR4_SIZE:
+		case FATTR4_FSID:
+		case FATTR4_FILEID:
+		case FATTR4_MODE:
+		case FATTR4_NUMLINKS:
+		case FATTR4_OWNER:
+		case FATTR4_OWNER_GROUP:
+		case FATTR4_RAWDEV:
+		case FATTR4_SPACE_USED:
+		case FATTR4_TIME_ACCESS:
+		case FATTR4_TIME_CREATE:
+		case FATTR4_TIME_METADATA:
+		case FATTR4_TIME_MODIFY:
+		case FATTR4_MOUNTED_ON_FILEID:
+			break;
+		default:
+			return false;
+		}
+	}
+
+	return true;
+}
+
+static void fattr_cache_key_fill(struct fattr_cache_key *key,
+				 struct xdr_attrs_args *args,
+				 struct bitmap4 *Bitmap)
+{
+	struct fsal_attrlist *attrs = args->attrs;
+
+	/* Zeroed so that padding compares equal */
+	memset(key, 0, sizeof(*key));
+
+	key->request.bitmap4_len = Bitmap->bitmap4_len;
+	memcpy(key->request.map, Bitmap->map,
+	       Bitmap->bitmap4_len * sizeof(uint32_t));
+	key->minorversion = args->data->minorversion;
+	key->export_id = op_ctx->ctx_export->export_id;
+	key->valid_mask = attrs->valid_mask;
+
+	if (attribute_is_set(Bitmap, FATTR4_TYPE))
+		key->type = attrs->type;
+	if (attribute_is_set(Bitmap, FATTR4_CHANGE))
+		key->change = attrs->change;
+	if (attribute_is_set(Bitmap, FATTR4_SIZE))
+		key->filesize = attrs->filesize;
+	if (attribute_is_set(Bitmap, FATTR4_FILEID))
+		key->fileid = args->fileid;
+	if (attribute_is_set(Bitmap, FATTR4_FSID)) {
+		/* Same choice as encode_fsid() */
+		if (op_ctx_export_has_option_set(EXPORT_OPTION_FSID_SET)) {
+			key->fsid_major =
+				op_ctx->ctx_export->filesystem_id.major;
+			key->fsid_minor =
+				op_ctx->ctx_export->filesystem_id.minor;
+		} else {
+			key->fsid_major = args->fsid.major;
+			key->fsid_minor = args->fsid.minor;
+		}
+	}
+	if (attribute_is_set(Bitmap, FATTR4_MODE))
+		key->mode = attrs->mode;
+	if (attribute_is_set(Bitmap, FATTR4_NUMLINKS))
+		key->numlinks = attrs->numlinks;
+	if (attribute_is_set(Bitmap, FATTR4_OWNER))
+		key->owner = attrs->owner;
+	if (attribute_is_set(Bitmap, FATTR4_OWNER_GROUP))
+		key->group = attrs->group;
+	if ((attribute_is_set(Bitmap, FATTR4_OWNER) ||
+	     attribute_is_set(Bitmap, FATTR4_OWNER_GROUP)) &&
+	    !nfs_param.nfsv4_param.only_numeric_owners) {
+		key->idmap_gen = idmapper_generation();
+		key->idmap_period = time(NULL) /
+				nfs_param.core_param.manage_gids_expiration;
+	}
+	if (attribute_is_set(Bitmap, FATTR4_RAWDEV))
+		key->rawdev = attrs->rawdev;
+	if (attribute_is_set(Bitmap, FATTR4_SPACE_USED))
+		key->spaceused = attrs->spaceused;
+	if (attribute_is_set(Bitmap, FATTR4_MOUNTED_ON_FILEID))
+		key->mounted_on_fileid = args->mounted_on_fileid;
+	if (attribute_is_set(Bitmap, FATTR4_TIME_ACCESS))
+		key->atime = attrs->atime;
+	if (attribute_is_set(Bitmap, FATTR4_TIME_CREATE))
+		key->creation = attrs->creation;
+	if (attribute_is_set(Bitmap, FATTR4_TIME_METADATA))
+		key->ctime = attrs->ctime;
+	if (attribute_is_set(Bitmap, FATTR4_TIME_MODIFY))
+		key->mtime = attrs->mtime;
+}
+
 /**
  * @brief Fill NFSv4 Fattr from a file
  *
@@ -3568,6 +3725,9 @@ nfsstat4 file_To_Fattr(compound_data_t *data,
 		.data = data,
 		.hdl4 = &data->currentFH,
 	};
+	struct fattr_cache_key key;
+	struct gsh_buffdesc key_desc, val_desc;
+	bool cacheable;
 
 	/* Permission check only if ACL is asked for.
 	 * NOTE: We intentionally do NOT check ACE4_READ_ATTR.
@@ -3627,6 +3787,30 @@ nfsstat4 file_To_Fattr(compound_data_t *data,
 	/* Restore originally requested mask */
 	attr->request_mask = request_mask;
 
+	cacheable = fattr_cacheable(Bitmap);
+
+	if (cacheable) {
+		/* The values were just fetched, so if the FSAL kept an
+		 * encoding of exactly these values, reuse it.
+		 */
+		fattr_cache_key_fill(&key, &args, Bitmap);
+		key_desc.addr = &key;
+		key_desc.len = sizeof(key);
+
+		if (data->current_obj->obj_ops->encoded_attrs_get(
+				data->current_obj, &key_desc, &val_desc)) {
+			memcpy(&Fattr->attrmask, val_desc.addr,
+			       sizeof(Fattr->attrmask));
+			Fattr->attr_vals.attrlist4_len =
+				val_desc.len - sizeof(Fattr->attrmask);
+			Fattr->attr_vals.attrlist4_val = val_desc.addr;
+			memmove(Fattr->attr_vals.attrlist4_val,
+				(char *)val_desc.addr + sizeof(Fattr->attrmask),
+				Fattr->attr_vals.attrlist4_len);
+			return NFS4_OK;
+		}
+	}
+
 	if (nfs4_FSALattr_To_Fattr(&args, Bitmap, Fattr) != 0) {
 		/* Done with the attrs, caller won't release, but we did
 		 * fetch them.
@@ -3635,6 +3819,21 @@ nfsstat4 file_To_Fattr(compound_data_t *data,
 		return NFS4ERR_IO;
 	}
 
+	if (cacheable && Fattr->attr_vals.attrlist4_len != 0) {
+		val_desc.len = sizeof(Fattr->attrmask) +
+			       Fattr->attr_vals.attrlist4_len;
+		val_desc.addr = gsh_malloc(val_desc.len);
+		memcpy(val_desc.addr, &Fattr->attrmask,
+		       sizeof(Fattr->attrmask));
+		memcpy((char *)val_desc.addr + sizeof(Fattr->attrmask),
+		       Fattr->attr_vals.attrlist4_val,
+		       Fattr->attr_vals.attrlist4_len);
+
+		data->current_obj->obj_ops->encoded_attrs_put(
+				data->current_obj, &key_desc, &val_desc);
+		gsh_free(val_desc.addr);
+	}
+
 	return NFS4_OK;
 }
 
@@ -229,6 +229,9 @@ bool xdr_nfstime3(XDR *xdrs, nfstime3 *objp)
 	return (true);
 }
 
+/* XDR units of a fattr3 on the wire, see struct fattr3_wire */
+#define FATTR3_XDR_UNITS 21
+
 bool xdr_fattr3(XDR *xdrs, fattr3 *objp)
 {
 	ftype3 ft;
@@ -237,6 +240,7 @@ bool xdr_fattr3(XDR *xdrs, fattr3 *objp)
 	gid3 gid;
 	nfstime3 atime, mtime, ctime;
 	mode3 mode;
+	int32_t *buf;
 
 	if (xdrs->x_op == XDR_ENCODE) {
 		/* Convert object_file_type_t to ftype3 */
@@ -287,6 +291,54 @@ bool xdr_fattr3(XDR *xdrs, fattr3 *objp)
 		mtime.tv_nsec = objp->mtime.tv_nsec;
 		ctime.tv_sec = objp->ctime.tv_sec;
 		ctime.tv_nsec = objp->ctime.tv_nsec;
+
+		buf = xdr_inline_encode(xdrs,
+					FATTR3_XDR_UNITS * BYTES_PER_XDR_UNIT);
+		if (buf != NULL) {
+			/* most likely */
+			IXDR_PUT_ENUM(buf, ft);
+			IXDR_PUT_U_INT32(buf, mode);
+			IXDR_PUT_U_INT32(buf, objp->numlinks);
+			IXDR_PUT_U_INT32(buf, uid);
+			IXDR_PUT_U_INT32(buf, gid);
+			IXDR_PUT_U_INT64(buf, objp->filesize);
+			IXDR_PUT_U_INT64(buf, objp->spaceused);
+			IXDR_PUT_U_INT32(buf, rdev.specdata1);
+			IXDR_PUT_U_INT32(buf, rdev.specdata2);
+			IXDR_PUT_U_INT64(buf, objp->fsid3);
+			IXDR_PUT_U_INT64(buf, objp->fileid);
+			IXDR_PUT_U_INT32(buf, atime.tv_sec);
+			IXDR_PUT_U_INT32(buf, atime.tv_nsec);
+			IXDR_PUT_U_INT32(buf, mtime.tv_sec);
+			IXDR_PUT_U_INT32(buf, mtime.tv_nsec);
+			IXDR_PUT_U_INT32(buf, ctime.tv_sec);
+			IXDR_PUT_U_INT32(buf, ctime.tv_nsec);
+			return (true);
+		}
+	} else if (xdrs->x_op == XDR_DECODE) {
+		buf = xdr_inline_decode(xdrs,
+					FATTR3_XDR_UNITS * BYTES_PER_XDR_UNIT);
+		if (buf != NULL) {
+			/* most likely */
+			ft = IXDR_GET_ENUM(buf, ftype3);
+			mode = IXDR_GET_U_INT32(buf);
+			objp->numlinks = IXDR_GET_U_INT32(buf);
+			uid = IXDR_GET_U_INT32(buf);
+			gid = IXDR_GET_U_INT32(buf);
+			objp->filesize = IXDR_GET_U_INT64(buf);
+			objp->spaceused = IXDR_GET_U_INT64(buf);
+			rdev.specdata1 = IXDR_GET_U_INT32(buf);
+			rdev.specdata2 = IXDR_GET_U_INT32(buf);
+			objp->fsid3 = IXDR_GET_U_INT64(buf);
+			objp->fileid = IXDR_GET_U_INT64(buf);
+			atime.tv_sec = IXDR_GET_U_INT32(buf);
+			atime.tv_nsec = IXDR_GET_U_INT32(buf);
+			mtime.tv_sec = IXDR_GET_U_INT32(buf);
+			mtime.tv_nsec = IXDR_GET_U_INT32(buf);
+			ctime.tv_sec = IXDR_GET_U_INT32(buf);
+			ctime.tv_nsec = IXDR_GET_U_INT32(buf);
+			goto decoded;
+		}
 	}
 
 	if (!xdr_ftype3(xdrs, &ft))
@@ -316,7 +368,7 @@ bool xdr_fattr3(XDR *xdrs, fattr3 *objp)
 	if (!xdr_nfstime3(xdrs, &ctime))
 		return (false);
 
-
+decoded:
 	if (xdrs->x_op == XDR_DECODE) {
 		/* Convert ftype3 to object_file_type_t */
 		switch (ft) {
@@ -391,6 +443,32 @@ bool xdr_post_op_attr(XDR *xdrs, post_op_attr *objp)
 
 bool xdr_wcc_attr(XDR *xdrs, wcc_attr *objp)
 {
+	int32_t *buf;
+
+	if (xdrs->x_op == XDR_ENCODE) {
+		buf = xdr_inline_encode(xdrs, 6 * BYTES_PER_XDR_UNIT);
+		if (buf != NULL) {
+			/* most likely */
+			IXDR_PUT_U_INT64(buf, objp->size);
+			IXDR_PUT_U_INT32(buf, objp->mtime.tv_sec);
+			IXDR_PUT_U_INT32(buf, objp->mtime.tv_nsec);
+			IXDR_PUT_U_INT32(buf, objp->ctime.tv_sec);
+			IXDR_PUT_U_INT32(buf, objp->ctime.tv_nsec);
+			return (true);
+		}
+	} else if (xdrs->x_op == XDR_DECODE) {
+		buf = xdr_inline_decode(xdrs, 6 * BYTES_PER_XDR_UNIT);
+		if (buf != NULL) {
+			/* most likely */
+			objp->size = IXDR_GET_U_INT64(buf);
+			objp->mtime.tv_sec = IXDR_GET_U_INT32(buf);
+			objp->mtime.tv_nsec = IXDR_GET_U_INT32(buf);
+			objp->ctime.tv_sec = IXDR_GET_U_INT32(buf);
+			objp->ctime.tv_nsec = IXDR_GET_U_INT32(buf);
+			return (true);
+		}
+	}
+
 	if (!xdr_size3(xdrs, &objp->size))
 		return (false);
 	if (!xdr_nfstime3(xdrs, &objp->mtime))
@@ -924,9 +1002,10 @@ bool xdr_WRITE3args(XDR *xdrs, WRITE3args *objp)
 		return (false);
 	if (!xdr_stable_how(xdrs, &objp->stable))
 		return (false);
-	if (!xdr_bytes
+	if (!xdr_bytes_inplace
 	    (xdrs, (char **)&objp->data.data_val,
-	     &objp->data.data_len, XDR_BYTES_MAXLEN_IO))
+	     &objp->data.data_len, XDR_BYTES_MAXLEN_IO,
+	     &objp->data_inplace))
 		return (false);
 	lkhd->flags |= NFS_LOOKAHEAD_WRITE;
 	(lkhd->write)++;
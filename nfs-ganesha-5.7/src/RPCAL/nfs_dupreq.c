@@ -54,6 +54,9 @@
 #define DUPREQ_NOCACHE_NORES ((void *)0x03)
 #define DUPREQ_MAX_RETRIES 5
 
+/* Results kept for reuse by each thread */
+#define NFS_RES_CACHE_MAX 32
+
 #define NFS_pcp nfs_param.core_param
 #define NFS_program NFS_pcp.program
 
@@ -129,6 +132,16 @@ const char *dupreq_state_table[] = {
  * dupreq will exist beyond this call as it is in the hash table. A
  * dupreq eventually gets removed from the hash table when the drc gets
  * freed or in nfs_dupreq_finish() that decides to take out few dupreqs!
+ *
+ * The "hash table" of a per-connection (TCP) drc is a ring of chains
+ * indexed by xid. Clients hand out xids in sequence on a connection, so
+ * live requests spread evenly over the ring, and the single drc_mtx
+ * covers both the ring and the retire queue. The shared UDP drc keeps
+ * the partitioned rbtree_x, as its requests come from many clients.
+ *
+ * Memory is bounded globally by DRC_Max_Memory: past it, every drc
+ * retires on completion regardless of its own water marks, and drcs
+ * of disconnected clients are freed without waiting for them to expire.
  */
 struct drc_st {
 	pthread_mutex_t drc_st_mtx;
@@ -138,8 +151,12 @@ struct drc_st {
 	int32_t tcp_drc_recycle_qlen;
 	time_t last_expire_check;
 	uint32_t expire_delta;
+	uint64_t bytes;		/* held by cached requests, all drcs */
 };
 
+/* What a cached request costs, not counting memory hung off its result */
+#define DUPREQ_ENTRY_BYTES (sizeof(dupreq_entry_t) + sizeof(nfs_res_t))
+
 static struct drc_st *drc_st;
 
 /**
@@ -219,34 +236,61 @@ static inline int dupreq_shared_cmpf(const struct opr_rbtree_node *lhs,
 }
 
 /**
- * @brief Comparison function for entries in a per-connection (TCP) DRC
+ * @brief Head of the xid chain of a per-connection (TCP) DRC
  *
- * @param[in] lhs  Left-hand-side
- * @param[in] rhs  Right-hand-side
+ * @param[in] drc  The DRC
+ * @param[in] xid  Request xid
  *
- * @return -1,0,1.
+ * @return the chain head.
  */
-static inline int dupreq_tcp_cmpf(const struct opr_rbtree_node *lhs,
-				  const struct opr_rbtree_node *rhs)
+static inline dupreq_entry_t **drc_ring_slot(drc_t *drc, uint32_t xid)
 {
-	dupreq_entry_t *lk, *rk;
+	return &drc->d_u.tcp.ring[xid & drc->d_u.tcp.ring_mask];
+}
 
-	LogDebug(COMPONENT_DUPREQ, "Entering %s", __func__);
+/**
+ * @brief Find a request in a per-connection (TCP) DRC
+ *
+ * Requests match on xid and checksum.  Called with drc_mtx held.
+ *
+ * @param[in] drc  The DRC
+ * @param[in] dk   Key entry
+ *
+ * @return the cached entry, or NULL.
+ */
+static inline dupreq_entry_t *drc_ring_lookup(drc_t *drc, dupreq_entry_t *dk)
+{
+	dupreq_entry_t *dv;
 
-	lk = opr_containerof(lhs, dupreq_entry_t, rbt_k);
-	rk = opr_containerof(rhs, dupreq_entry_t, rbt_k);
+	for (dv = *drc_ring_slot(drc, dk->hin.tcp.rq_xid); dv;
+	     dv = dv->ring_next) {
+		if (dv->hin.tcp.rq_xid == dk->hin.tcp.rq_xid &&
+		    dv->hk == dk->hk)
+			break;
+	}
 
-	if (lk->hin.tcp.rq_xid < rk->hin.tcp.rq_xid)
-		return -1;
+	return dv;
+}
 
-	if (lk->hin.tcp.rq_xid == rk->hin.tcp.rq_xid) {
-		LogDebug(COMPONENT_DUPREQ,
-			 "xids eq %" PRIu32 ", ck1 %" PRIu64 " ck2 %" PRIu64,
-			 lk->hin.tcp.rq_xid, lk->hk, rk->hk);
-		return uint64_cmpf(lk->hk, rk->hk);
-	}
+static inline void drc_ring_insert(drc_t *drc, dupreq_entry_t *dv)
+{
+	dupreq_entry_t **slot = drc_ring_slot(drc, dv->hin.tcp.rq_xid);
 
-	return 1;
+	dv->ring_next = *slot;
+	*slot = dv;
+}
+
+static inline void drc_ring_remove(drc_t *drc, dupreq_entry_t *dv)
+{
+	dupreq_entry_t **pp = drc_ring_slot(drc, dv->hin.tcp.rq_xid);
+
+	for (; *pp; pp = &(*pp)->ring_next) {
+		if (*pp == dv) {
+			*pp = dv->ring_next;
+			dv->ring_next = NULL;
+			return;
+		}
+	}
 }
 
 /**
@@ -327,7 +371,8 @@ void dupreq2_pkginit(void)
 	dupreq_pool =
 	    pool_basic_init("Duplicate Request Pool", sizeof(dupreq_entry_t));
 
-	nfs_res_pool = pool_basic_init("nfs_res_t pool", sizeof(nfs_res_t));
+	nfs_res_pool = pool_cached_init("nfs_res_t pool", sizeof(nfs_res_t),
+					NFS_RES_CACHE_MAX);
 
 	tcp_drc_pool = pool_basic_init("TCP DRC Pool", sizeof(drc_t));
 
@@ -408,7 +453,7 @@ static inline enum drc_type get_drc_type(struct svc_req *req)
 static inline drc_t *alloc_tcp_drc(enum drc_type dtype)
 {
 	drc_t *drc = pool_alloc(tcp_drc_pool);
-	int ix, code __attribute__ ((unused)) = 0;
+	uint32_t ringsz;
 
 	drc->type = dtype;	/* DRC_TCP_V3 or DRC_TCP_V4 */
 	drc->refcnt = 0;
@@ -416,16 +461,16 @@ static inline drc_t *alloc_tcp_drc(enum drc_type dtype)
 	drc->d_u.tcp.recycle_time = 0;
 	drc->maxsize = nfs_param.core_param.drc.tcp.size;
 	drc->cachesz = nfs_param.core_param.drc.tcp.cachesz;
-	drc->npart = nfs_param.core_param.drc.tcp.npart;
+	drc->npart = 0;
 	drc->hiwat = nfs_param.core_param.drc.tcp.hiwat;
 
 	PTHREAD_MUTEX_init(&drc->drc_mtx, NULL);
 
-	/* init dict */
-	code =
-	    rbtx_init(&drc->xt, dupreq_tcp_cmpf, drc->npart,
-		      RBT_X_FLAG_ALLOC | RBT_X_FLAG_CACHE_WT);
-	assert(!code);
+	/* xid ring, a power of two no smaller than cachesz */
+	for (ringsz = 1; ringsz < drc->cachesz; ringsz <<= 1)
+		;
+	drc->d_u.tcp.ring = gsh_calloc(ringsz, sizeof(dupreq_entry_t *));
+	drc->d_u.tcp.ring_mask = ringsz - 1;
 
 	/* completed requests */
 	TAILQ_INIT(&drc->dupreq_q);
@@ -433,15 +478,6 @@ static inline drc_t *alloc_tcp_drc(enum drc_type dtype)
 	/* recycling DRC */
 	TAILQ_INIT_ENTRY(drc, d_u.tcp.recycle_q);
 
-	/* init "cache" partition */
-	for (ix = 0; ix < drc->npart; ++ix) {
-		struct rbtree_x_part *xp = &(drc->xt.tree[ix]);
-
-		drc->xt.cachesz = drc->cachesz;
-		xp->cache =
-		    gsh_calloc(drc->cachesz, sizeof(struct opr_rbtree_node *));
-	}
-
 	return drc;
 }
 
@@ -454,12 +490,7 @@ static inline drc_t *alloc_tcp_drc(enum drc_type dtype)
  */
 static inline void free_tcp_drc(drc_t *drc)
 {
-	int ix;
-
-	for (ix = 0; ix < drc->npart; ++ix) {
-		if (drc->xt.tree[ix].cache)
-			gsh_free(drc->xt.tree[ix].cache);
-	}
+	gsh_free(drc->d_u.tcp.ring);
 	PTHREAD_MUTEX_destroy(&drc->drc_mtx);
 	LogFullDebug(COMPONENT_DUPREQ, "free TCP drc %p", drc);
 	pool_free(tcp_drc_pool, drc);
@@ -499,6 +530,16 @@ static inline uint32_t nfs_dupreq_unref_drc(drc_t *drc)
 	(drc_st->tcp_drc_recycle_qlen >		\
 	nfs_param.core_param.drc.recycle_hiwat)
 
+/**
+ * @brief Whether cached requests exceed DRC_Max_Memory
+ */
+static inline bool drc_over_budget(void)
+{
+	uint64_t max = nfs_param.core_param.drc.max_memory;
+
+	return max != 0 && atomic_fetch_uint64_t(&drc_st->bytes) > max;
+}
+
 
 /**
  * @brief Check for expired TCP DRCs.
@@ -517,15 +558,15 @@ static inline void drc_free_expired(void)
 
 	if (((drc_st->tcp_drc_recycle_qlen < 1) ||
 	    (now - drc_st->last_expire_check) < 600) && /* 10m */
-			!DRC_QLEN_EXCEED_HIWAT())
+			!DRC_QLEN_EXCEED_HIWAT() && !drc_over_budget())
 		goto unlock;
 
 	do {
 		drc = TAILQ_FIRST(&drc_st->tcp_drc_recycle_q);
-		if ((drc && (drc->d_u.tcp.recycle_time > 0)
+		if (drc && (((drc->d_u.tcp.recycle_time > 0)
 		    && ((now - drc->d_u.tcp.recycle_time) >
 			drc_st->expire_delta)) ||
-				DRC_QLEN_EXCEED_HIWAT()) {
+				DRC_QLEN_EXCEED_HIWAT() || drc_over_budget())) {
 
 			assert(drc->refcnt == 0);
 
@@ -912,6 +953,7 @@ static inline void nfs_dupreq_free_dupreq(dupreq_entry_t *dv)
 		func = nfs_dupreq_func(dv);
 		func->free_function(dv->res);
 		free_nfs_res(dv->res);
+		(void)atomic_sub_uint64_t(&drc_st->bytes, DUPREQ_ENTRY_BYTES);
 	}
 	PTHREAD_MUTEX_destroy(&dv->dre_mtx);
 	pool_free(dupreq_pool, dv);
@@ -1006,6 +1048,10 @@ static inline bool drc_should_retire(drc_t *drc)
 	if (unlikely(drc->size > drc->maxsize))
 		return true;
 
+	/* nor the memory shared by all drcs */
+	if (unlikely(drc_over_budget()))
+		return true;
+
 	/* otherwise, are we permitted to retire requests */
 	if (unlikely(drc->retwnd > 0))
 		return false;
@@ -1050,6 +1096,7 @@ static inline bool nfs_dupreq_v4_cacheable(nfs_request_t *reqnfs)
 dupreq_status_t nfs_dupreq_start(nfs_request_t *reqnfs)
 {
 	dupreq_entry_t *dv = NULL, *dk = NULL;
+	struct rbtree_x_part *t = NULL;
 	drc_t *drc;
 	dupreq_status_t status = DUPREQ_SUCCESS;
 
@@ -1093,101 +1140,119 @@ dupreq_status_t nfs_dupreq_start(nfs_request_t *reqnfs)
 
 	dk->hk = reqnfs->svc.rq_cksum; /* TI-RPC computed checksum */
 
-	{
+	if (drc->type == DRC_UDP_V234) {
 		struct opr_rbtree_node *nv;
-		struct rbtree_x_part *t =
-		    rbtx_partition_of_scalar(&drc->xt, dk->hk);
+
+		t = rbtx_partition_of_scalar(&drc->xt, dk->hk);
 		PTHREAD_MUTEX_lock(&t->mtx);	/* partition lock */
 		nv = rbtree_x_cached_lookup(&drc->xt, t, &dk->rbt_k, dk->hk);
-		if (nv) {
-			/* cached request */
-			nfs_dupreq_free_dupreq(dk);
+		if (nv)
 			dv = opr_containerof(nv, dupreq_entry_t, rbt_k);
-			PTHREAD_MUTEX_lock(&dv->dre_mtx);
-
-			/* Count the number of duplicate requests received. */
-			dv->dupe_cnt++;
+	} else {
+		/* per-connection, drc lock covers the ring */
+		PTHREAD_MUTEX_lock(&drc->drc_mtx);
+		dv = drc_ring_lookup(drc, dk);
+	}
 
-			/* Check if the original request is complete or not. If
-			 * not, we queue up the duplicate request for potential
-			 * response later, however, do not queue more than
-			 * DUPREQ_MAX_DUPES duplicates, any beyond before the
-			 * request is completed will just be dropped.
-			 */
-			if (unlikely(!dv->complete)
-			    && dv->dupe_cnt <= DUPREQ_MAX_DUPES) {
-				status = DUPREQ_BEING_PROCESSED;
-				TAILQ_INSERT_TAIL(&dv->dupes, reqnfs, dupes);
-				reqnfs->svc.rq_resume_cb = drc_resume;
-			} else if (unlikely(!dv->complete)) {
-				/* Signal to nfs_dupreq_rele this should be
-				 * ignored.
-				 */
-				reqnfs->svc.rq_u1 = DUPREQ_NOCACHE_NORES;
-				LogDebug(COMPONENT_DUPREQ,
-					 "dupreq hit dv=%p, dv xid=%" PRIu32
-					 " cksum %" PRIu64
-					 " state=%s dupe_count=%d",
-					 dv, dv->hin.tcp.rq_xid, dv->hk,
-					 dupreq_state_table[dv->complete],
-					 dv->dupe_cnt);
-				PTHREAD_MUTEX_unlock(&dv->dre_mtx);
-				PTHREAD_MUTEX_unlock(&t->mtx);
-				return DUPREQ_DROP;
-			} else {
-				status = DUPREQ_EXISTS;
-			}
+	if (dv) {
+		/* cached request */
+		nfs_dupreq_free_dupreq(dk);
+		PTHREAD_MUTEX_lock(&dv->dre_mtx);
 
-			/* satisfy req from the DRC, incref, extend window */
-			reqnfs->svc.rq_u1 = dv;
-			reqnfs->res_nfs = reqnfs->svc.rq_u2 = dv->res;
-			dupreq_entry_get(dv);
+		/* Count the number of duplicate requests received. */
+		dv->dupe_cnt++;
 
+		/* Check if the original request is complete or not. If
+		 * not, we queue up the duplicate request for potential
+		 * response later, however, do not queue more than
+		 * DUPREQ_MAX_DUPES duplicates, any beyond before the
+		 * request is completed will just be dropped.
+		 */
+		if (unlikely(!dv->complete)
+		    && dv->dupe_cnt <= DUPREQ_MAX_DUPES) {
+			status = DUPREQ_BEING_PROCESSED;
+			TAILQ_INSERT_TAIL(&dv->dupes, reqnfs, dupes);
+			reqnfs->svc.rq_resume_cb = drc_resume;
+		} else if (unlikely(!dv->complete)) {
+			/* Signal to nfs_dupreq_rele this should be
+			 * ignored.
+			 */
+			reqnfs->svc.rq_u1 = DUPREQ_NOCACHE_NORES;
 			LogDebug(COMPONENT_DUPREQ,
 				 "dupreq hit dv=%p, dv xid=%" PRIu32
-				 " cksum %" PRIu64 " state=%s dupe_count=%d",
+				 " cksum %" PRIu64
+				 " state=%s dupe_count=%d",
 				 dv, dv->hin.tcp.rq_xid, dv->hk,
 				 dupreq_state_table[dv->complete],
 				 dv->dupe_cnt);
-
 			PTHREAD_MUTEX_unlock(&dv->dre_mtx);
-
-			PTHREAD_MUTEX_lock(&drc->drc_mtx);
-			/* Extend window */
-			drc_inc_retwnd(drc);
-			PTHREAD_MUTEX_unlock(&drc->drc_mtx);
+			if (t)
+				PTHREAD_MUTEX_unlock(&t->mtx);
+			else
+				PTHREAD_MUTEX_unlock(&drc->drc_mtx);
+			return DUPREQ_DROP;
 		} else {
-			/* new request */
-			reqnfs->svc.rq_u1 = dk;
-			dk->res = alloc_nfs_res();
-			reqnfs->res_nfs = reqnfs->svc.rq_u2 = dk->res;
+			status = DUPREQ_EXISTS;
+		}
 
-			/* cache--can exceed drc->maxsize */
-			(void)rbtree_x_cached_insert(&drc->xt, t,
-						&dk->rbt_k, dk->hk);
+		/* satisfy req from the DRC, incref, extend window */
+		reqnfs->svc.rq_u1 = dv;
+		reqnfs->res_nfs = reqnfs->svc.rq_u2 = dv->res;
+		dupreq_entry_get(dv);
 
-			/* dupreq ref count starts with 2; one for the caller
-			 * and another for staying in the hash table.
-			 */
-			dk->refcnt = 2;
+		LogDebug(COMPONENT_DUPREQ,
+			 "dupreq hit dv=%p, dv xid=%" PRIu32
+			 " cksum %" PRIu64 " state=%s dupe_count=%d",
+			 dv, dv->hin.tcp.rq_xid, dv->hk,
+			 dupreq_state_table[dv->complete],
+			 dv->dupe_cnt);
+
+		PTHREAD_MUTEX_unlock(&dv->dre_mtx);
 
-			/* add to q tail */
+		if (t)
 			PTHREAD_MUTEX_lock(&drc->drc_mtx);
-			TAILQ_INSERT_TAIL(&drc->dupreq_q, dk, fifo_q);
-			++(drc->size);
-			PTHREAD_MUTEX_unlock(&drc->drc_mtx);
+		/* Extend window */
+		drc_inc_retwnd(drc);
+		PTHREAD_MUTEX_unlock(&drc->drc_mtx);
+	} else {
+		/* new request */
+		reqnfs->svc.rq_u1 = dk;
+		dk->res = alloc_nfs_res();
+		reqnfs->res_nfs = reqnfs->svc.rq_u2 = dk->res;
+		(void)atomic_add_uint64_t(&drc_st->bytes, DUPREQ_ENTRY_BYTES);
+
+		/* dupreq ref count starts with 2; one for the caller
+		 * and another for staying in the hash table.
+		 */
+		dk->refcnt = 2;
 
-			LogFullDebug(COMPONENT_DUPREQ,
-				     "starting dk=%p xid=%" PRIu32
-				     " on DRC=%p state=%s, status=%s, refcnt=%d, drc->size=%d",
-				     dk, dk->hin.tcp.rq_xid, drc,
-				     dupreq_state_table[dk->complete],
-				     dupreq_status_table[status],
-				     dk->refcnt, drc->size);
+		/* cache--can exceed drc->maxsize */
+		if (t) {
+			(void)rbtree_x_cached_insert(&drc->xt, t,
+						     &dk->rbt_k, dk->hk);
+			PTHREAD_MUTEX_lock(&drc->drc_mtx);
+		} else {
+			drc_ring_insert(drc, dk);
 		}
-		PTHREAD_MUTEX_unlock(&t->mtx);
+
+		/* add to q tail */
+		TAILQ_INSERT_TAIL(&drc->dupreq_q, dk, fifo_q);
+		++(drc->size);
+
+		LogFullDebug(COMPONENT_DUPREQ,
+			     "starting dk=%p xid=%" PRIu32
+			     " on DRC=%p state=%s, status=%s, refcnt=%d, drc->size=%d",
+			     dk, dk->hin.tcp.rq_xid, drc,
+			     dupreq_state_table[dk->complete],
+			     dupreq_status_table[status],
+			     dk->refcnt, drc->size);
+
+		PTHREAD_MUTEX_unlock(&drc->drc_mtx);
 	}
 
+	if (t)
+		PTHREAD_MUTEX_unlock(&t->mtx);
+
 	return status;
 
 no_cache:
@@ -1268,66 +1333,83 @@ void nfs_dupreq_finish(nfs_request_t *reqnfs, enum nfs_req_result rc)
 
 	/* conditionally retire entries */
 dq_again:
-	if (drc_should_retire(drc)) {
-		ov = TAILQ_FIRST(&drc->dupreq_q);
-		if (likely(ov)) {
-			/* remove dict entry */
-			t = rbtx_partition_of_scalar(&drc->xt, ov->hk);
-			uint64_t ov_hk = ov->hk;
-
-			/* Need to acquire partition lock, but the lock
-			 * order is partition lock followed by drc lock.
-			 * Drop drc lock and reacquire it!
-			 */
-			PTHREAD_MUTEX_unlock(&drc->drc_mtx);
-			PTHREAD_MUTEX_lock(&t->mtx);	/* partition lock */
-			PTHREAD_MUTEX_lock(&drc->drc_mtx);
+	if (!drc_should_retire(drc))
+		goto unlock;
 
-			/* Since we dropped drc lock and reacquired it,
-			 * the drc dupreq list may have changed. Get the
-			 * dupreq entry from the list again.
-			 */
-			ov = TAILQ_FIRST(&drc->dupreq_q);
+	ov = TAILQ_FIRST(&drc->dupreq_q);
+	if (unlikely(!ov))
+		goto unlock;
 
-			/* Make sure that we are removing the entry we
-			 * expected (imperfect, but harmless).
-			 */
-			if (ov == NULL || ov->hk != ov_hk) {
-				PTHREAD_MUTEX_unlock(&t->mtx);
-				goto unlock;
-			}
+	if (drc->type != DRC_UDP_V234) {
+		/* per-connection, all under drc lock */
+		TAILQ_REMOVE(&drc->dupreq_q, ov, fifo_q);
+		TAILQ_INIT_ENTRY(ov, fifo_q);
+		--(drc->size);
+		drc_ring_remove(drc, ov);
+		PTHREAD_MUTEX_unlock(&drc->drc_mtx);
+	} else {
+		/* remove dict entry */
+		t = rbtx_partition_of_scalar(&drc->xt, ov->hk);
+		uint64_t ov_hk = ov->hk;
 
-			/* remove q entry */
-			TAILQ_REMOVE(&drc->dupreq_q, ov, fifo_q);
-			TAILQ_INIT_ENTRY(ov, fifo_q);
-			--(drc->size);
-			PTHREAD_MUTEX_unlock(&drc->drc_mtx);
+		/* Need to acquire partition lock, but the lock
+		 * order is partition lock followed by drc lock.
+		 * Drop drc lock and reacquire it!
+		 */
+		PTHREAD_MUTEX_unlock(&drc->drc_mtx);
+		PTHREAD_MUTEX_lock(&t->mtx);	/* partition lock */
+		PTHREAD_MUTEX_lock(&drc->drc_mtx);
 
-			rbtree_x_cached_remove(&drc->xt, t, &ov->rbt_k, ov->hk);
+		/* Since we dropped drc lock and reacquired it,
+		 * the drc dupreq list may have changed. Get the
+		 * dupreq entry from the list again.
+		 */
+		ov = TAILQ_FIRST(&drc->dupreq_q);
 
+		/* Make sure that we are removing the entry we
+		 * expected (imperfect, but harmless).
+		 */
+		if (ov == NULL || ov->hk != ov_hk) {
 			PTHREAD_MUTEX_unlock(&t->mtx);
-
-			LogDebug(COMPONENT_DUPREQ,
-				 "retiring ov=%p xid=%" PRIu32
-				 " on DRC=%p state=%s, refcnt=%d",
-				 ov, ov->hin.tcp.rq_xid,
-				 drc, dupreq_state_table[ov->complete],
-				 ov->refcnt);
-
-			/* release hashtable ref count */
-			dupreq_entry_put(ov);
-
-			/* conditionally retire another */
-			if (cnt++ < DUPREQ_MAX_RETRIES) {
-				PTHREAD_MUTEX_lock(&drc->drc_mtx);
-				goto dq_again; /* calls drc_should_retire() */
-			}
-			return;
+			goto unlock;
 		}
+
+		/* remove q entry */
+		TAILQ_REMOVE(&drc->dupreq_q, ov, fifo_q);
+		TAILQ_INIT_ENTRY(ov, fifo_q);
+		--(drc->size);
+		PTHREAD_MUTEX_unlock(&drc->drc_mtx);
+
+		rbtree_x_cached_remove(&drc->xt, t, &ov->rbt_k, ov->hk);
+
+		PTHREAD_MUTEX_unlock(&t->mtx);
 	}
 
+	LogDebug(COMPONENT_DUPREQ,
+		 "retiring ov=%p xid=%" PRIu32
+		 " on DRC=%p state=%s, refcnt=%d",
+		 ov, ov->hin.tcp.rq_xid,
+		 drc, dupreq_state_table[ov->complete],
+		 ov->refcnt);
+
+	/* release hashtable ref count */
+	dupreq_entry_put(ov);
+
+	/* conditionally retire another */
+	if (cnt++ < DUPREQ_MAX_RETRIES) {
+		PTHREAD_MUTEX_lock(&drc->drc_mtx);
+		goto dq_again; /* calls drc_should_retire() */
+	}
+	goto reclaim;
+
  unlock:
 	PTHREAD_MUTEX_unlock(&drc->drc_mtx);
+
+ reclaim:
+	/* over budget, drcs of gone clients go first */
+	if (unlikely(drc_over_budget())
+	    && atomic_fetch_int32_t(&drc_st->tcp_drc_recycle_qlen) > 0)
+		drc_free_expired();
 }
 
 /**
@@ -1406,13 +1488,19 @@ void nfs_dupreq_delete(nfs_request_t *reqnfs, enum nfs_req_result rc)
 	TAILQ_REMOVE(&drc->dupreq_q, dv, fifo_q);
 	TAILQ_INIT_ENTRY(dv, fifo_q);
 	--(drc->size);
-	PTHREAD_MUTEX_unlock(&drc->drc_mtx);
 
-	t = rbtx_partition_of_scalar(&drc->xt, dv->hk);
+	if (drc->type != DRC_UDP_V234) {
+		drc_ring_remove(drc, dv);
+		PTHREAD_MUTEX_unlock(&drc->drc_mtx);
+	} else {
+		PTHREAD_MUTEX_unlock(&drc->drc_mtx);
+
+		t = rbtx_partition_of_scalar(&drc->xt, dv->hk);
 
-	PTHREAD_MUTEX_lock(&t->mtx);
-	rbtree_x_cached_remove(&drc->xt, t, &dv->rbt_k, dv->hk);
-	PTHREAD_MUTEX_unlock(&t->mtx);
+		PTHREAD_MUTEX_lock(&t->mtx);
+		rbtree_x_cached_remove(&drc->xt, t, &dv->rbt_k, dv->hk);
+		PTHREAD_MUTEX_unlock(&t->mtx);
+	}
 
 	/* we removed the dupreq from hashtable, release a ref */
 	dupreq_entry_put(dv);
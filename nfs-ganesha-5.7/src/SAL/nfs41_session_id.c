@@ -289,16 +289,16 @@ int32_t _dec_session_ref(nfs41_session_t *session, const char *func, int line)
 
 		/* Decrement our reference to the clientid record */
 		dec_client_id_ref(session->clientid_record);
-		/* Destroy this session's mutexes and condition variable */
 
+		/* Drop any replies still cached in the slots */
 		for (i = 0; i < session->nb_slots; i++) {
 			nfs41_session_slot_t *slot;
 
 			slot = &session->fc_slots[i];
-			PTHREAD_MUTEX_destroy(&slot->slot_lock);
 			release_slot(slot);
 		}
 
+		/* Destroy this session's mutexes and condition variable */
 		PTHREAD_RWLOCK_destroy(&session->conn_lock);
 		PTHREAD_COND_destroy(&session->cb_cond);
 		PTHREAD_MUTEX_destroy(&session->cb_mutex);
@@ -466,6 +466,16 @@ bool check_session_conn(nfs41_session_t *session,
 	/* Copy the address coming over the wire. */
 	copy_xprt_addr(&addr, data->req->rq_xprt);
 
+	/* Connections are only ever appended, and num_conn is raised after
+	 * the address is in place, so the usual case, a connection that is
+	 * already bound, is found without the lock.
+	 */
+	num = atomic_fetch_int32_t(&session->num_conn);
+	for (i = 0; i < num; i++) {
+		if (cmp_sockaddr(&addr, &session->connections[i], false))
+			return true;
+	}
+
 	PTHREAD_RWLOCK_rdlock(&session->conn_lock);
 
 retry:
@@ -524,7 +534,8 @@ retry:
 	}
 
 	/* Add the new connection. */
-	memcpy(&session->connections[session->num_conn++], &addr, sizeof(addr));
+	memcpy(&session->connections[session->num_conn], &addr, sizeof(addr));
+	atomic_inc_int32_t(&session->num_conn);
 
 	PTHREAD_RWLOCK_unlock(&session->conn_lock);
 
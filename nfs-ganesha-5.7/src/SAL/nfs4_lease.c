@@ -55,7 +55,7 @@ static unsigned int _valid_lease(nfs_client_id_t *clientid)
 	if (clientid->cid_confirmed == EXPIRED_CLIENT_ID)
 		return 0;
 
-	if (clientid->cid_lease_reservations != 0)
+	if (atomic_fetch_int32_t(&clientid->cid_lease_reservations) != 0)
 		return nfs_param.nfsv4_param.lease_lifetime;
 
 	t = time(NULL);
@@ -114,7 +114,7 @@ int reserve_lease(nfs_client_id_t *clientid)
 	valid = _valid_lease(clientid);
 
 	if (valid != 0)
-		clientid->cid_lease_reservations++;
+		atomic_inc_int32_t(&clientid->cid_lease_reservations);
 
 	if (isFullDebug(COMPONENT_CLIENTID)) {
 		char str[LOG_BUFF_LEN] = "\0";
@@ -129,6 +129,23 @@ int reserve_lease(nfs_client_id_t *clientid)
 	return valid != 0;
 }
 
+/**
+ * @brief Take another lease reservation without cid_mutex.
+ *
+ * This only succeeds while some reservation is already held, when the lease
+ * can not expire.  Taking the first one checks the lease and must be done
+ * with reserve_lease_or_expire() instead.
+ *
+ * @param[in] clientid Client record to reserve the lease of
+ *
+ * @return true if a reservation was taken.
+ */
+bool reserve_lease_fast(nfs_client_id_t *clientid)
+{
+	return atomic_inc_unless_0_int32_t(
+			&clientid->cid_lease_reservations) != 0;
+}
+
 /**
  * @brief Check if lease is valid and reserve it or expire it.
  *
@@ -152,7 +169,7 @@ bool reserve_lease_or_expire(nfs_client_id_t *clientid, bool update)
 	valid = _valid_lease(clientid);
 
 	if (valid != 0)
-		clientid->cid_lease_reservations++;
+		atomic_inc_int32_t(&clientid->cid_lease_reservations);
 
 	if (isFullDebug(COMPONENT_CLIENTID)) {
 		char str[LOG_BUFF_LEN] = "\0";
@@ -221,10 +238,8 @@ bool reserve_lease_or_expire(nfs_client_id_t *clientid, bool update)
  */
 void update_lease(nfs_client_id_t *clientid)
 {
-	clientid->cid_lease_reservations--;
-
 	/* Renew lease when last reservation is released */
-	if (clientid->cid_lease_reservations == 0)
+	if (atomic_dec_int32_t(&clientid->cid_lease_reservations) == 0)
 		clientid->cid_last_renew = time(NULL);
 
 	if (isFullDebug(COMPONENT_CLIENTID)) {
@@ -236,4 +251,20 @@ void update_lease(nfs_client_id_t *clientid)
 	}
 }
 
+/**
+ * @brief Release a lease reservation without cid_mutex.
+ *
+ * Only a reservation that is not the last one can be released this way,
+ * the last one renews the lease and must go through update_lease().
+ *
+ * @param[in] clientid The clientid record to update
+ *
+ * @return true if the reservation was released.
+ */
+bool update_lease_fast(nfs_client_id_t *clientid)
+{
+	return atomic_add_unless_int32_t(&clientid->cid_lease_reservations,
+					 -1, 1);
+}
+
 /** @} */
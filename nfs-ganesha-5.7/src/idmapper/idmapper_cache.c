@@ -143,6 +143,26 @@ static struct avltree gname_tree;
 
 static struct avltree gid_tree;
 
+/**
+ * @brief Bumped whenever a mapping is added, replaced or dropped
+ *
+ * Lets callers that keep encoded owner names of their own (the GETATTR
+ * encoding cache) tell that a name may have changed.
+ */
+
+static uint64_t idmapper_gen;
+
+/**
+ * @brief Get the current mapping generation
+ *
+ * @return The generation, which changes whenever any mapping might have.
+ */
+
+uint64_t idmapper_generation(void)
+{
+	return atomic_fetch_uint64_t(&idmapper_gen);
+}
+
 /**
  * @brief Compare two buffers
  *
@@ -321,6 +341,8 @@ bool idmapper_add_user(const struct gsh_buffdesc *name, uid_t uid,
 	struct cache_user *old;
 	struct cache_user *new;
 
+	atomic_inc_uint64_t(&idmapper_gen);
+
 	new = gsh_malloc(sizeof(struct cache_user) + name->len);
 	new->epoch = time(NULL);
 	new->uname.addr = (char *)new + sizeof(struct cache_user);
@@ -427,6 +449,8 @@ bool idmapper_add_group(const struct gsh_buffdesc *name, const gid_t gid)
 	struct cache_group *tmp;
 	struct cache_group *new;
 
+	atomic_inc_uint64_t(&idmapper_gen);
+
 	new = gsh_malloc(sizeof(struct cache_group) + name->len);
 	new->epoch = time(NULL);
 	new->gname.addr = (char *)new + sizeof(struct cache_group);
@@ -694,6 +718,8 @@ void idmapper_clear_cache(void)
 	PTHREAD_RWLOCK_wrlock(&idmapper_user_lock);
 	PTHREAD_RWLOCK_wrlock(&idmapper_group_lock);
 
+	atomic_inc_uint64_t(&idmapper_gen);
+
 	memset(uid_cache, 0, id_cache_size * sizeof(struct avltree_node *));
 	memset(gid_cache, 0, id_cache_size * sizeof(struct avltree_node *));
 
@@ -81,6 +81,8 @@
 #cmakedefine HAVE_STRNLEN 1
 #cmakedefine LITTLEEND 1
 #cmakedefine HAVE_DAEMON 1
+#cmakedefine HAVE_COPY_FILE_RANGE 1
+#cmakedefine HAVE_FICLONERANGE 1
 #cmakedefine USE_LTTNG 1
 #cmakedefine HAVE_ACL_GET_FD_NP 1
 #cmakedefine HAVE_ACL_SET_FD_NP 1
@@ -124,6 +124,17 @@ enum export_status {
 	EXPORT_STALE,		/*< export is no longer valid */
 };
 
+/**
+ * @brief Worker priority class of the requests on an export
+ *
+ * Bulk requests are limited to RPC_Bulk_Worker_Share of the workers.
+ */
+enum export_req_class {
+	EXPORT_REQ_CLASS_AUTO,		/*< bulk for I/O, interactive otherwise */
+	EXPORT_REQ_CLASS_INTERACTIVE,	/*< never held back */
+	EXPORT_REQ_CLASS_BULK,		/*< everything is bulk */
+};
+
 /**
  * @brief Represents an export.
  *
@@ -194,6 +205,9 @@ struct gsh_export {
 	uint64_t MaxOffsetWrite;
 	/** CFG: Maximum Offset allowed for read - atomic changeable option */
 	uint64_t MaxOffsetRead;
+	/** CFG: Worker priority class of requests on this export, an
+	 *  enum export_req_class - atomic changeable option */
+	uint32_t req_class;
 	/** CFG: Filesystem ID for overriding fsid from FSAL - ????? */
 	fsal_fsid_t filesystem_id;
 	/** References to this export */
@@ -354,7 +354,7 @@ extern struct gsh_refstr *no_export;
  * rules), increment the minor version
  */
 
-#define FSAL_MINOR_VERSION 0
+#define FSAL_MINOR_VERSION 3
 
 /* Forward references for object methods */
 
@@ -1464,6 +1464,10 @@ const char *fsal_dir_result_str(enum fsal_dir_result result);
  * parameter (which may be NULL if the caller doesn't need to mark cookies).
  * If ret_cookie is 0, the caller had no cookie to return.
  *
+ * If ATTR_DIRENT_ONLY was set in the readdir attrmask, obj may be NULL for
+ * entries other than directories. In that case only ATTRS_DIRENT are valid
+ * in attrs and no reference has been taken on anything.
+ *
  * @param[in]      name         The name of the entry
  * @param[in]      obj          The fsal_obj_handle describing the entry
  * @param[in]      attrs        The requested attributes for the entry (see
@@ -1644,6 +1648,10 @@ struct fsal_obj_ops {
  * @param[in]  attrmask  Indicate which attributes the caller is interested in
  * @param[out] eof       true if the last entry was reached
  *
+ * ATTR_DIRENT_ONLY in @a attrmask is a hint that the caller only needs
+ * ATTRS_DIRENT, an FSAL that keeps those with its directory entries may then
+ * hand out entries without an object. FSALs that don't MUST ignore it.
+ *
  * @return FSAL status.
  */
 	 fsal_status_t (*readdir)(struct fsal_obj_handle *dir_hdl,
@@ -2741,6 +2749,95 @@ struct fsal_obj_ops {
 			     struct fsal_attrlist *attrs,
 			     bool cache_attrs);
 
+/**
+ * @brief Look up a cached wire encoding of the attributes
+ *
+ * A protocol layer may leave the encoding of attributes it produced with
+ * the object, so that a later request with an identical key can skip the
+ * encoding.  The key is opaque to the FSAL and must capture everything the
+ * encoding depends on, attribute values included, so that a hit can never
+ * be stale.
+ *
+ * @param[in]  obj_hdl	Handle on which to operate
+ * @param[in]  key	Caller defined key
+ * @param[out] val	Copy of the encoding, allocated with gsh_malloc
+ *
+ * @return true if an encoding was found, false otherwise
+ */
+
+	 bool (*encoded_attrs_get)(struct fsal_obj_handle *obj_hdl,
+				   const struct gsh_buffdesc *key,
+				   struct gsh_buffdesc *val);
+
+/**
+ * @brief Offer a wire encoding of the attributes for caching
+ *
+ * The FSAL may keep it or not.
+ *
+ * @param[in] obj_hdl	Handle on which to operate
+ * @param[in] key	Caller defined key
+ * @param[in] val	The encoding
+ */
+
+	 void (*encoded_attrs_put)(struct fsal_obj_handle *obj_hdl,
+				   const struct gsh_buffdesc *key,
+				   const struct gsh_buffdesc *val);
+
+/**
+ * @brief Copy a range of bytes between two files
+ *
+ * Both files are in the same export.  The FSAL may copy less than asked
+ * for; fewer bytes than @a count and no error means the end of the source
+ * was reached.  The data need not be stable when this returns.  The
+ * default implementation copies through read2 and write2.
+ *
+ * @param[in]  src_hdl     File to copy from
+ * @param[in]  src_state   state_t to use to read the source (or NULL)
+ * @param[in]  src_offset  Offset in the source
+ * @param[in]  dst_hdl     File to copy to
+ * @param[in]  dst_state   state_t to use to write the destination (or NULL)
+ * @param[in]  dst_offset  Offset in the destination
+ * @param[in]  count       Number of bytes to copy
+ * @param[out] copied      Number of bytes copied
+ *
+ * @return FSAL status.
+ */
+
+	 fsal_status_t (*copy)(struct fsal_obj_handle *src_hdl,
+			       struct state_t *src_state,
+			       uint64_t src_offset,
+			       struct fsal_obj_handle *dst_hdl,
+			       struct state_t *dst_state,
+			       uint64_t dst_offset,
+			       uint64_t count,
+			       uint64_t *copied);
+
+/**
+ * @brief Clone a range of bytes between two files
+ *
+ * Like copy, but the destination shares the storage of the source rather
+ * than getting a copy of the data, so it is all or nothing.  FSALs that
+ * can't share storage return ERR_FSAL_NOTSUPP, which is the default.
+ *
+ * @param[in] src_hdl     File to clone from
+ * @param[in] src_state   state_t to use to read the source (or NULL)
+ * @param[in] src_offset  Offset in the source
+ * @param[in] dst_hdl     File to clone to
+ * @param[in] dst_state   state_t to use to write the destination (or NULL)
+ * @param[in] dst_offset  Offset in the destination
+ * @param[in] count       Number of bytes to clone
+ *
+ * @return FSAL status.
+ */
+
+	 fsal_status_t (*clone)(struct fsal_obj_handle *src_hdl,
+				struct state_t *src_state,
+				uint64_t src_offset,
+				struct fsal_obj_handle *dst_hdl,
+				struct state_t *dst_state,
+				uint64_t dst_offset,
+				uint64_t count);
+
 /**@{*/
 
 /**
@@ -413,6 +413,11 @@ typedef uint64_t attrmask_t;
 #define ATTR_SPACEUSED 0x0000000000010000LL
 /* This bit indicates that an error occurred during getting object attributes */
 #define ATTR_RDATTR_ERR 0x8000000000000000LL
+/* Readdir only: the caller accepts entries served from directory entry
+ * metadata alone, without an object, see fsal_readdir_cb */
+#define ATTR_DIRENT_ONLY 0x4000000000000000LL
+/* Attributes that may be served for an entry without an object */
+#define ATTRS_DIRENT (ATTR_TYPE | ATTR_FILEID)
 /* Generation number */
 #define ATTR_GENERATION 0x0000000000080000LL
 /* Change attribute */
@@ -283,6 +283,23 @@ struct fsal_up_vector {
 	 */
 	fsal_status_t (*try_release)(const struct fsal_up_vector *vec,
 				     struct gsh_buffdesc *obj, uint32_t flags);
+
+	/** Grant or revoke an attribute lease on a cached object
+	 *
+	 * By granting a lease the FSAL promises to report every change to
+	 * the object through invalidate or update.  While the lease is
+	 * held, the cache trusts its attributes without expiring them; an
+	 * invalidate forces one refresh but leaves the lease in place.
+	 *
+	 * @param[in] vec	Up ops vector
+	 * @param[in] obj	The object
+	 * @param[in] grant	true to grant the lease, false to revoke it
+	 *
+	 * @return FSAL status. ERR_FSAL_NOENT if the object is not cached,
+	 *	   in which case no lease was recorded.
+	 */
+	fsal_status_t (*attr_lease)(const struct fsal_up_vector *vec,
+				    struct gsh_buffdesc *obj, bool grant);
 };
 
 extern struct fsal_up_vector fsal_up_top;
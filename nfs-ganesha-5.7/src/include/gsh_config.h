@@ -105,9 +105,9 @@ typedef enum protos {
 #define DRC_RECYCLE_HIWAT 1024
 
 /**
- * @brief Default value for core_param.drc.tcp.npart
+ * @brief Default value for core_param.drc.max_memory
  */
-#define DRC_TCP_NPART 1
+#define DRC_MAX_MEMORY (64 * 1024 * 1024)
 
 /**
  * @brief Default value for core_param.drc.tcp.size
@@ -174,6 +174,11 @@ typedef enum protos {
  */
 #define NFS_DEFAULT_RECV_BUFFER_SIZE 1048576
 
+/**
+ * Upper bound for core_param.rpc.listen_shards
+ */
+#define RPC_LISTEN_SHARDS_MAX 64
+
 /**
  * @brief Default Monitoring Port.
  */
@@ -268,12 +273,13 @@ typedef struct nfs_core_param {
 		bool disabled;
 		/** High water mark for len of recycle queue for DRCs */
 		uint32_t recycle_hiwat;
+		/** Bytes that cached requests of all DRCs may hold
+		    before they are retired regardless of their
+		    per-DRC water marks, 0 for no limit.  Defaults to
+		    DRC_MAX_MEMORY and settable by DRC_Max_Memory. */
+		uint64_t max_memory;
 		/* Parameters controlling TCP specific DRC behavior. */
 		struct {
-			/** Number of partitions in the tree for the
-			    TCP DRC.  Defaults to DRC_TCP_NPART,
-			    settable by DRC_TCP_Npart. */
-			uint32_t npart;
 			/** Maximum number of requests in a transport's
 			    DRC.  Defaults to DRC_TCP_SIZE and
 			    settable by DRC_TCP_Size. */
@@ -340,6 +346,11 @@ typedef struct nfs_core_param {
 		    Defaults to 1024 and settable by
 		    RPC_Max_Connections. */
 		uint32_t max_connections;
+		/** Maximum number of requests in progress on one
+		    connection before TIRPC stops reading from it.
+		    Defaults to 512 and settable by
+		    RPC_Max_Requests_Per_Connection, 0 for no limit. */
+		uint32_t max_conn_requests;
 		/** Size of RPC send buffer.  Defaults to
 		    NFS_DEFAULT_SEND_BUFFER_SIZE and is settable by
 		    MaxRPCSendBufferSize.  */
@@ -356,6 +367,26 @@ typedef struct nfs_core_param {
 		/** TIRPC ioq max simultaneous io threads.  Defaults to
 		    200 and settable by RPC_Ioq_ThrdMax. */
 		uint32_t ioq_thrd_max;
+		/** Percentage of ioq_thrd_max that bulk I/O requests may
+		    occupy at once, the rest is kept for interactive
+		    requests.  Defaults to 100 (no limit) and settable by
+		    RPC_Bulk_Worker_Share. */
+		uint32_t bulk_worker_share;
+		/** Use io_uring rather than epoll for the TIRPC event
+		    channels, if TIRPC was built with it.  Defaults to
+		    false and settable by RPC_IO_Uring. */
+		bool io_uring;
+		/** Number of SO_REUSEPORT TCP listeners per protocol, each
+		    on its own event channel.  Defaults to 1 and settable
+		    by RPC_Listen_Shards. */
+		uint32_t listen_shards;
+		/** RPC-with-TLS certificate chain, private key and
+		    optional CA for client certificates (PEM).  TLS is
+		    offered when the first two are set.  Settable by
+		    RPC_TLS_Certificate, RPC_TLS_Key and RPC_TLS_CA. */
+		char *tls_cert_file;
+		char *tls_key_file;
+		char *tls_ca_file;
 		struct {
 			/** Partitions in GSS ctx cache table (default 13). */
 			uint32_t ctx_hash_partitions;
@@ -599,6 +630,10 @@ typedef struct nfs_version4_parameter {
 	bool enforce_utf8_vld;
 	/** Max number of Client IDs allowed on the system */
 	uint32_t max_client_ids;
+	/** Number of READs following a READ of the same file in a
+	    COMPOUND to start along with it.  Defaults to 0 (off) and
+	    settable with Compound_Parallel_Reads. */
+	uint32_t compound_parallel_reads;
 } nfs_version4_parameter_t;
 
 /** @} */
@@ -68,6 +68,7 @@ bool idmapper_lookup_by_uid(const uid_t, const struct gsh_buffdesc **,
 			    const gid_t **);
 bool idmapper_lookup_by_gname(const struct gsh_buffdesc *, uid_t *);
 bool idmapper_lookup_by_gid(const gid_t, const struct gsh_buffdesc **);
+uint64_t idmapper_generation(void);
 /** @} */
 
 bool idmapper_init(void);
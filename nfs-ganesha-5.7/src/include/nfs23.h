@@ -493,6 +493,7 @@ struct WRITE3args {
 		u_int data_len;
 		char *data_val;
 	} data;
+	bool data_inplace;	/* data_val is in the receive buffer */
 };
 typedef struct WRITE3args WRITE3args;
 
@@ -52,7 +52,7 @@ enum drc_type {
 
 typedef struct drc {
 	enum drc_type type;
-	struct rbtree_x xt;
+	struct rbtree_x xt;	/* shared (UDP) DRC */
 	/* Define the tail queue */
 	TAILQ_HEAD(drc_tailq, dupreq_entry) dupreq_q;
 	pthread_mutex_t drc_mtx;
@@ -72,6 +72,12 @@ typedef struct drc {
 			TAILQ_ENTRY(drc) recycle_q; /* XXX drc */
 			time_t recycle_time;
 			uint64_t hk; /* hash key */
+
+			/* Requests of this connection, chained by
+			 * xid & ring_mask, under drc_mtx.
+			 */
+			struct dupreq_entry **ring;
+			uint32_t ring_mask;
 		} tcp;
 	} d_u;
 } drc_t;
@@ -111,6 +117,7 @@ typedef struct drc {
 
 struct dupreq_entry {
 	struct opr_rbtree_node rbt_k;
+	struct dupreq_entry *ring_next;	/* per-connection xid chain */
 	/* Define the tail queue */
 	TAILQ_ENTRY(dupreq_entry) fifo_q;
 	/* Queued duplicate requests waiting for request completion. Limited
@@ -109,6 +109,8 @@ typedef union nfs_arg__ {
 struct COMPOUND4res_extended {
 	COMPOUND4res res_compound4;
 	int32_t res_refcnt;
+	/** resarray came from the result arena pool */
+	bool res_arena;
 };
 
 typedef union nfs_res__ {
@@ -231,6 +233,10 @@ typedef struct nfs_request {
 	 *  this is a dupreq of.
 	 */
 	TAILQ_ENTRY(nfs_request) dupes;
+	/** This request holds one of the bulk worker slots */
+	bool bulk;
+	/** Queued here while waiting for a bulk worker slot */
+	TAILQ_ENTRY(nfs_request) bulk_q;
 } nfs_request_t;
 
 enum rpc_chan_type {
@@ -366,6 +372,7 @@ struct compound_data {
 	const char *opname;	/*< Name of the operation */
 	char *tagname;
 	void *op_data;		/*< operation specific data for resume */
+	void *read_ahead;	/*< READs started ahead of their turn */
 	nfs41_session_t *session;	/*< Related session
 					   (found by OP_SEQUENCE) */
 	sequenceid4 sequence;	/*< Sequence ID of the current compound
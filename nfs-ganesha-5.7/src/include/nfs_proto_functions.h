@@ -51,6 +51,9 @@ void nfs_rpc_complete_async_request(nfs_request_t *reqdata,
 
 enum xprt_stat drc_resume(struct svc_req *req);
 
+void nfs_rpc_bulk_pkginit(void);
+void nfs_rpc_bulk_release(nfs_request_t *reqdata);
+
 #ifdef _USE_NFS3
 extern const nfs_function_desc_t nfs3_func_desc[];
 #endif
@@ -213,6 +216,8 @@ enum nfs_req_result nfs4_op_read_plus_resume(struct nfs_argop4 *op,
 					     compound_data_t *data,
 					     struct nfs_resop4 *resp);
 
+void nfs4_read_ahead_release(compound_data_t *data);
+
 enum nfs_req_result nfs4_op_access(struct nfs_argop4 *, compound_data_t *,
 				   struct nfs_resop4 *);
 
@@ -411,6 +416,31 @@ enum nfs_req_result nfs4_op_deallocate(struct nfs_argop4 *, compound_data_t *,
 
 void nfs4_op_deallocate_Free(nfs_resop4 *resp);
 
+enum nfs_req_result nfs4_op_copy(struct nfs_argop4 *, compound_data_t *,
+				 struct nfs_resop4 *);
+
+void nfs4_op_copy_Free(nfs_resop4 *resp);
+
+enum nfs_req_result nfs4_op_clone(struct nfs_argop4 *, compound_data_t *,
+				  struct nfs_resop4 *);
+
+void nfs4_op_clone_Free(nfs_resop4 *resp);
+
+enum nfs_req_result nfs4_op_offload_status(struct nfs_argop4 *,
+					   compound_data_t *,
+					   struct nfs_resop4 *);
+
+void nfs4_op_offload_status_Free(nfs_resop4 *resp);
+
+enum nfs_req_result nfs4_op_offload_cancel(struct nfs_argop4 *,
+					   compound_data_t *,
+					   struct nfs_resop4 *);
+
+void nfs4_op_offload_cancel_Free(nfs_resop4 *resp);
+
+void nfs4_copy_pkginit(void);
+void nfs4_copy_pkgshutdown(void);
+
 enum nfs_req_result nfs4_op_seek(struct nfs_argop4 *, compound_data_t *,
 				 struct nfs_resop4 *);
 
@@ -522,6 +552,7 @@ void nfs3_commit_free(nfs_res_t *);
 void nfs3_read_free(nfs_res_t *);
 #endif
 
+void nfs4_compound_pkginit(void);
 void nfs4_Compound_FreeOne(nfs_resop4 *);
 void release_nfs4_res_compound(struct COMPOUND4res_extended *res_compound4_ex);
 void nfs4_Compound_Free(nfs_res_t *);
@@ -1979,6 +1979,7 @@ struct WRITE4args {
 		u_int data_len;
 		char *data_val;
 	} data;
+	bool data_inplace;	/* data_val is in the receive buffer */
 };
 typedef struct WRITE4args WRITE4args;
 
@@ -2618,6 +2619,16 @@ enum netloc_type4 {
 };
 typedef enum netloc_type4 netloc_type4;
 
+struct netloc4 {
+	netloc_type4        nl_type;
+	union {
+		utf8str_cis nl_name;
+		utf8str_cis nl_url;
+		netaddr4    nl_addr;
+	};
+};
+typedef struct netloc4 netloc4;
+
 enum data_content4 {
 	NFS4_CONTENT_DATA       = 0,
 	NFS4_CONTENT_HOLE       = 1,
@@ -2729,20 +2740,30 @@ struct COPY4args {
 	offset4         ca_src_offset;
 	offset4         ca_dst_offset;
 	length4         ca_count;
-	netloc_type4        ca_type;
-	union {
-		utf8str_cis ca_name;
-		utf8str_cis ca_url;
-		netaddr4    ca_addr;
-	};
+	bool_t          ca_consecutive;
+	bool_t          ca_synchronous;
+	struct {
+		u_int ca_source_server_len;
+		netloc4 *ca_source_server_val;
+	} ca_source_server;
 };
 typedef struct COPY4args COPY4args;
 
+typedef struct {
+	bool_t          cr_consecutive;
+	bool_t          cr_synchronous;
+} copy_requirements4;
+
+typedef struct {
+	write_response4 cr_response;
+	copy_requirements4 cr_requirements;
+} COPY4resok;
+
 struct COPY4res {
 	nfsstat4 cr_status;
 	union {
-		write_response4 cr_resok4;
-		length4         cr_bytes_copied;
+		COPY4resok cr_resok4;
+		copy_requirements4 cr_requirements;
 	} COPY4res_u;
 };
 typedef struct COPY4res COPY4res;
@@ -2753,7 +2774,7 @@ struct OFFLOAD_ABORT4args {
 typedef struct OFFLOAD_ABORT4args OFFLOAD_ABORT4args;
 
 struct OFFLOAD_ABORT4res {
-	stateid4        oar_stateid;
+	nfsstat4        oar_status;
 };
 typedef struct OFFLOAD_ABORT4res OFFLOAD_ABORT4res;
 
@@ -2824,6 +2845,20 @@ struct DEALLOCATE4res {
 };
 typedef struct DEALLOCATE4res DEALLOCATE4res;
 
+struct CLONE4args {
+	stateid4        cl_src_stateid;
+	stateid4        cl_dst_stateid;
+	offset4         cl_src_offset;
+	offset4         cl_dst_offset;
+	length4         cl_count;
+};
+typedef struct CLONE4args CLONE4args;
+
+struct CLONE4res {
+	nfsstat4 cl_status;
+};
+typedef struct CLONE4res CLONE4res;
+
 struct SEEK4args {
 	stateid4        sa_stateid;
 	offset4         sa_offset;
@@ -3303,6 +3338,7 @@ struct nfs_argop4 {
 		IO_ADVISE4args opio_advise;
 		LAYOUTERROR4args oplayouterror;
 		LAYOUTSTATS4args oplayoutstats;
+		CLONE4args opclone;
 
 		/* NFSv4.3 */
 		GETXATTR4args opgetxattr;
@@ -3388,6 +3424,7 @@ struct nfs_resop4 {
 		IO_ADVISE4res opio_advise;
 		LAYOUTERROR4res oplayouterror;
 		LAYOUTSTATS4res oplayoutstats;
+		CLONE4res opclone;
 
 		/* NFSv4.3 */
 		GETXATTR4res opgetxattr;
@@ -3734,6 +3771,28 @@ struct CB_NOTIFY_DEVICEID4res {
 };
 typedef struct CB_NOTIFY_DEVICEID4res CB_NOTIFY_DEVICEID4res;
 
+/* NFSv4.2 */
+struct offload_info4 {
+	nfsstat4 coa_status;
+	union {
+		write_response4 coa_resok4;
+		length4         coa_bytes_copied;
+	} offload_info4_u;
+};
+typedef struct offload_info4 offload_info4;
+
+struct CB_OFFLOAD4args {
+	nfs_fh4         coa_fh;
+	stateid4        coa_stateid;
+	offload_info4   coa_offload_info;
+};
+typedef struct CB_OFFLOAD4args CB_OFFLOAD4args;
+
+struct CB_OFFLOAD4res {
+	nfsstat4        cor_status;
+};
+typedef struct CB_OFFLOAD4res CB_OFFLOAD4res;
+
 /* Callback operations new to NFSv4.1 */
 
 enum nfs_cb_opnum4 {
@@ -3749,6 +3808,7 @@ enum nfs_cb_opnum4 {
 	NFS4_OP_CB_WANTS_CANCELLED = 12,
 	NFS4_OP_CB_NOTIFY_LOCK = 13,
 	NFS4_OP_CB_NOTIFY_DEVICEID = 14,
+	NFS4_OP_CB_OFFLOAD = 15,
 	NFS4_OP_CB_ILLEGAL = 10044,
 };
 typedef enum nfs_cb_opnum4 nfs_cb_opnum4;
@@ -3768,6 +3828,7 @@ struct nfs_cb_argop4 {
 		CB_WANTS_CANCELLED4args opcbwants_cancelled;
 		CB_NOTIFY_LOCK4args opcbnotify_lock;
 		CB_NOTIFY_DEVICEID4args opcbnotify_deviceid;
+		CB_OFFLOAD4args opcboffload;
 	} nfs_cb_argop4_u;
 };
 typedef struct nfs_cb_argop4 nfs_cb_argop4;
@@ -3787,6 +3848,7 @@ struct nfs_cb_resop4 {
 		CB_WANTS_CANCELLED4res opcbwants_cancelled;
 		CB_NOTIFY_LOCK4res opcbnotify_lock;
 		CB_NOTIFY_DEVICEID4res opcbnotify_deviceid;
+		CB_OFFLOAD4res opcboffload;
 		CB_ILLEGAL4res opcbillegal;
 	} nfs_cb_resop4_u;
 };
@@ -3875,9 +3937,32 @@ static inline bool xdr_bitmap4(XDR *xdrs, struct bitmap4 *objp)
  * to accept bitmaps bigger than BITMAP4_MAPLEN, but throw the rest away
  * so manually do the looping and skip the end
  */
+	if (xdrs->x_op == XDR_ENCODE && objp->bitmap4_len <= BITMAP4_MAPLEN) {
+		int32_t *buf = xdr_inline_encode(xdrs,
+				(1 + objp->bitmap4_len) * BYTES_PER_XDR_UNIT);
+
+		if (buf != NULL) {
+			IXDR_PUT_U_INT32(buf, objp->bitmap4_len);
+			for (i = 0; i < objp->bitmap4_len; i++)
+				IXDR_PUT_U_INT32(buf, map[i]);
+			return true;
+		}
+	}
 	if (!inline_xdr_u_int(xdrs, &objp->bitmap4_len))
 		return false;
 	mapsize = MIN(objp->bitmap4_len, BITMAP4_MAPLEN);
+	if (xdrs->x_op == XDR_DECODE) {
+		int32_t *buf = xdr_inline_decode(xdrs,
+				(size_t)objp->bitmap4_len * BYTES_PER_XDR_UNIT);
+
+		if (buf != NULL) {
+			for (i = 0; i < mapsize; i++)
+				map[i] = IXDR_GET_U_INT32(buf);
+			/* skip any further elements and lie on bitmap len */
+			objp->bitmap4_len = mapsize;
+			return true;
+		}
+	}
 	for (i = 0; i < mapsize; i++)
 		if (!inline_xdr_u_int32_t(xdrs, &map[i]))
 			return false;
@@ -4310,6 +4395,24 @@ static inline bool xdr_nfs_impl_id4(XDR *xdrs, nfs_impl_id4 *objp)
 
 static inline bool xdr_stateid4(XDR *xdrs, stateid4 *objp)
 {
+	int32_t *buf;
+
+	if (xdrs->x_op == XDR_ENCODE) {
+		buf = xdr_inline_encode(xdrs, 4 * BYTES_PER_XDR_UNIT);
+		if (buf != NULL) {
+			IXDR_PUT_U_INT32(buf, objp->seqid);
+			memcpy(buf, objp->other, 12);
+			return true;
+		}
+	} else if (xdrs->x_op == XDR_DECODE) {
+		buf = xdr_inline_decode(xdrs, 4 * BYTES_PER_XDR_UNIT);
+		if (buf != NULL) {
+			objp->seqid = IXDR_GET_U_INT32(buf);
+			memcpy(objp->other, buf, 12);
+			return true;
+		}
+	}
+
 	if (!inline_xdr_u_int32_t(xdrs, &objp->seqid))
 		return false;
 	if (!xdr_opaque(xdrs, objp->other, 12))
@@ -6875,9 +6978,10 @@ static inline bool xdr_WRITE4args(XDR *xdrs, WRITE4args *objp)
 		return false;
 	if (!xdr_stable_how4(xdrs, &objp->stable))
 		return false;
-	if (!inline_xdr_bytes(xdrs,
+	if (!xdr_bytes_inplace(xdrs,
 	    (char **)&objp->data.data_val,
-	    &objp->data.data_len, XDR_BYTES_MAXLEN_IO))
+	    &objp->data.data_len, XDR_BYTES_MAXLEN_IO,
+	    &objp->data_inplace))
 		return false;
 	return true;
 }
@@ -8061,6 +8165,134 @@ static inline bool xdr_WRITE_SAME4res(XDR *xdrs, WRITE_SAME4res *objp)
 	return true;
 }
 
+static inline bool xdr_netloc4(XDR *xdrs, netloc4 *objp)
+{
+	if (!inline_xdr_enum(xdrs, (enum_t *)&objp->nl_type))
+		return false;
+	switch (objp->nl_type) {
+	case NL4_NAME:
+		if (!xdr_utf8str_cis(xdrs, &objp->nl_name))
+			return false;
+		break;
+	case NL4_URL:
+		if (!xdr_utf8str_cis(xdrs, &objp->nl_url))
+			return false;
+		break;
+	case NL4_NETADDR:
+		if (!xdr_netaddr4(xdrs, &objp->nl_addr))
+			return false;
+		break;
+	default:
+		return false;
+	}
+	return true;
+}
+
+static inline bool xdr_COPY4args(XDR *xdrs, COPY4args *objp)
+{
+	if (!xdr_stateid4(xdrs, &objp->ca_src_stateid))
+		return false;
+	if (!xdr_stateid4(xdrs, &objp->ca_dst_stateid))
+		return false;
+	if (!xdr_offset4(xdrs, &objp->ca_src_offset))
+		return false;
+	if (!xdr_offset4(xdrs, &objp->ca_dst_offset))
+		return false;
+	if (!xdr_length4(xdrs, &objp->ca_count))
+		return false;
+	if (!inline_xdr_bool(xdrs, &objp->ca_consecutive))
+		return false;
+	if (!inline_xdr_bool(xdrs, &objp->ca_synchronous))
+		return false;
+	if (!xdr_array(xdrs,
+		       (char **)&objp->ca_source_server.ca_source_server_val,
+		       &objp->ca_source_server.ca_source_server_len,
+		       XDR_ARRAY_MAXLEN, sizeof(netloc4),
+		       (xdrproc_t) xdr_netloc4))
+		return false;
+	return true;
+}
+
+static inline bool xdr_copy_requirements4(XDR *xdrs, copy_requirements4 *objp)
+{
+	if (!inline_xdr_bool(xdrs, &objp->cr_consecutive))
+		return false;
+	if (!inline_xdr_bool(xdrs, &objp->cr_synchronous))
+		return false;
+	return true;
+}
+
+static inline bool xdr_COPY4res(XDR *xdrs, COPY4res *objp)
+{
+	if (!xdr_nfsstat4(xdrs, &objp->cr_status))
+		return false;
+	switch (objp->cr_status) {
+	case NFS4_OK:
+		if (!xdr_WRITE_SAME4resok(xdrs,
+				&objp->COPY4res_u.cr_resok4.cr_response))
+			return false;
+		if (!xdr_copy_requirements4(xdrs,
+				&objp->COPY4res_u.cr_resok4.cr_requirements))
+			return false;
+		break;
+	case NFS4ERR_OFFLOAD_NO_REQS:
+		if (!xdr_copy_requirements4(xdrs,
+				&objp->COPY4res_u.cr_requirements))
+			return false;
+		break;
+	default:
+		break;
+	}
+	return true;
+}
+
+static inline bool xdr_OFFLOAD_ABORT4args(XDR *xdrs, OFFLOAD_ABORT4args *objp)
+{
+	if (!xdr_stateid4(xdrs, &objp->oaa_stateid))
+		return false;
+	return true;
+}
+
+static inline bool xdr_OFFLOAD_ABORT4res(XDR *xdrs, OFFLOAD_ABORT4res *objp)
+{
+	if (!xdr_nfsstat4(xdrs, &objp->oar_status))
+		return false;
+	return true;
+}
+
+static inline bool xdr_OFFLOAD_STATUS4args(XDR *xdrs,
+					   OFFLOAD_STATUS4args *objp)
+{
+	if (!xdr_stateid4(xdrs, &objp->osa_stateid))
+		return false;
+	return true;
+}
+
+static inline bool xdr_OFFLOAD_STATUS4res(XDR *xdrs, OFFLOAD_STATUS4res *objp)
+{
+	OFFLOAD_STATUS4resok *resok = &objp->OFFLOAD_STATUS4res_u.osr_resok4;
+
+	if (!xdr_nfsstat4(xdrs, &objp->osr_status))
+		return false;
+	switch (objp->osr_status) {
+	case NFS4_OK:
+		if (!xdr_length4(xdrs, &resok->osr_bytes_copied))
+			return false;
+		/* osr_complete<1> */
+		if (!xdr_count4(xdrs, &resok->osr_count_complete))
+			return false;
+		if (resok->osr_count_complete > 1)
+			return false;
+		if (resok->osr_count_complete == 1)
+			if (!xdr_nfsstat4(xdrs, &resok->osr_complete))
+				return false;
+		break;
+	default:
+		break;
+	}
+	return true;
+}
+
 static inline bool xdr_SEEK4args(XDR *xdrs, SEEK4args *objp)
 {
 	if (!xdr_stateid4(xdrs, &objp->sa_stateid))
@@ -8153,6 +8385,28 @@ static inline bool xdr_DEALLOCATE4res(XDR *xdrs, DEALLOCATE4res *objp)
 	return true;
 }
 
+static inline bool xdr_CLONE4args(XDR *xdrs, CLONE4args *objp)
+{
+	if (!xdr_stateid4(xdrs, &objp->cl_src_stateid))
+		return false;
+	if (!xdr_stateid4(xdrs, &objp->cl_dst_stateid))
+		return false;
+	if (!xdr_offset4(xdrs, &objp->cl_src_offset))
+		return false;
+	if (!xdr_offset4(xdrs, &objp->cl_dst_offset))
+		return false;
+	if (!xdr_length4(xdrs, &objp->cl_count))
+		return false;
+	return true;
+}
+
+static inline bool xdr_CLONE4res(XDR *xdrs, CLONE4res *objp)
+{
+	if (!xdr_nfsstat4(xdrs, &objp->cl_status))
+		return false;
+	return true;
+}
+
 static inline bool xdr_IO_ADVISE4args(XDR *xdrs, IO_ADVISE4args *objp)
 {
 	if (!xdr_stateid4(xdrs, &objp->iaa_stateid))
@@ -8563,10 +8817,32 @@ static inline bool xdr_nfs_argop4(XDR *xdrs, nfs_argop4 *objp)
 		break;
 
 	case NFS4_OP_COPY:
-	case NFS4_OP_COPY_NOTIFY:
+		if (!xdr_COPY4args(xdrs,
+				&objp->nfs_argop4_u.opcopy))
+			return false;
+		lkhd->flags |= NFS_LOOKAHEAD_WRITE;
+		(lkhd->write)++;
+		break;
 	case NFS4_OP_OFFLOAD_CANCEL:
+		if (!xdr_OFFLOAD_ABORT4args(xdrs,
+				&objp->nfs_argop4_u.opoffload_abort))
+			return false;
+		break;
 	case NFS4_OP_OFFLOAD_STATUS:
+		if (!xdr_OFFLOAD_STATUS4args(xdrs,
+				&objp->nfs_argop4_u.opoffload_status))
+			return false;
+		break;
+
 	case NFS4_OP_CLONE:
+		if (!xdr_CLONE4args(xdrs,
+				&objp->nfs_argop4_u.opclone))
+			return false;
+		lkhd->flags |= NFS_LOOKAHEAD_WRITE;
+		(lkhd->write)++;
+		break;
+
+	case NFS4_OP_COPY_NOTIFY:
 		break;
 
 	/* NFSv4.3 */
@@ -8893,10 +9169,26 @@ static inline bool xdr_nfs_resop4(XDR *xdrs, nfs_resop4 *objp)
 		break;
 
 	case NFS4_OP_COPY:
-	case NFS4_OP_COPY_NOTIFY:
+		if (!xdr_COPY4res(xdrs, &objp->nfs_resop4_u.opcopy))
+			return false;
+		break;
 	case NFS4_OP_OFFLOAD_CANCEL:
+		if (!xdr_OFFLOAD_ABORT4res(xdrs,
+					   &objp->nfs_resop4_u.opoffload_abort))
+			return false;
+		break;
 	case NFS4_OP_OFFLOAD_STATUS:
+		if (!xdr_OFFLOAD_STATUS4res(xdrs,
+					    &objp->nfs_resop4_u.opoffload_status))
+			return false;
+		break;
+
 	case NFS4_OP_CLONE:
+		if (!xdr_CLONE4res(xdrs, &objp->nfs_resop4_u.opclone))
+			return false;
+		break;
+
+	case NFS4_OP_COPY_NOTIFY:
 
 	/* NFSv4.3 */
 	case NFS4_OP_GETXATTR:
@@ -9687,6 +9979,36 @@ static inline bool xdr_CB_NOTIFY_DEVICEID4res(XDR *xdrs,
 	return true;
 }
 
+static inline bool xdr_CB_OFFLOAD4args(XDR *xdrs, CB_OFFLOAD4args *objp)
+{
+	if (!xdr_nfs_fh4(xdrs, &objp->coa_fh))
+		return false;
+	if (!xdr_stateid4(xdrs, &objp->coa_stateid))
+		return false;
+	if (!xdr_nfsstat4(xdrs, &objp->coa_offload_info.coa_status))
+		return false;
+	switch (objp->coa_offload_info.coa_status) {
+	case NFS4_OK:
+		if (!xdr_WRITE_SAME4resok(xdrs,
+		    &objp->coa_offload_info.offload_info4_u.coa_resok4))
+			return false;
+		break;
+	default:
+		if (!xdr_length4(xdrs,
+		    &objp->coa_offload_info.offload_info4_u.coa_bytes_copied))
+			return false;
+		break;
+	}
+	return true;
+}
+
+static inline bool xdr_CB_OFFLOAD4res(XDR *xdrs, CB_OFFLOAD4res *objp)
+{
+	if (!xdr_nfsstat4(xdrs, &objp->cor_status))
+		return false;
+	return true;
+}
+
 /* Callback operations new to NFSv4.1 */
 
 static inline bool xdr_nfs_cb_opnum4(XDR *xdrs, nfs_cb_opnum4 *objp)
@@ -9761,6 +10083,11 @@ static inline bool xdr_nfs_cb_argop4(XDR *xdrs, nfs_cb_argop4 *objp)
 		    &objp->nfs_cb_argop4_u.opcbnotify_deviceid))
 			return false;
 		break;
+	case NFS4_OP_CB_OFFLOAD:
+		if (!xdr_CB_OFFLOAD4args(xdrs,
+		    &objp->nfs_cb_argop4_u.opcboffload))
+			return false;
+		break;
 	case NFS4_OP_CB_ILLEGAL:
 		break;
 	default:
@@ -9834,6 +10161,11 @@ static inline bool xdr_nfs_cb_resop4(XDR *xdrs, nfs_cb_resop4 *objp)
 		    &objp->nfs_cb_resop4_u.opcbnotify_deviceid))
 			return false;
 		break;
+	case NFS4_OP_CB_OFFLOAD:
+		if (!xdr_CB_OFFLOAD4res(xdrs,
+		    &objp->nfs_cb_resop4_u.opcboffload))
+			return false;
+		break;
 	case NFS4_OP_CB_ILLEGAL:
 		if (!xdr_CB_ILLEGAL4res(xdrs,
 		    &objp->nfs_cb_resop4_u.opcbillegal))
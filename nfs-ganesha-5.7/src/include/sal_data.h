@@ -156,7 +156,7 @@ struct nfs41_cached_req {
 
 typedef struct nfs41_session_slot__ {
 	sequenceid4 sequence;	/*< Sequence number of this operation */
-	pthread_mutex_t slot_lock;	/*< Lock on the slot */
+	uint32_t slot_busy;	/*< Set while a request is using the slot */
 	struct COMPOUND4res_extended *cached_result;	/*< NFv41: pointer to
 							   cached RPC result in
 							   a session's slot */
@@ -209,8 +209,10 @@ struct nfs41_session {
 				   and on which we signal when we
 				   free an entry. */
 
-	pthread_rwlock_t conn_lock;
-	int num_conn;
+	pthread_rwlock_t conn_lock;	/*< Taken to add a connection, the
+					   array is append only and may be
+					   searched without it */
+	int32_t num_conn;
 	sockaddr_t connections[NFS41_MAX_CONNECTIONS];
 
 	nfs_client_id_t *clientid_record;	/*< Client record
@@ -773,8 +775,9 @@ struct nfs_client_id_t {
 							  last CREATE_SESSION */
 	state_owner_t cid_owner;	/*< Owner for per-client state */
 	int32_t cid_refcount;	/*< Reference count for lifecycle */
-	int cid_lease_reservations;	/*< Counted lease reservations, to spare
-					   this clientid from the reaper */
+	int32_t cid_lease_reservations;	/*< Counted lease reservations, to spare
+					   this clientid from the reaper.
+					   Atomic, 0 <-> 1 under cid_mutex */
 	uint32_t cid_minorversion;
 	uint32_t cid_stateid_counter;
 
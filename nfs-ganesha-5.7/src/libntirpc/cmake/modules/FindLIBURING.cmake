@@ -0,0 +1,30 @@
+# - Find liburing
+#
+# This module accepts the following optional variables:
+#    LIBURING_PATH_HINT   = A hint on liburing install path.
+#
+# This module defines the following variables:
+#    LIBURING_FOUND       = Was liburing found or not?
+#    LIBURING_LIBRARY     = The list of libraries to link to when using liburing
+#    LIBURING_INCLUDE_DIR = The path to liburing include directory(s)
+#
+# One can set LIBURING_PATH_HINT before using find_package(LIBURING) and the
+# module with use the PATH as a hint to find liburing.
+#
+# The hint can be given on the command line too:
+#   cmake -DLIBURING_PATH_HINT=/DATA/ERIC/liburing /path/to/source
+
+include(LibFindMacros)
+
+set(LIBURING_PKGCONF_INCLUDE_DIRS ${LIBURING_PATH_HINT}/include)
+set(LIBURING_PKGCONF_LIBRARY_DIRS ${LIBURING_PATH_HINT}/lib64 ${LIBURING_PATH_HINT}/lib)
+libfind_pkg_detect(LIBURING liburing FIND_PATH liburing.h FIND_LIBRARY uring)
+libfind_process(LIBURING)
+
+# handle the QUIETLY and REQUIRED arguments and set LIBURING_FOUND to TRUE if
+# all listed variables are TRUE
+include(FindPackageHandleStandardArgs)
+FIND_PACKAGE_HANDLE_STANDARD_ARGS(LIBURING
+                                  REQUIRED_VARS LIBURING_INCLUDE_DIR LIBURING_LIBRARY)
+mark_as_advanced(LIBURING_INCLUDE_DIR)
+mark_as_advanced(LIBURING_LIBRARY)
@@ -19,6 +19,8 @@
 #cmakedefine BIGEND 1
 #cmakedefine TIRPC_EPOLL 1
 #cmakedefine USE_RPC_RDMA 1
+#cmakedefine TIRPC_IO_URING 1
+#cmakedefine TIRPC_TLS 1
 #cmakedefine USE_LTTNG_NTIRPC 1
 
 /* Package stuff */
@@ -7,6 +7,7 @@
 #include <misc/stdio.h>
 #include <misc/rbtree.h>
 #include <rpc/types.h>
+#include <misc/abstract_atomic.h>
 
 struct rbtree_x_part {
 	CACHE_PAD(0);
@@ -61,8 +62,11 @@ static inline struct opr_rbtree_node *rbtree_x_cached_lookup(
 	if (!t)
 		t = rbtx_partition_of_scalar(xt, hk);
 
+	/* The slot may be filled by concurrent lookups when the caller
+	 * holds the partition lock shared; removal must hold it exclusive.
+	 */
 	offset = hk % xt->cachesz;
-	nv_cached = t->cache[offset];
+	nv_cached = atomic_fetch_voidptr((void **)&t->cache[offset]);
 	if (nv_cached) {
 		if (t->t.cmpf(nv_cached, nk) == 0) {
 			nv = nv_cached;
@@ -72,7 +76,7 @@ static inline struct opr_rbtree_node *rbtree_x_cached_lookup(
 
 	nv = opr_rbtree_lookup(&t->t, nk);
 	if (nv && (xt->flags & RBT_X_FLAG_CACHE_RT))
-		t->cache[offset] = nv;
+		atomic_store_voidptr((void **)&t->cache[offset], nv);
 
 	__warnx(TIRPC_DEBUG_FLAG_RBTREE,
 		"rbtree_x_cached_lookup: t %p nk %p nv %p" "(%s hk %" PRIx64
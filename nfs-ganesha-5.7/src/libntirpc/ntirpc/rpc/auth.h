@@ -300,5 +300,6 @@ __END_DECLS
 #define AUTH_DES AUTH_DH	/* for backward compatibility */
 #define AUTH_KERB 4		/* kerberos style */
 #define RPCSEC_GSS 6		/* RPCSEC_GSS */
+#define AUTH_TLS 7		/* RPC-with-TLS probe (RFC 9289) */
 
 #endif				/* !_TIRPC_AUTH_H */
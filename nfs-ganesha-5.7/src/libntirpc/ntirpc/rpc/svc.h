@@ -93,6 +93,7 @@ enum xprt_stat {
 #define SVC_INIT_EPOLL          0x0002
 #define SVC_INIT_NOREG_XPRTS    0x0008
 #define SVC_INIT_BLKIN          0x0010
+#define SVC_INIT_IO_URING       0x0020	/* io_uring event channels */
 
 #define SVC_SHUTDOWN_FLAG_NONE  0x0000
 
@@ -139,6 +140,10 @@ typedef struct svc_init_params {
 	u_int gss_max_gc;
 	uint32_t channels;
 	int32_t idle_timeout;
+	u_int xprt_inflight_max;	/* requests per xprt, 0 for no limit */
+	const char *tls_cert_file;	/* RPC-with-TLS, PEM chain */
+	const char *tls_key_file;	/* RPC-with-TLS, PEM private key */
+	const char *tls_ca_file;	/* verify client certificates if set */
 } svc_init_params;
 
 /* Svc param flags */
@@ -160,6 +165,10 @@ typedef struct svc_init_params {
 #define SVC_XPRT_FLAG_DESTROYING	0x0020	/* SVC_DESTROY() was called */
 #define SVC_XPRT_FLAG_RELEASING		0x0040	/* (*xp_destroy) was called */
 #define SVC_XPRT_FLAG_UREG		0x0080
+#define SVC_XPRT_FLAG_BLOCKED		0x0100	/* recv paused, see
+						 * xprt_inflight_max */
+#define SVC_XPRT_FLAG_TLS_HANDSHAKE	0x0200	/* STARTTLS sent */
+#define SVC_XPRT_FLAG_TLS		0x0400	/* kTLS established */
 
 #define SVC_XPRT_FLAG_DESTROYED (SVC_XPRT_FLAG_DESTROYING \
 				| SVC_XPRT_FLAG_RELEASING)
@@ -41,6 +41,7 @@
 #define WORK_POOL_H
 
 #include <rpc/pool_queue.h>
+#include <misc/portable.h>
 
 struct work_pool_params {
 	int32_t thrd_max;
@@ -49,14 +50,27 @@ struct work_pool_params {
 
 struct work_pool_thread;
 
-struct work_pool {
-	struct poolq_head pqh;
+/* Queued work and idle workers, one per CPU.  Submitters and idle workers
+ * use the shard of the CPU they are running on, and workers with nothing
+ * to do steal from the other shards.
+ */
+struct work_pool_shard {
+	struct poolq_head pqh;		/* qcount: idle workers */
 	TAILQ_HEAD(work_pool_s, work_pool_thread) wptqh;
+	CACHE_PAD(0);
+};
+
+struct work_pool {
+	struct poolq_head pqh;		/* protects n_threads, params */
+	struct work_pool_shard *shards;
 	char *name;
 	pthread_attr_t attr;
 	struct work_pool_params params;
 	long timeout_ms;
+	uint32_t n_shards;
 	uint32_t n_threads;
+	uint32_t n_idle;		/* idle workers, all shards */
+	uint32_t n_queued;		/* queued entries, all shards */
 	uint32_t worker_index;
 };
 
@@ -68,6 +82,7 @@ struct work_pool_thread {
 	pthread_cond_t pqcond;
 
 	struct work_pool *pool;
+	struct work_pool_shard *shard;	/* where idle */
 	struct work_pool_entry *work;
 	char worker_name[16];
 	pthread_t pt;
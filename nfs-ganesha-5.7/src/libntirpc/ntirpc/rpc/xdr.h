@@ -172,6 +172,9 @@ typedef struct xdr_uio {
 #define XDR_FLAG_CKSUM		0x0001
 #define XDR_FLAG_FREE		0x0002
 #define XDR_FLAG_VIO		0x0004
+#define XDR_FLAG_INPLACE	0x0008	/* decoded bytes may stay in the
+					 * stream buffers (xdr_bytes_inplace)
+					 */
 
 /*
  * The XDR handle.
@@ -440,6 +443,23 @@ xdr_inline_encode(XDR *xdrs, size_t count)
 #define IXDR_PUT_ENUM(buf, v)  IXDR_PUT_LONG((buf), (v))
 #define IXDR_PUT_U_LONG(buf, v)  IXDR_PUT_LONG((buf), (v))
 
+/* hyper: most significant word first, 2 units */
+static inline uint64_t
+ixdr_get_u_int64(int32_t **buf)
+{
+	uint64_t hi = IXDR_GET_U_INT32(*buf);
+
+	return (hi << 32 | IXDR_GET_U_INT32(*buf));
+}
+
+#define IXDR_GET_U_INT64(buf) ixdr_get_u_int64(&(buf))
+#define IXDR_PUT_U_INT64(buf, v) \
+	do { \
+		uint64_t __v = (v); \
+		IXDR_PUT_U_INT32((buf), (uint32_t)(__v >> 32)); \
+		IXDR_PUT_U_INT32((buf), (uint32_t)__v); \
+	} while (0)
+
 /*
  * In-line routines for vector encode/decode of primitive data types.
  * Intermediate speed, avoids function calls in most cases, at the expense of
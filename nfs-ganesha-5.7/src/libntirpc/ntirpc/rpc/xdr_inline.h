@@ -674,6 +674,81 @@ xdr_bytes(XDR *xdrs, char **cpp, u_int *sizep, u_int maxsize)
 }
 #define inline_xdr_bytes xdr_bytes
 
+/*
+ * XDR counted bytes, leaving them in the stream buffer where possible.
+ *
+ * For large opaque payloads (WRITE data).  On a stream marked with
+ * XDR_FLAG_INPLACE, *cpp is pointed into the received buffer when the
+ * bytes are contiguous there, and *inplace is set; such a buffer lives
+ * only as long as the stream.  Otherwise, as xdr_bytes().  *inplace
+ * must be kept with *cpp to be passed back for XDR_FREE.
+ */
+static inline bool
+xdr_bytes_inplace(XDR *xdrs, char **cpp, u_int *sizep, u_int maxsize,
+		  bool *inplace)
+{
+	uint32_t size;
+	u_int rndup;
+
+	switch (xdrs->x_op) {
+	case XDR_DECODE:
+		*inplace = false;
+		if (!(xdrs->x_flags & XDR_FLAG_INPLACE) || *cpp)
+			return (xdr_bytes_decode(xdrs, cpp, sizep, maxsize));
+
+		if (!XDR_GETUINT32(xdrs, &size)) {
+			__warnx(TIRPC_DEBUG_FLAG_ERROR,
+				"%s:%u ERROR size",
+				__func__, __LINE__);
+			return (false);
+		}
+		if (size > maxsize) {
+			__warnx(TIRPC_DEBUG_FLAG_ERROR,
+				"%s:%u ERROR size %" PRIu32 " > max %u",
+				__func__, __LINE__,
+				size, maxsize);
+			return (false);
+		}
+		*sizep = (u_int)size;
+
+		if (!size)
+			return (true);
+
+		rndup = RNDUP(size);
+		if ((uintptr_t)xdrs->x_v.vio_tail - (uintptr_t)xdrs->x_data
+		    >= rndup) {
+			*cpp = (char *)xdrs->x_data;
+			xdrs->x_data += rndup;
+			*inplace = true;
+			return (true);
+		}
+
+		/* split across buffers, copy it out */
+		*cpp = (char *)mem_alloc(size);
+		if (!xdr_opaque_decode(xdrs, *cpp, size)) {
+			mem_free(*cpp, size);
+			*cpp = NULL;
+			return (false);
+		}
+		return (true);
+	case XDR_ENCODE:
+		return (xdr_bytes_encode(xdrs, cpp, sizep, maxsize));
+	case XDR_FREE:
+		if (*inplace) {
+			*cpp = NULL;
+			*inplace = false;
+			return (true);
+		}
+		return (xdr_bytes_free(xdrs, cpp, *sizep));
+	}
+
+	__warnx(TIRPC_DEBUG_FLAG_ERROR,
+		"%s:%u ERROR xdrs->x_op (%u)",
+		__func__, __LINE__,
+		xdrs->x_op);
+	return (false);
+}
+
 /*
  * XDR a descriminated union
  * Support routine for discriminated unions.
@@ -53,7 +53,7 @@ struct authgss_hash_st {
 	struct rbtree_x xt;
 	uint32_t max_part;
 	uint32_t size;
-	bool initialized;
+	uint32_t initialized;
 };
 
 static struct authgss_hash_st authgss_hash_st = {
@@ -120,6 +120,10 @@ authgss_hash_init(void)
 {
 	int ix, code = 0;
 
+	/* every lookup comes through here, keep it off the global lock */
+	if (likely(atomic_fetch_uint32_t(&authgss_hash_st.initialized)))
+		return;
+
 	mutex_lock(&authgss_hash_st.lock);
 
 	if (authgss_hash_st.initialized) {
@@ -152,7 +156,7 @@ authgss_hash_init(void)
 	authgss_hash_st.size = 0;
 	authgss_hash_st.max_part =
 	    __svc_params->gss.max_ctx / authgss_hash_st.xt.npart;
-	authgss_hash_st.initialized = true;
+	atomic_store_uint32_t(&authgss_hash_st.initialized, 1);
 
 	mutex_unlock(&authgss_hash_st.lock);
 }
@@ -163,7 +167,6 @@ authgss_ctx_hash_get(struct rpc_gss_cred *gc)
 	struct svc_rpc_gss_data gk, *gd = NULL;
 	gss_union_ctx_id_desc *gss_ctx;
 	struct opr_rbtree_node *ngd;
-	struct authgss_x_part *axp;
 	struct rbtree_x_part *t;
 
 	authgss_hash_init();
@@ -172,21 +175,23 @@ authgss_ctx_hash_get(struct rpc_gss_cred *gc)
 	gk.hk.k = gss_ctx_hash(gss_ctx);
 	gk.ctx = (gc->gc_ctx.value);
 
+	/* Lookups share the partition.  The entry holds its sentinel ref
+	 * while it is in the tree, and it can only leave the tree under the
+	 * write lock, so taking a ref here cannot race with the free.
+	 *
+	 * The LRU is not touched: bumping gen marks the entry referenced,
+	 * and authgss_ctx_gc_idle() gives it a second chance (CLOCK).
+	 */
 	t = rbtx_partition_of_scalar(&authgss_hash_st.xt, gk.hk.k);
-	mutex_lock(&t->mtx);
+	rwlock_rdlock(&t->lock);
 	ngd =
 	    rbtree_x_cached_lookup(&authgss_hash_st.xt, t, &gk.node_k, gk.hk.k);
 	if (ngd) {
 		gd = opr_containerof(ngd, struct svc_rpc_gss_data, node_k);
-		/* lru adjust */
-		axp = (struct authgss_x_part *)t->u1;
-		TAILQ_REMOVE(&axp->lru_q, gd, lru_q);
-		TAILQ_INSERT_TAIL(&axp->lru_q, gd, lru_q);
-		++(axp->gen);
 		(void)atomic_inc_uint32_t(&gd->refcnt);
 		(void)atomic_inc_uint32_t(&gd->gen);
 	}
-	mutex_unlock(&t->mtx);
+	rwlock_unlock(&t->lock);
 
 	return (gd);
 }
@@ -205,8 +210,9 @@ authgss_ctx_hash_set(struct svc_rpc_gss_data *gd)
 	gd->hk.k = gss_ctx_hash(gss_ctx);
 
 	(void)atomic_inc_uint32_t(&gd->refcnt);
+	gd->gc_gen = gd->gen;
 	t = rbtx_partition_of_scalar(&authgss_hash_st.xt, gd->hk.k);
-	mutex_lock(&t->mtx);
+	rwlock_wrlock(&t->lock);
 	rslt =
 	    rbtree_x_cached_insert(&authgss_hash_st.xt, t, &gd->node_k,
 				   gd->hk.k);
@@ -214,7 +220,7 @@ authgss_ctx_hash_set(struct svc_rpc_gss_data *gd)
 	axp = (struct authgss_x_part *)t->u1;
 	TAILQ_INSERT_TAIL(&axp->lru_q, gd, lru_q);
 	++(axp->size);
-	mutex_unlock(&t->mtx);
+	rwlock_unlock(&t->lock);
 
 	/* global size */
 	(void)atomic_inc_uint32_t(&authgss_hash_st.size);
@@ -231,7 +237,7 @@ authgss_ctx_hash_del(struct svc_rpc_gss_data *gd)
 	authgss_hash_init();
 
 	t = rbtx_partition_of_scalar(&authgss_hash_st.xt, gd->hk.k);
-	mutex_lock(&t->mtx);
+	rwlock_wrlock(&t->lock);
 
 	/* Another thread could have removed the entry from the hash.
 	 * We use its presence in the lru list to detect this. @todo:
@@ -241,7 +247,7 @@ authgss_ctx_hash_del(struct svc_rpc_gss_data *gd)
 	 * the hash as well?
 	 */
 	if (!TAILQ_IS_ENQUEUED(gd, lru_q)) {
-		mutex_unlock(&t->mtx);
+		rwlock_unlock(&t->lock);
 		return false;
 	}
 
@@ -250,7 +256,7 @@ authgss_ctx_hash_del(struct svc_rpc_gss_data *gd)
 	TAILQ_REMOVE(&axp->lru_q, gd, lru_q);
 	TAILQ_INIT_ENTRY(gd, lru_q);
 	--(axp->size);
-	mutex_unlock(&t->mtx);
+	rwlock_unlock(&t->lock);
 
 	/* global size */
 	(void)atomic_dec_uint32_t(&authgss_hash_st.size);
@@ -264,11 +270,10 @@ authgss_ctx_hash_del(struct svc_rpc_gss_data *gd)
 static inline bool
 authgss_ctx_expired(struct svc_rpc_gss_data *gd)
 {
-	OM_uint32 maj_stat, min_stat;
-	maj_stat =
-	    gss_inquire_context(&min_stat, gd->ctx, NULL, NULL, NULL, NULL,
-				NULL, NULL, NULL);
-	return (maj_stat == GSS_S_CONTEXT_EXPIRED);
+	/* endtime is the context lifetime from accept_sec_context, set
+	 * before the entry is hashed; no need to ask the mechanism.
+	 */
+	return (gd->established && get_time_fast() >= gd->endtime);
 }
 
 static uint32_t idle_next;
@@ -276,11 +281,19 @@ static uint32_t idle_next;
 #define IDLE_NEXT() \
 	(atomic_inc_uint32_t(&(idle_next)) % authgss_hash_st.xt.npart)
 
+/*
+ * Second-chance sweep from the head of each partition LRU.  An entry that
+ * was looked up since it was last passed over (gen moved) is rotated to
+ * the tail; otherwise it is removed iff it is expired, or the partition
+ * size limit is exceeded.  Both removals and rotations count against
+ * max_gc, so one call does bounded work under each partition lock.
+ */
 void authgss_ctx_gc_idle(void)
 {
 	struct rbtree_x_part *xp;
 	struct authgss_x_part *axp;
 	struct svc_rpc_gss_data *gd;
+	uint32_t gen, scan;
 	int ix, cnt, part;
 
 	authgss_hash_init();
@@ -291,34 +304,46 @@ void authgss_ctx_gc_idle(void)
 	     ++ix, part = IDLE_NEXT()) {
 		xp = &(authgss_hash_st.xt.tree[part]);
 		axp = (struct authgss_x_part *)xp->u1;
-		mutex_lock(&xp->mtx);
+		rwlock_wrlock(&xp->lock);
+		scan = 0;
  again:
 		gd = TAILQ_FIRST(&axp->lru_q);
 		if (!gd)
 			goto next_t;
 
-		/* Remove the least-recently-used entry in this hash
-		 * partition iff it is expired, or the partition size
-		 * limit is exceeded */
-		if (unlikely((axp->size > authgss_hash_st.max_part)
-				|| (authgss_ctx_expired(gd)))) {
+		if (authgss_ctx_expired(gd))
+			goto remove;
 
-			/* remove entry */
-			rbtree_x_cached_remove(&authgss_hash_st.xt, xp,
-					       &gd->node_k, gd->hk.k);
-			TAILQ_REMOVE(&axp->lru_q, gd, lru_q);
-			TAILQ_INIT_ENTRY(gd, lru_q);
-			--(axp->size);
-			(void)atomic_dec_uint32_t(&authgss_hash_st.size);
-
-			/* drop sentinel ref (may free gd) */
-			unref_svc_rpc_gss_data(gd);
+		if (likely(axp->size <= authgss_hash_st.max_part))
+			goto next_t;
 
+		/* referenced since last pass, rotate */
+		gen = atomic_fetch_uint32_t(&gd->gen);
+		if (gen != gd->gc_gen && scan++ < axp->size) {
+			gd->gc_gen = gen;
+			TAILQ_REMOVE(&axp->lru_q, gd, lru_q);
+			TAILQ_INSERT_TAIL(&axp->lru_q, gd, lru_q);
+			++(axp->gen);
 			if (++cnt < __svc_params->gss.max_gc)
 				goto again;
+			goto next_t;
 		}
+
+ remove:
+		rbtree_x_cached_remove(&authgss_hash_st.xt, xp,
+				       &gd->node_k, gd->hk.k);
+		TAILQ_REMOVE(&axp->lru_q, gd, lru_q);
+		TAILQ_INIT_ENTRY(gd, lru_q);
+		--(axp->size);
+		(void)atomic_dec_uint32_t(&authgss_hash_st.size);
+
+		/* drop sentinel ref (may free gd) */
+		unref_svc_rpc_gss_data(gd);
+
+		if (++cnt < __svc_params->gss.max_gc)
+			goto again;
  next_t:
-		mutex_unlock(&xp->mtx);
+		rwlock_unlock(&xp->lock);
 	}
 
 	/* perturb by 1 */
@@ -37,7 +37,8 @@
 /* Svc event strategy */
 enum svc_event_type {
 	SVC_EVENT_FDSET /* trad. using select and poll (currently unhooked) */ ,
-	SVC_EVENT_EPOLL		/* Linux epoll interface */
+	SVC_EVENT_EPOLL,	/* Linux epoll interface */
+	SVC_EVENT_URING		/* Linux io_uring interface */
 };
 
 typedef struct rpc_dplx_lock {
@@ -60,6 +61,8 @@ struct rpc_dplx_rec {
 	struct {
 		rpc_dplx_lock_t lock;
 		struct timespec ts;
+		uint32_t inflight;	/**< atomic count of requests between
+					     svc_request() and free_cb */
 	} recv;
 
 	/*
@@ -83,6 +86,9 @@ struct rpc_dplx_rec {
 	uint32_t call_xid;		/**< current call xid */
 	uint32_t ev_count;		/**< atomic count of waiting events */
 	struct svc_req *svc_req;	/**< svc_req we are processing */
+#if defined(TIRPC_TLS)
+	void *tls;			/**< struct svc_tls_xprt (svc_tls.c) */
+#endif
 };
 #define REC_XPRT(p) (opr_containerof((p), struct rpc_dplx_rec, xprt))
 
@@ -161,11 +161,36 @@ svc_init(svc_init_params *params)
 		__svc_params->ev_type = SVC_EVENT_EPOLL;
 		__svc_params->ev_u.evchan.max_events = params->max_events;
 	}
+#endif
+#if defined(TIRPC_IO_URING)
+	if (params->flags & SVC_INIT_IO_URING) {
+		__svc_params->ev_type = SVC_EVENT_URING;
+		__svc_params->ev_u.evchan.max_events = params->max_events;
+	}
 #else
+	if (params->flags & SVC_INIT_IO_URING)
+		__warnx(TIRPC_DEBUG_FLAG_WARN,
+			"%s: io_uring not supported by this build, using epoll",
+			__func__);
+#endif
+#if !defined(TIRPC_EPOLL)
 	/* XXX formerly select/fd_set case, now placeholder for new
 	 * event systems, reworked select, etc. */
 #endif
 	__svc_params->idle_timeout = params->idle_timeout;
+	__svc_params->xprt_inflight_max = params->xprt_inflight_max;
+
+#if defined(TIRPC_TLS)
+	if (!svc_tls_init(params)) {
+		mutex_unlock(&__svc_params->mtx);
+		return false;
+	}
+#else
+	if (params->tls_cert_file)
+		__warnx(TIRPC_DEBUG_FLAG_WARN,
+			"%s: RPC-with-TLS not supported by this build",
+			__func__);
+#endif
 
 	/* allow consumers to manage all xprt registration */
 	if (params->flags & SVC_INIT_NOREG_XPRTS)
@@ -40,6 +40,7 @@
 #include <sys/types.h>
 #include <rpc/rpc.h>
 #include <rpc/svc_auth.h>
+#include "svc_internal.h"
 #include <stdlib.h>
 
 /*
@@ -103,6 +104,11 @@ svc_auth_authenticate(struct svc_req *req, bool *no_dispatch)
 		rslt = _svcauth_none(req);
 		return (rslt);
 		break;
+#if defined(TIRPC_TLS)
+	case AUTH_TLS:
+		rslt = _svcauth_tls(req);
+		return (rslt);
+#endif
 	case AUTH_SYS:
 		rslt = _svcauth_unix(req);
 		return (rslt);
@@ -160,6 +166,9 @@ int svc_auth_reg(int cred_flavor,
 	case RPCSEC_GSS:
 #ifdef DES_BUILTIN
 	case AUTH_DES:
+#endif
+#if defined(TIRPC_TLS)
+	case AUTH_TLS:
 #endif
 		/* already registered */
 		return (1);
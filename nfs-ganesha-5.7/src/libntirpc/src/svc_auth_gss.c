@@ -105,19 +105,6 @@ svcauth_gss_import_name(char *service)
 	return (true);
 }
 
-#ifdef __APPLE__
-/* there's also mach_absolute_time() - don't know if it's faster */
-#define get_time_fast()	time(0)
-#else
-static inline int64_t
-get_time_fast(void)
-{
-	struct timespec ts[1];
-	(void)clock_gettime(CLOCK_MONOTONIC_FAST, ts);
-	return ts->tv_sec;
-}
-#endif
-
 bool
 svcauth_gss_acquire_cred(void)
 {
@@ -81,6 +81,7 @@ struct svc_params {
 
 	u_long flags;
 	u_int max_connections;
+	u_int xprt_inflight_max;
 	int32_t idle_timeout;
 };
 
@@ -176,6 +177,16 @@ static inline int svc_rqst_rearm_events(SVCXPRT *xprt, uint16_t ev_flags)
 	return code;
 }
 
+bool svc_rqst_recv_blocked(SVCXPRT *);
+
+#if defined(TIRPC_TLS)
+/* in svc_tls.c */
+bool svc_tls_init(const svc_init_params *);
+enum auth_stat _svcauth_tls(struct svc_req *);
+bool svc_tls_accept(SVCXPRT *);
+ssize_t svc_tls_recv(SVCXPRT *, void *, size_t, int);
+void svc_tls_destroy(SVCXPRT *);
+#endif
 int svc_rqst_xprt_register(SVCXPRT *, SVCXPRT *);
 void svc_rqst_xprt_unregister(SVCXPRT *, uint32_t);
 int svc_rqst_evchan_write(SVCXPRT *, struct xdr_ioq *, bool);
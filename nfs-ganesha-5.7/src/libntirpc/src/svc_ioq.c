@@ -70,6 +70,10 @@
 #define LAST_FRAG_XDR_UNITS ((LAST_FRAG - 1) & ~(BYTES_PER_XDR_UNIT - 1))
 #define MAXALLOCA (256)
 
+/* Limits on replies gathered into one sendmsg() by svc_ioq_batch() */
+#define SVC_IOQ_BATCH_IOV (64)
+#define SVC_IOQ_BATCH_BYTES (256 * 1024)
+
 /* Returns 0 on success, EWOULDBLOCK if would block, <0 on error */
 static inline int
 svc_ioq_flushv(SVCXPRT *xprt, struct xdr_ioq *xioq)
@@ -310,6 +314,119 @@ again:
 	return error;
 }
 
+/*
+ * Replies queued behind the head of the writeq are gathered into a
+ * single sendmsg(), each with its own fragment header.  Nothing is held
+ * back waiting for more:  the batch is whatever completed while the
+ * previous write was in flight, so it grows with the queue depth.
+ *
+ * Only single fragment replies not yet started are gathered.  A reply
+ * left partially sent has its progress recorded for svc_ioq_flushv().
+ *
+ * Only the writer removes entries from the writeq, so they remain valid
+ * after the mutex is dropped.
+ *
+ * Returns the number of replies at the head that were completely sent.
+ */
+static int
+svc_ioq_batch(SVCXPRT *xprt, struct rpc_dplx_rec *rec,
+	      struct poolq_entry *have)
+{
+	struct iovec iov[SVC_IOQ_BATCH_IOV];
+	struct xdr_vio vio[SVC_IOQ_BATCH_IOV];
+	u_int32_t frag_header[SVC_IOQ_BATCH_IOV / 2];
+	struct xdr_ioq *batch[SVC_IOQ_BATCH_IOV / 2];
+	struct msghdr msg;
+	ssize_t result;
+	size_t bytes = 0;
+	int iovcnt = 0;
+	int n = 0;
+	int i;
+
+	mutex_lock(&rec->writeq.qmutex);
+	if (!TAILQ_NEXT(have, q)) {
+		/* nothing to gather */
+		mutex_unlock(&rec->writeq.qmutex);
+		return (0);
+	}
+
+	for (; have && n < SVC_IOQ_BATCH_IOV / 2; have = TAILQ_NEXT(have, q)) {
+		struct xdr_ioq *xioq = _IOQ(have);
+		u_int32_t end;
+		int count;
+
+		if (xioq->write_start || xioq->frag_hdr_bytes_sent
+		    || xioq->has_blocked)
+			break;
+
+		xdr_tail_update(xioq->xdrs);
+		end = XDR_GETPOS(xioq->xdrs);
+		if (!end || end > LAST_FRAG_XDR_UNITS
+		    || (n && bytes + end > SVC_IOQ_BATCH_BYTES))
+			break;
+
+		count = XDR_IOVCOUNT(xioq->xdrs, 0, end);
+		if (iovcnt + 1 + count > SVC_IOQ_BATCH_IOV)
+			break;
+
+		if (!XDR_FILLBUFS(xioq->xdrs, 0, &vio[iovcnt + 1], end))
+			break;
+
+		frag_header[n] = htonl(end | LAST_FRAG);
+		iov[iovcnt].iov_base = &frag_header[n];
+		iov[iovcnt].iov_len = sizeof(u_int32_t);
+		for (i = 1; i <= count; i++) {
+			iov[iovcnt + i].iov_base = vio[iovcnt + i].vio_head;
+			iov[iovcnt + i].iov_len = vio[iovcnt + i].vio_length;
+		}
+		iovcnt += 1 + count;
+		bytes += end;
+		batch[n++] = xioq;
+	}
+	mutex_unlock(&rec->writeq.qmutex);
+
+	if (n < 2) {
+		/* no gain, svc_ioq_flushv() will do */
+		return (0);
+	}
+
+	memset(&msg, 0, sizeof(msg));
+	msg.msg_iov = iov;
+	msg.msg_iovlen = iovcnt;
+
+	result = sendmsg(xprt->xp_fd, &msg, MSG_DONTWAIT);
+
+	__warnx(TIRPC_DEBUG_FLAG_SVC_VC,
+		"%s: %p fd %d replies %d iov_count %d bytes %zu result %zd",
+		__func__, xprt, xprt->xp_fd, n, iovcnt,
+		bytes + n * sizeof(u_int32_t), result);
+
+	if (result <= 0) {
+		/* blocked or failed, svc_ioq_flushv() will find out again */
+		return (0);
+	}
+
+	for (i = 0; i < n; i++) {
+		struct xdr_ioq *xioq = batch[i];
+		ssize_t len = sizeof(u_int32_t) + XDR_GETPOS(xioq->xdrs);
+
+		if (result >= len) {
+			result -= len;
+			continue;
+		}
+
+		if (result < sizeof(u_int32_t)) {
+			xioq->frag_hdr_bytes_sent = result;
+		} else {
+			xioq->frag_hdr_bytes_sent = sizeof(u_int32_t);
+			xioq->write_start = result - sizeof(u_int32_t);
+		}
+		break;
+	}
+
+	return (i);
+}
+
 void svc_ioq_write(SVCXPRT *xprt)
 {
 	struct rpc_dplx_rec *rec = REC_XPRT(xprt);
@@ -335,6 +452,27 @@ void svc_ioq_write(SVCXPRT *xprt)
 		/* do i/o unlocked */
 		if (svc_work_pool.params.thrd_max
 		 && !(xprt->xp_flags & SVC_XPRT_FLAG_DESTROYED)) {
+			int done = svc_ioq_batch(xprt, rec, have);
+
+			if (done) {
+				/* retire the replies sent in the batch */
+				while (done--) {
+					mutex_lock(&rec->writeq.qmutex);
+					TAILQ_REMOVE(&rec->writeq.qh, have, q);
+					mutex_unlock(&rec->writeq.qmutex);
+
+					SVC_RELEASE(xprt, SVC_RELEASE_FLAG_NONE);
+					XDR_DESTROY(xioq->xdrs);
+
+					mutex_lock(&rec->writeq.qmutex);
+					have = TAILQ_FIRST(&rec->writeq.qh);
+					mutex_unlock(&rec->writeq.qmutex);
+					if (have)
+						xioq = _IOQ(have);
+				}
+				continue;
+			}
+
 			/* all systems are go! */
 			rc = svc_ioq_flushv(xprt, xioq);
 		}
@@ -34,6 +34,9 @@
 #include <unistd.h>
 #include <fcntl.h>
 #include <signal.h>
+#if defined(TIRPC_IO_URING)
+#include <liburing.h>
+#endif
 
 #include <rpc/types.h>
 #include <misc/portable.h>
@@ -76,6 +79,31 @@
 static uint32_t round_robin;
 /*static*/ uint32_t wakeups;
 
+#if defined(TIRPC_IO_URING)
+/*
+ * The io_uring channel only replaces epoll for readiness: it arms one-shot
+ * poll requests and hands ready transports to the same recv and send tasks,
+ * which still do their own recv() and sendmsg().  Multishot receive,
+ * provided buffer rings and batched sends are not used.
+ */
+
+/* io_uring user_data: fd and what the completion is for */
+#define SVC_URING_CTRL		0	/* control socket sv[1] */
+#define SVC_URING_RECV		1
+#define SVC_URING_SEND		2
+#define SVC_URING_CANCEL	3	/* poll removal, ignored */
+
+#define SVC_URING_DATA(fd, kind) (((uint64_t)(uint32_t)(fd) << 2) | (kind))
+#define SVC_URING_FD(data)	((int)((data) >> 2))
+#define SVC_URING_KIND(data)	((data) & 3)
+
+/* completions copied out of the CQ, so it can be released early */
+struct svc_rqst_uring_ev {
+	uint64_t data;
+	int32_t res;
+};
+#endif
+
 struct svc_rqst_rec {
 	struct work_pool_entry ev_wpe;
 	struct opr_rbtree call_expires;
@@ -97,6 +125,15 @@ struct svc_rqst_rec {
 			u_int max_events;	/* max epoll events */
 			bool sv1_added;
 		} epoll;
+#endif
+#if defined(TIRPC_IO_URING)
+		struct {
+			struct io_uring ring;
+			mutex_t sq_lock;	/* SQ has many producers */
+			struct svc_rqst_uring_ev *events;
+			u_int max_events;
+			bool waiting;		/* loop blocked in the kernel */
+		} uring;
 #endif
 		struct {
 			fd_set set;	/* select/fd_set (currently unhooked) */
@@ -123,7 +160,7 @@ void svc_rqst_rec_init(struct svc_rqst_rec *sr_rec)
 void svc_rqst_rec_destroy(struct svc_rqst_rec *sr_rec)
 {
 #if defined(TIRPC_EPOLL)
-	if (sr_rec->ev_u.epoll.sv1_added) {
+	if (sr_rec->ev_type == SVC_EVENT_EPOLL && sr_rec->ev_u.epoll.sv1_added) {
 		int code;
 
 		code = epoll_ctl(sr_rec->ev_u.epoll.epoll_fd, EPOLL_CTL_DEL,
@@ -161,11 +198,22 @@ void svc_rqst_rec_destroy(struct svc_rqst_rec *sr_rec)
 	}
 
 #if defined(TIRPC_EPOLL)
-	if (sr_rec->ev_u.epoll.epoll_fd > 0) {
+	if (sr_rec->ev_type == SVC_EVENT_EPOLL &&
+	    sr_rec->ev_u.epoll.epoll_fd > 0) {
 		close(sr_rec->ev_u.epoll.epoll_fd);
 		sr_rec->ev_u.epoll.epoll_fd = -1;
 	}
 #endif
+#if defined(TIRPC_IO_URING)
+	if (sr_rec->ev_type == SVC_EVENT_URING) {
+		io_uring_queue_exit(&sr_rec->ev_u.uring.ring);
+		mem_free(sr_rec->ev_u.uring.events,
+			 sr_rec->ev_u.uring.max_events *
+			 sizeof(struct svc_rqst_uring_ev));
+		sr_rec->ev_u.uring.events = NULL;
+		mutex_destroy(&sr_rec->ev_u.uring.sq_lock);
+	}
+#endif
 }
 
 struct svc_rqst_set {
@@ -265,8 +313,116 @@ svc_rqst_lookup_chan(uint32_t chan_id)
 
 /* forward declaration in lieu of moving code {WAS} */
 static void svc_rqst_epoll_loop(struct work_pool_entry *wpe);
+#if defined(TIRPC_IO_URING)
+static void svc_rqst_uring_loop(struct work_pool_entry *wpe);
+#endif
 static void svc_complete_task(struct svc_rqst_rec *sr_rec, bool finished);
 
+#if defined(TIRPC_IO_URING)
+/*
+ * Queue a poll (or removal of one) on an io_uring event channel.
+ *
+ * The event loop submits everything queued before it blocks, so polls
+ * rearmed while it is busy are batched into a single io_uring_enter().
+ * The ring is only kicked here when the loop is already blocked, or for
+ * removal:  an armed poll holds a reference on the file, so the socket
+ * would not really close until the removal is seen.
+ */
+static int
+svc_rqst_uring_sqe(struct svc_rqst_rec *sr_rec, int fd, uint64_t kind,
+		   unsigned int poll_mask, bool cancel)
+{
+	struct io_uring *ring = &sr_rec->ev_u.uring.ring;
+	struct io_uring_sqe *sqe;
+	int code = 0;
+
+	mutex_lock(&sr_rec->ev_u.uring.sq_lock);
+	sqe = io_uring_get_sqe(ring);
+	if (unlikely(!sqe)) {
+		/* SQ full, hand it to the kernel and retry */
+		(void)io_uring_submit(ring);
+		sqe = io_uring_get_sqe(ring);
+	}
+	if (unlikely(!sqe)) {
+		code = EBUSY;
+		goto unlock;
+	}
+
+	if (cancel) {
+		io_uring_prep_poll_remove(sqe, SVC_URING_DATA(fd, kind));
+		io_uring_sqe_set_data64(sqe,
+					SVC_URING_DATA(fd, SVC_URING_CANCEL));
+	} else {
+		io_uring_prep_poll_add(sqe, fd, poll_mask);
+		io_uring_sqe_set_data64(sqe, SVC_URING_DATA(fd, kind));
+	}
+
+	if (cancel || sr_rec->ev_u.uring.waiting) {
+		int rc = io_uring_submit(ring);
+
+		if (rc < 0)
+			code = -rc;
+	}
+
+ unlock:
+	mutex_unlock(&sr_rec->ev_u.uring.sq_lock);
+	return (code);
+}
+
+static int
+svc_rqst_uring_setup(struct svc_rqst_rec *sr_rec)
+{
+	struct io_uring_params p;
+	int code;
+
+	sr_rec->ev_u.uring.max_events = __svc_params->ev_u.evchan.max_events;
+
+	memset(&p, 0, sizeof(p));
+	code = io_uring_queue_init_params(sr_rec->ev_u.uring.max_events,
+					  &sr_rec->ev_u.uring.ring, &p);
+	if (code < 0) {
+		__warnx(TIRPC_DEBUG_FLAG_WARN,
+			"%s: io_uring_queue_init failed (%d)",
+			__func__, -code);
+		return (-code);
+	}
+
+	/* waiting with a timeout must not consume an SQE, or the loop
+	 * would race the producers for the SQ
+	 */
+	if (!(p.features & IORING_FEAT_EXT_ARG)) {
+		__warnx(TIRPC_DEBUG_FLAG_WARN,
+			"%s: kernel io_uring lacks IORING_FEAT_EXT_ARG",
+			__func__);
+		io_uring_queue_exit(&sr_rec->ev_u.uring.ring);
+		return (ENOTSUP);
+	}
+
+	mutex_init(&sr_rec->ev_u.uring.sq_lock, NULL);
+	sr_rec->ev_u.uring.waiting = false;
+	sr_rec->ev_u.uring.events =
+		mem_alloc(sr_rec->ev_u.uring.max_events *
+			  sizeof(struct svc_rqst_uring_ev));
+
+	/* permit wakeup of the loop, as for epoll */
+	code = svc_rqst_uring_sqe(sr_rec, sr_rec->sv[1], SVC_URING_CTRL,
+				  POLLIN, false);
+	if (code) {
+		__warnx(TIRPC_DEBUG_FLAG_ERROR,
+			"%s: add control socket failed (%d)", __func__,
+			code);
+		mem_free(sr_rec->ev_u.uring.events,
+			 sr_rec->ev_u.uring.max_events *
+			 sizeof(struct svc_rqst_uring_ev));
+		mutex_destroy(&sr_rec->ev_u.uring.sq_lock);
+		io_uring_queue_exit(&sr_rec->ev_u.uring.ring);
+		return (code);
+	}
+
+	return (0);
+}
+#endif
+
 static int
 svc_rqst_expire_cmpf(const struct opr_rbtree_node *lhs,
 		     const struct opr_rbtree_node *rhs)
@@ -423,6 +579,20 @@ svc_rqst_new_evchan(uint32_t *chan_id /* OUT */, void *u_data, uint32_t flags)
 	SetNonBlock(sr_rec->sv[0]);
 	SetNonBlock(sr_rec->sv[1]);
 
+#if defined(TIRPC_IO_URING)
+	if (__svc_params->ev_type == SVC_EVENT_URING
+	    && !svc_rqst_uring_setup(sr_rec)) {
+		sr_rec->ev_type = SVC_EVENT_URING;
+		fun = svc_rqst_uring_loop;
+
+		__warnx(TIRPC_DEBUG_FLAG_SVC_RQST | TIRPC_DEBUG_FLAG_REFCNT,
+			"%s: sr_rec %p evchan %d ev_refcnt %" PRId32
+			" io_uring fd %d",
+			__func__,
+			sr_rec, sr_rec->id_k, ref_rec,
+			sr_rec->ev_u.uring.ring.ring_fd);
+	} else
+#endif
 #if defined(TIRPC_EPOLL)
 	if (flags & SVC_RQST_FLAG_EPOLL) {
 		sr_rec->ev_type = SVC_EVENT_EPOLL;
@@ -513,6 +683,58 @@ fail:
 	return (code);
 }
 
+#if defined(TIRPC_IO_URING)
+/*
+ * Arm oneshot polls for an xprt.  The send side polls the primary fd
+ * directly, there is no need for the dup() that epoll requires.
+ *
+ * RPC_DPLX_LOCKED, and SVC_XPRT_FLAG_ADDED set
+ */
+static int
+svc_rqst_uring_arm(struct rpc_dplx_rec *rec, struct svc_rqst_rec *sr_rec,
+		   uint16_t ev_flags)
+{
+	int code = 0;
+	int rc;
+
+	if (ev_flags & SVC_XPRT_FLAG_ADDED_RECV) {
+		rc = svc_rqst_uring_sqe(sr_rec, rec->xprt.xp_fd,
+					SVC_URING_RECV, POLLIN, false);
+		if (rc) {
+			code = rc;
+			atomic_clear_uint16_t_bits(&rec->xprt.xp_flags,
+						   SVC_XPRT_FLAG_ADDED_RECV);
+			__warnx(TIRPC_DEBUG_FLAG_ERROR,
+				"%s: %p fd %d xp_refcnt %" PRId32
+				" sr_rec %p evchan %d ev_refcnt %" PRId32
+				" io_uring poll in failed (%d)",
+				__func__, rec, rec->xprt.xp_fd,
+				rec->xprt.xp_refcnt,
+				sr_rec, sr_rec->id_k, sr_rec->ev_refcnt, code);
+		}
+	}
+
+	if (ev_flags & SVC_XPRT_FLAG_ADDED_SEND) {
+		rc = svc_rqst_uring_sqe(sr_rec, rec->xprt.xp_fd,
+					SVC_URING_SEND, POLLOUT, false);
+		if (rc) {
+			code = rc;
+			atomic_clear_uint16_t_bits(&rec->xprt.xp_flags,
+						   SVC_XPRT_FLAG_ADDED_SEND);
+			__warnx(TIRPC_DEBUG_FLAG_ERROR,
+				"%s: %p fd %d xp_refcnt %" PRId32
+				" sr_rec %p evchan %d ev_refcnt %" PRId32
+				" io_uring poll out failed (%d)",
+				__func__, rec, rec->xprt.xp_fd,
+				rec->xprt.xp_refcnt,
+				sr_rec, sr_rec->id_k, sr_rec->ev_refcnt, code);
+		}
+	}
+
+	return (code);
+}
+#endif
+
 /*
  * may be RPC_DPLX_LOCKED, and SVC_XPRT_FLAG_ADDED cleared
  */
@@ -620,6 +842,48 @@ svc_rqst_unhook_events(struct rpc_dplx_rec *rec, struct svc_rqst_rec *sr_rec,
 		}
 		break;
 	}
+#endif
+#if defined(TIRPC_IO_URING)
+	case SVC_EVENT_URING:
+		/* the poll may already have fired, in which case the removal
+		 * completes with -ENOENT and is ignored like any other
+		 */
+		if (ev_flags & SVC_XPRT_FLAG_ADDED_RECV) {
+			code = svc_rqst_uring_sqe(sr_rec, rec->xprt.xp_fd,
+						  SVC_URING_RECV, 0, true);
+			if (code)
+				__warnx(TIRPC_DEBUG_FLAG_WARN,
+					"%s: %p fd %d xp_refcnt %" PRId32
+					" sr_rec %p evchan %d ev_refcnt %" PRId32
+					" io_uring unhook failed (%d)",
+					__func__, rec, rec->xprt.xp_fd,
+					rec->xprt.xp_refcnt,
+					sr_rec, sr_rec->id_k, sr_rec->ev_refcnt,
+					code);
+			else
+				atomic_clear_uint16_t_bits(
+						&rec->xprt.xp_flags,
+						SVC_XPRT_FLAG_ADDED_RECV);
+		}
+
+		if (ev_flags & SVC_XPRT_FLAG_ADDED_SEND) {
+			code = svc_rqst_uring_sqe(sr_rec, rec->xprt.xp_fd,
+						  SVC_URING_SEND, 0, true);
+			if (code)
+				__warnx(TIRPC_DEBUG_FLAG_WARN,
+					"%s: %p fd %d xp_refcnt %" PRId32
+					" sr_rec %p evchan %d ev_refcnt %" PRId32
+					" io_uring unhook failed (%d)",
+					__func__, rec, rec->xprt.xp_fd,
+					rec->xprt.xp_refcnt,
+					sr_rec, sr_rec->id_k, sr_rec->ev_refcnt,
+					code);
+			else
+				atomic_clear_uint16_t_bits(
+						&rec->xprt.xp_flags,
+						SVC_XPRT_FLAG_ADDED_SEND);
+		}
+		break;
 #endif
 	default:
 		/* XXX formerly select/fd_set case, now placeholder for new
@@ -756,6 +1020,23 @@ svc_rqst_rearm_events_locked(SVCXPRT *xprt, uint16_t ev_flags)
 		}
 		break;
 	}
+#endif
+#if defined(TIRPC_IO_URING)
+	case SVC_EVENT_URING:
+		if (ev_flags & SVC_XPRT_FLAG_ADDED_RECV) {
+			code = svc_rqst_uring_arm(rec, sr_rec,
+						  SVC_XPRT_FLAG_ADDED_RECV);
+			if (code)
+				SVC_RELEASE(xprt, SVC_RELEASE_FLAG_NONE);
+		}
+
+		if (ev_flags & SVC_XPRT_FLAG_ADDED_SEND) {
+			code = svc_rqst_uring_arm(rec, sr_rec,
+						  SVC_XPRT_FLAG_ADDED_SEND);
+			if (code)
+				SVC_RELEASE(xprt, SVC_RELEASE_FLAG_NONE);
+		}
+		break;
 #endif
 	default:
 		/* XXX formerly select/fd_set case, now placeholder for new
@@ -889,6 +1170,15 @@ svc_rqst_hook_events(struct rpc_dplx_rec *rec, struct svc_rqst_rec *sr_rec,
 		}
 		break;
 	}
+#endif
+#if defined(TIRPC_IO_URING)
+	case SVC_EVENT_URING:
+		/* as for epoll, the xprt is looked up by fd on completion,
+		 * and a oneshot poll is the same whether it is first armed
+		 * or rearmed
+		 */
+		code = svc_rqst_uring_arm(rec, sr_rec, ev_flags);
+		break;
 #endif
 	default:
 		/* XXX formerly select/fd_set case, now placeholder for new
@@ -1187,12 +1477,72 @@ svc_rqst_xprt_task_recv(struct work_pool_entry *wpe)
 	SVC_RELEASE(&rec->xprt, SVC_RELEASE_FLAG_NONE);
 }
 
+/*
+ * Called by the receive path with a complete request in hand, before
+ * svc_request().  Returns true when the transport already has
+ * xprt_inflight_max requests in progress, in which case the caller must
+ * not rearm receive: svc_request_done() does so when one of them finishes.
+ * Until then the socket buffer fills and TCP pushes back on the client,
+ * rather than one client queueing unbounded work ahead of everyone else.
+ */
+bool
+svc_rqst_recv_blocked(SVCXPRT *xprt)
+{
+	struct rpc_dplx_rec *rec = REC_XPRT(xprt);
+	u_int max = __svc_params->xprt_inflight_max;
+
+	/* the request in hand is not counted yet */
+	if (!max || atomic_fetch_uint32_t(&rec->recv.inflight) + 1 < max)
+		return false;
+
+	atomic_set_uint16_t_bits(&xprt->xp_flags, SVC_XPRT_FLAG_BLOCKED);
+
+	/* a request may have finished before the flag was visible, whoever
+	 * clears the flag owns the rearm
+	 */
+	if (atomic_fetch_uint32_t(&rec->recv.inflight) + 1 < max
+	    && (atomic_postclear_uint16_t_bits(&xprt->xp_flags,
+					       SVC_XPRT_FLAG_BLOCKED)
+		& SVC_XPRT_FLAG_BLOCKED))
+		return false;
+
+	__warnx(TIRPC_DEBUG_FLAG_SVC_RQST,
+		"%s: %p fd %d blocked with %" PRIu32 " requests in flight",
+		__func__, xprt, xprt->xp_fd,
+		atomic_fetch_uint32_t(&rec->recv.inflight));
+	return true;
+}
+
+static inline void
+svc_request_done(SVCXPRT *xprt)
+{
+	struct rpc_dplx_rec *rec = REC_XPRT(xprt);
+
+	atomic_dec_uint32_t(&rec->recv.inflight);
+
+	if (!(atomic_fetch_uint16_t(&xprt->xp_flags) & SVC_XPRT_FLAG_BLOCKED)
+	    || !(atomic_postclear_uint16_t_bits(&xprt->xp_flags,
+						SVC_XPRT_FLAG_BLOCKED)
+		 & SVC_XPRT_FLAG_BLOCKED))
+		return;
+
+	if (unlikely(svc_rqst_rearm_events(xprt, SVC_XPRT_FLAG_ADDED_RECV))) {
+		__warnx(TIRPC_DEBUG_FLAG_ERROR,
+			"%s: %p fd %d svc_rqst_rearm_events failed (will set dead)",
+			__func__, xprt, xprt->xp_fd);
+		SVC_DESTROY(xprt);
+	}
+}
+
 enum xprt_stat svc_request(SVCXPRT *xprt, XDR *xdrs)
 {
 	enum xprt_stat stat;
-	struct svc_req *req = __svc_params->alloc_cb(xprt, xdrs);
+	struct svc_req *req;
 	struct rpc_dplx_rec *rpc_dplx_rec = REC_XPRT(xprt);
 
+	atomic_inc_uint32_t(&rpc_dplx_rec->recv.inflight);
+	req = __svc_params->alloc_cb(xprt, xdrs);
+
 	/* Track the request we are processing */
 	rpc_dplx_rec->svc_req = req;
 
@@ -1214,6 +1564,7 @@ enum xprt_stat svc_request(SVCXPRT *xprt, XDR *xdrs)
 
 	XDR_DESTROY(req->rq_xdrs);
 
+	svc_request_done(xprt);
 	__svc_params->free_cb(req, stat);
 
 	return stat;
@@ -1241,6 +1592,7 @@ static void svc_resume_task(struct work_pool_entry *wpe)
 
 	XDR_DESTROY(req->rq_xdrs);
 
+	svc_request_done(req->rq_xprt);
 	__svc_params->free_cb(req, stat);
 }
 
@@ -1345,63 +1697,88 @@ svc_rqst_clean_idle(int timeout)
 	return;
 }
 
-#ifdef TIRPC_EPOLL
+#if defined(TIRPC_EPOLL) || defined(TIRPC_IO_URING)
+/*
+ * Queue expired calls, return the time to wait for the next expiry
+ */
+static int
+svc_rqst_expire_calls(struct svc_rqst_rec *sr_rec)
+{
+	struct clnt_req *cc;
+	struct opr_rbtree_node *n;
+	struct timespec ts;
+	int timeout_ms = SVC_RQST_TIMEOUT_MS;
+	int expire_ms;
+
+	/* coarse nsec, not system time */
+	(void)clock_gettime(CLOCK_MONOTONIC_FAST, &ts);
+	expire_ms = timespec_ms(&ts);
+
+	/* before waiting, will accumulate events during scan */
+	mutex_lock(&sr_rec->ev_lock);
+	while ((n = opr_rbtree_first(&sr_rec->call_expires))) {
+		cc = opr_containerof(n, struct clnt_req, cc_rqst);
+
+		if (cc->cc_expire_ms > expire_ms) {
+			timeout_ms = cc->cc_expire_ms - expire_ms;
+			break;
+		}
+
+		/* order dependent */
+		atomic_clear_uint16_t_bits(&cc->cc_flags,
+					   CLNT_REQ_FLAG_EXPIRING);
+		opr_rbtree_remove(&sr_rec->call_expires, &cc->cc_rqst);
+		cc->cc_expire_ms = 0;	/* atomic barrier(s) */
+
+		atomic_inc_uint32_t(&cc->cc_refcnt);
+		cc->cc_wpe.fun = svc_rqst_expire_task;
+		cc->cc_wpe.arg = NULL;
+		work_pool_submit(&svc_work_pool, &cc->cc_wpe);
+	}
+	mutex_unlock(&sr_rec->ev_lock);
+
+	return (timeout_ms);
+}
 
+/*
+ * Common part of a RECV or SEND event, whatever the event channel type.
+ * Returns the ioq to work on with a ref on its xprt, or NULL.
+ */
 static struct xdr_ioq *
-svc_rqst_epoll_event(struct svc_rqst_rec *sr_rec, struct epoll_event *ev)
+svc_rqst_xprt_event(struct svc_rqst_rec *sr_rec, int fd, uint16_t ev_flag)
 {
 	SVCXPRT *xprt;
 	struct rpc_dplx_rec *rec;
-	uint16_t xp_flags, ev_flag = 0;
-	struct xdr_ioq *ioq = NULL;
+	uint16_t xp_flags;
+	struct xdr_ioq *ioq;
 	work_pool_fun_t fun;
 
-	if (unlikely(ev->data.fd == sr_rec->sv[1])) {
-		/* signalled -- there was a wakeup on ctrl_ev (see
-		 * top-of-loop) */
-		__warnx(TIRPC_DEBUG_FLAG_SVC_RQST,
-			"%s: fd %d wakeup (sr_rec %p)",
-			__func__, sr_rec->sv[1],
-			sr_rec);
-		(void)consume_ev_sig_nb(sr_rec->sv[1]);
-		__warnx(TIRPC_DEBUG_FLAG_SVC_RQST,
-			"%s: fd %d after consume sig (sr_rec %p)",
-			__func__, sr_rec->sv[1],
-			sr_rec);
-		return (NULL);
-	}
-
-	xprt = svc_xprt_lookup(ev->data.fd, NULL);
+	xprt = svc_xprt_lookup(fd, NULL);
 	if (!xprt) {
 		__warnx(TIRPC_DEBUG_FLAG_SVC_RQST,
 			"%s: fd %d no associated xprt",
-			__func__, ev->data.fd);
+			__func__, fd);
 		return (NULL);
 	}
 	/* At this point, we have a ref on the xprt, and know it's valid */
 	rec = REC_XPRT(xprt);
 
-	__warnx(TIRPC_DEBUG_FLAG_SVC_RQST,
-		"%s: event %p %08x%s%s rpc_dplx_rec %p (sr_rec %p)",
-		__func__, ev, ev->events,
-		ev->events & EPOLLIN ? " RECV" : "",
-		ev->events & EPOLLOUT ? " SEND" : "",
-		rec, sr_rec);
-
-	if (ev->events & EPOLLIN) {
-		/* This is a RECV event */
-		ev_flag = SVC_XPRT_FLAG_ADDED_RECV;
+	if ((ev_flag & SVC_XPRT_FLAG_ADDED_RECV)
+#if defined(TIRPC_TLS)
+	    || ((rec->xprt.xp_flags & SVC_XPRT_FLAG_TLS_HANDSHAKE)
+		&& !rec->ev_u.epoll.xioq_send)
+#endif
+	   ) {
+		/* This is a RECV event, or a SEND event the TLS handshake
+		 * waits on (armed without an xioq), which also resumes in
+		 * svc_vc_recv().
+		 */
 		ioq = &rec->ioq;
 		fun = svc_rqst_xprt_task_recv;
-	} else if (ev->events & EPOLLOUT) {
+	} else {
 		/* This is a SEND event */
-		ev_flag = SVC_XPRT_FLAG_ADDED_SEND;
 		ioq = rec->ev_u.epoll.xioq_send;
 		fun = svc_rqst_xprt_task_send;
-	} else {
-		/* This is some other event... */
-		SVC_RELEASE(&rec->xprt, SVC_RELEASE_FLAG_NONE);
-		return NULL;
 	}
 
 	/* MUST handle flags after reference.
@@ -1412,13 +1789,13 @@ svc_rqst_epoll_event(struct svc_rqst_rec *sr_rec, struct epoll_event *ev)
 	__warnx(TIRPC_DEBUG_FLAG_SVC_RQST |
 		TIRPC_DEBUG_FLAG_REFCNT,
 		"%s: %p fd %d xp_refcnt %" PRId32
-		" event %08x xp_flags%s%s clear flag%s%s",
+		" xp_flags%s%s clear flag%s%s (sr_rec %p)",
 		__func__, rec, rec->xprt.xp_fd, rec->xprt.xp_refcnt,
-		ev->events,
 		xp_flags & SVC_XPRT_FLAG_ADDED_RECV ? " ADDED_RECV" : "",
 		xp_flags & SVC_XPRT_FLAG_ADDED_SEND ? " ADDED_SEND" : "",
 		ev_flag & SVC_XPRT_FLAG_ADDED_RECV ? " ADDED_RECV" : "",
-		ev_flag & SVC_XPRT_FLAG_ADDED_SEND ? " ADDED_SEND" : "");
+		ev_flag & SVC_XPRT_FLAG_ADDED_SEND ? " ADDED_SEND" : "",
+		sr_rec);
 
 #ifdef USE_LTTNG_NTIRPC
 	tracepoint(xprt, event, __func__, __LINE__, &rec->xprt, xp_flags,
@@ -1445,6 +1822,45 @@ svc_rqst_epoll_event(struct svc_rqst_rec *sr_rec, struct epoll_event *ev)
 	SVC_RELEASE(&rec->xprt, SVC_RELEASE_FLAG_NONE);
 	return (NULL);
 }
+#endif
+
+#ifdef TIRPC_EPOLL
+
+static struct xdr_ioq *
+svc_rqst_epoll_event(struct svc_rqst_rec *sr_rec, struct epoll_event *ev)
+{
+	if (unlikely(ev->data.fd == sr_rec->sv[1])) {
+		/* signalled -- there was a wakeup on ctrl_ev (see
+		 * top-of-loop) */
+		__warnx(TIRPC_DEBUG_FLAG_SVC_RQST,
+			"%s: fd %d wakeup (sr_rec %p)",
+			__func__, sr_rec->sv[1],
+			sr_rec);
+		(void)consume_ev_sig_nb(sr_rec->sv[1]);
+		__warnx(TIRPC_DEBUG_FLAG_SVC_RQST,
+			"%s: fd %d after consume sig (sr_rec %p)",
+			__func__, sr_rec->sv[1],
+			sr_rec);
+		return (NULL);
+	}
+
+	__warnx(TIRPC_DEBUG_FLAG_SVC_RQST,
+		"%s: event %p fd %d %08x%s%s (sr_rec %p)",
+		__func__, ev, ev->data.fd, ev->events,
+		ev->events & EPOLLIN ? " RECV" : "",
+		ev->events & EPOLLOUT ? " SEND" : "",
+		sr_rec);
+
+	if (ev->events & EPOLLIN)
+		return svc_rqst_xprt_event(sr_rec, ev->data.fd,
+					   SVC_XPRT_FLAG_ADDED_RECV);
+	if (ev->events & EPOLLOUT)
+		return svc_rqst_xprt_event(sr_rec, ev->data.fd,
+					   SVC_XPRT_FLAG_ADDED_SEND);
+
+	/* This is some other event... */
+	return (NULL);
+}
 
 /*
  * not locked
@@ -1487,43 +1903,12 @@ static void svc_rqst_epoll_loop(struct work_pool_entry *wpe)
 {
 	struct svc_rqst_rec *sr_rec = 
 		opr_containerof(wpe, struct svc_rqst_rec, ev_wpe);
-	struct clnt_req *cc;
-	struct opr_rbtree_node *n;
-	struct timespec ts;
 	int timeout_ms;
-	int expire_ms;
 	int n_events;
 	bool finished;
 
 	for (;;) {
-		timeout_ms = SVC_RQST_TIMEOUT_MS;
-
-		/* coarse nsec, not system time */
-		(void)clock_gettime(CLOCK_MONOTONIC_FAST, &ts);
-		expire_ms = timespec_ms(&ts);
-
-		/* before epoll_wait will accumulate events during scan */
-		mutex_lock(&sr_rec->ev_lock);
-		while ((n = opr_rbtree_first(&sr_rec->call_expires))) {
-			cc = opr_containerof(n, struct clnt_req, cc_rqst);
-
-			if (cc->cc_expire_ms > expire_ms) {
-				timeout_ms = cc->cc_expire_ms - expire_ms;
-				break;
-			}
-
-			/* order dependent */
-			atomic_clear_uint16_t_bits(&cc->cc_flags,
-						   CLNT_REQ_FLAG_EXPIRING);
-			opr_rbtree_remove(&sr_rec->call_expires, &cc->cc_rqst);
-			cc->cc_expire_ms = 0;	/* atomic barrier(s) */
-
-			atomic_inc_uint32_t(&cc->cc_refcnt);
-			cc->cc_wpe.fun = svc_rqst_expire_task;
-			cc->cc_wpe.arg = NULL;
-			work_pool_submit(&svc_work_pool, &cc->cc_wpe);
-		}
-		mutex_unlock(&sr_rec->ev_lock);
+		timeout_ms = svc_rqst_expire_calls(sr_rec);
 
 		__warnx(TIRPC_DEBUG_FLAG_SVC_RQST,
 			"%s: epoll_fd %d before epoll_wait (%d)",
@@ -1617,6 +2002,233 @@ static void svc_rqst_epoll_loop(struct work_pool_entry *wpe)
 }
 #endif
 
+#if defined(TIRPC_IO_URING)
+/*
+ * Copy completions out of the CQ and release them to the kernel.
+ * The loop task is the only CQ consumer.
+ */
+static int
+svc_rqst_uring_reap(struct svc_rqst_rec *sr_rec)
+{
+	struct io_uring *ring = &sr_rec->ev_u.uring.ring;
+	struct io_uring_cqe *cqe;
+	unsigned int head;
+	int n_events = 0;
+
+	io_uring_for_each_cqe(ring, head, cqe) {
+		if (n_events >= sr_rec->ev_u.uring.max_events)
+			break;
+		sr_rec->ev_u.uring.events[n_events].data =
+			io_uring_cqe_get_data64(cqe);
+		sr_rec->ev_u.uring.events[n_events].res = cqe->res;
+		n_events++;
+	}
+	io_uring_cq_advance(ring, n_events);
+
+	return (n_events);
+}
+
+static struct xdr_ioq *
+svc_rqst_uring_event(struct svc_rqst_rec *sr_rec,
+		     struct svc_rqst_uring_ev *ev)
+{
+	int fd = SVC_URING_FD(ev->data);
+
+	switch (SVC_URING_KIND(ev->data)) {
+	case SVC_URING_CTRL:
+		/* signalled -- there was a wakeup on ctrl_ev */
+		__warnx(TIRPC_DEBUG_FLAG_SVC_RQST,
+			"%s: fd %d wakeup (sr_rec %p)",
+			__func__, sr_rec->sv[1],
+			sr_rec);
+		(void)consume_ev_sig_nb(sr_rec->sv[1]);
+		(void)svc_rqst_uring_sqe(sr_rec, sr_rec->sv[1],
+					 SVC_URING_CTRL, POLLIN, false);
+		return (NULL);
+	case SVC_URING_RECV:
+	case SVC_URING_SEND:
+		__warnx(TIRPC_DEBUG_FLAG_SVC_RQST,
+			"%s: fd %d res %d%s (sr_rec %p)",
+			__func__, fd, ev->res,
+			SVC_URING_KIND(ev->data) == SVC_URING_RECV
+				? " RECV" : " SEND",
+			sr_rec);
+		/* cancelled by unhook, or the fd has gone away */
+		if (ev->res < 0)
+			return (NULL);
+
+		/* POLLHUP and POLLERR are left for recv/send to report */
+		return svc_rqst_xprt_event(sr_rec, fd,
+			SVC_URING_KIND(ev->data) == SVC_URING_RECV
+				? SVC_XPRT_FLAG_ADDED_RECV
+				: SVC_XPRT_FLAG_ADDED_SEND);
+	default:
+		/* poll removal */
+		return (NULL);
+	}
+}
+
+/*
+ * not locked
+ */
+static inline struct xdr_ioq *
+svc_rqst_uring_events(struct svc_rqst_rec *sr_rec, int n_events)
+{
+	struct xdr_ioq *ioq = NULL;
+	int ix = 0;
+
+	/* Find the first RECV or SEND event */
+	while (ix < n_events) {
+		ioq = svc_rqst_uring_event(sr_rec,
+					   &sr_rec->ev_u.uring.events[ix++]);
+		if (ioq)
+			break;
+	}
+
+	if (!ioq) {
+		/* continue waiting for events with this task */
+		return NULL;
+	}
+
+	while (ix < n_events) {
+		/* Queue up additional RECV or SEND events */
+		struct xdr_ioq *ioq = svc_rqst_uring_event(sr_rec,
+					    &(sr_rec->ev_u.uring.events[ix++]));
+		if (ioq)
+			work_pool_submit(&svc_work_pool, &ioq->ioq_wpe);
+	}
+
+	/* submit another task to handle events in order */
+	atomic_inc_int32_t(&sr_rec->ev_refcnt);
+	work_pool_submit(&svc_work_pool, &sr_rec->ev_wpe);
+
+	return ioq;
+}
+
+/*
+ * Same task structure as the epoll loop.  While completions are pending
+ * they are reaped straight from the shared CQ ring with no system call;
+ * polls rearmed in the meantime go to the kernel in one batch, together
+ * with the wait when there is nothing left to reap.
+ */
+static void svc_rqst_uring_loop(struct work_pool_entry *wpe)
+{
+	struct svc_rqst_rec *sr_rec =
+		opr_containerof(wpe, struct svc_rqst_rec, ev_wpe);
+	struct io_uring *ring = &sr_rec->ev_u.uring.ring;
+	struct io_uring_cqe *cqe;
+	struct __kernel_timespec kts;
+	int timeout_ms;
+	int n_events;
+	int code;
+	bool finished;
+
+	for (;;) {
+		timeout_ms = svc_rqst_expire_calls(sr_rec);
+
+		mutex_lock(&sr_rec->ev_u.uring.sq_lock);
+		n_events = svc_rqst_uring_reap(sr_rec);
+		if (!n_events) {
+			/* producers must kick the ring from now on */
+			sr_rec->ev_u.uring.waiting = true;
+		}
+		/* no system call unless there are rearms pending */
+		(void)io_uring_submit(ring);
+		mutex_unlock(&sr_rec->ev_u.uring.sq_lock);
+
+		if (!n_events) {
+			__warnx(TIRPC_DEBUG_FLAG_SVC_RQST,
+				"%s: ring_fd %d before wait (%d)",
+				__func__, ring->ring_fd, timeout_ms);
+
+			kts.tv_sec = timeout_ms / 1000;
+			kts.tv_nsec = (timeout_ms % 1000) * 1000000LL;
+			code = io_uring_wait_cqe_timeout(ring, &cqe, &kts);
+
+			mutex_lock(&sr_rec->ev_u.uring.sq_lock);
+			sr_rec->ev_u.uring.waiting = false;
+			mutex_unlock(&sr_rec->ev_u.uring.sq_lock);
+
+			/* interrupted, or the kernel is short of resources
+			 * for now (-EAGAIN, -EBUSY on CQ overflow): retry
+			 */
+			if (code < 0 && code != -ETIME && code != -EINTR
+			    && code != -EAGAIN && code != -EBUSY) {
+				__warnx(TIRPC_DEBUG_FLAG_WARN,
+					"%s: ring_fd %d wait failed (%d)",
+					__func__, ring->ring_fd, -code);
+				finished = true;
+				break;
+			}
+			n_events = svc_rqst_uring_reap(sr_rec);
+		}
+
+		if (unlikely(sr_rec->ev_flags & SVC_RQST_FLAG_SHUTDOWN)) {
+			__warnx(TIRPC_DEBUG_FLAG_SVC_RQST,
+				"%s: ring_fd %d wait shutdown (%d)",
+				__func__, ring->ring_fd, n_events);
+			finished = true;
+			break;
+		}
+		if (n_events > 0) {
+			__warnx(TIRPC_DEBUG_FLAG_SVC_RQST |
+				TIRPC_DEBUG_FLAG_REFCNT,
+				"%s: sr_rec %p evchan %d ev_refcnt %" PRId32
+				" ring_fd %d n_events %d",
+				__func__,
+				sr_rec, sr_rec->id_k, sr_rec->ev_refcnt,
+				ring->ring_fd, n_events);
+
+			atomic_add_uint32_t(&wakeups, n_events);
+			struct xdr_ioq *ioq;
+
+			ioq = svc_rqst_uring_events(sr_rec, n_events);
+
+			if (ioq != NULL) {
+				/* use this hot thread for the first event */
+				ioq->ioq_wpe.fun(&ioq->ioq_wpe);
+
+				/* failsafe idle processing after work task */
+				if (atomic_postclear_uint32_t_bits(
+					&wakeups, ~SVC_RQST_WAKEUPS)
+				    > SVC_RQST_WAKEUPS) {
+					svc_rqst_clean_idle(
+						__svc_params->idle_timeout);
+				}
+				finished = false;
+				break;
+			}
+			continue;
+		}
+
+		/* timed out (idle) */
+		__warnx(TIRPC_DEBUG_FLAG_SVC_RQST |
+			TIRPC_DEBUG_FLAG_REFCNT,
+			"%s: sr_rec %p evchan %d ev_refcnt %" PRId32
+			" ring_fd %d idle",
+			__func__,
+			sr_rec, sr_rec->id_k, sr_rec->ev_refcnt,
+			ring->ring_fd);
+		atomic_inc_uint32_t(&wakeups);
+	}
+	if (finished) {
+		__warnx(TIRPC_DEBUG_FLAG_SVC_RQST |
+			TIRPC_DEBUG_FLAG_REFCNT,
+			"%s: sr_rec %p evchan %d ev_refcnt %" PRId32
+			" ring_fd %d finished",
+			__func__,
+			sr_rec, sr_rec->id_k, sr_rec->ev_refcnt,
+			ring->ring_fd);
+
+		/* The ring itself is torn down by svc_rqst_rec_destroy(),
+		 * other threads may still be queueing rearms on it.
+		 */
+	}
+
+	svc_complete_task(sr_rec, finished);
+}
+#endif
+
 static void svc_complete_task(struct svc_rqst_rec *sr_rec, bool finished)
 {
 	if (finished) {
@@ -0,0 +1,639 @@
+/*
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ * 1. Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE AUTHOR `AS IS'' AND ANY EXPRESS OR
+ * IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES
+ * OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED.
+ * IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR ANY DIRECT, INDIRECT,
+ * INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT
+ * NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+ * DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+ * THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF
+ * THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+/*
+ * RPC-with-TLS (RFC 9289) for stream transports.
+ *
+ * A client asks for TLS with an AUTH_TLS NULL procedure call; the reply
+ * carries a STARTTLS verifier and the transport is marked for handshake.
+ * The handshake then runs on the non-blocking socket, in userspace, with
+ * OpenSSL, one step per receive (or send) event, so no worker waits on a
+ * slow client.  Record protection is then handed to the kernel (kTLS),
+ * so the rest of svc_vc, including the gathered sendmsg() of replies,
+ * keeps working on the plain socket and never copies data through a
+ * userspace cipher.  A transport where the kernel cannot take over both
+ * directions is closed rather than served in the clear.
+ *
+ * Records that are not application data still reach svc_vc: alerts and
+ * the client's KeyUpdate are read through svc_tls_recv(), which rekeys
+ * the kernel receive side from the client traffic secret kept for that.
+ */
+
+#include "config.h"
+
+#include <sys/types.h>
+#include <sys/socket.h>
+#include <sys/time.h>
+#include <errno.h>
+#include <stdio.h>
+#include <string.h>
+#include <time.h>
+#include <linux/tls.h>
+
+#include <openssl/ssl.h>
+#include <openssl/err.h>
+#include <openssl/evp.h>
+#include <openssl/kdf.h>
+
+#include <rpc/types.h>
+#include <misc/portable.h>
+#include <misc/timespec.h>
+#include <rpc/rpc.h>
+#include <rpc/svc.h>
+#include <rpc/svc_auth.h>
+
+#include "rpc_com.h"
+#include "svc_internal.h"
+#include "rpc_dplx_internal.h"
+
+/* seconds a client gets to complete the handshake */
+#define SVC_TLS_HANDSHAKE_TIMEOUT 10
+
+/* RFC 8446 record, handshake message and alert values */
+#define SVC_TLS_ALERT 21
+#define SVC_TLS_HANDSHAKE 22
+#define SVC_TLS_APPLICATION_DATA 23
+#define SVC_TLS_KEY_UPDATE 24
+#define SVC_TLS_ALERT_FATAL 2
+#define SVC_TLS_CLOSE_NOTIFY 0
+
+/* RFC 8446 cipher suites the kernel can take over */
+#define SVC_TLS_AES_128_GCM_SHA256 0x1301
+#define SVC_TLS_AES_256_GCM_SHA384 0x1302
+#define SVC_TLS_CHACHA20_POLY1305_SHA256 0x1303
+
+/* per-connection state, hung off rpc_dplx_rec */
+struct svc_tls_xprt {
+	SSL *ssl;			/**< only while handshaking */
+	struct timespec deadline;	/**< handshake must be done by then */
+	uint16_t cipher;		/**< negotiated suite */
+	uint16_t secret_len;
+	unsigned char rx_secret[EVP_MAX_MD_SIZE]; /**< client traffic secret */
+	bool send_hooked;		/**< handshake armed a send event */
+	unsigned char ctrl_type;	/**< type of the partial record */
+	uint16_t ctrl_len;
+	unsigned char ctrl[64];		/**< partial control record */
+};
+
+static const char svc_tls_starttls[] = "STARTTLS";
+
+/* ALPN protocol id, RFC 9289 section 8.2 */
+static const unsigned char svc_tls_alpn[] = "\x06sunrpc";
+
+static SSL_CTX *svc_tls_ctx;
+
+static void
+svc_tls_warn(const char *func, const char *what)
+{
+	char buf[256];
+	unsigned long e = ERR_get_error();
+
+	ERR_error_string_n(e, buf, sizeof(buf));
+	__warnx(TIRPC_DEBUG_FLAG_ERROR, "%s: %s: %s", func, what,
+		e ? buf : "no error queued");
+	ERR_clear_error();
+}
+
+/*
+ * The kernel is only given the current keys; a KeyUpdate from the client
+ * has to be answered with the next ones, derived from the client traffic
+ * secret.  OpenSSL hands that out through the key log callback.
+ */
+static void
+svc_tls_keylog_cb(const SSL *ssl, const char *line)
+{
+	static const char label[] = "CLIENT_TRAFFIC_SECRET_0 ";
+	struct svc_tls_xprt *tx = SSL_get_app_data(ssl);
+	const char *hex;
+	size_t i, n;
+
+	if (!tx || strncmp(line, label, sizeof(label) - 1))
+		return;
+
+	/* skip the client random */
+	hex = strchr(line + sizeof(label) - 1, ' ');
+	if (!hex)
+		return;
+	hex++;
+
+	n = strlen(hex) / 2;
+	if (n > sizeof(tx->rx_secret))
+		return;
+	for (i = 0; i < n; i++)
+		if (sscanf(hex + 2 * i, "%2hhx", &tx->rx_secret[i]) != 1)
+			return;
+	tx->secret_len = n;
+}
+
+static int
+svc_tls_alpn_cb(SSL *ssl, const unsigned char **out, unsigned char *outlen,
+		const unsigned char *in, unsigned int inlen, void *arg)
+{
+	if (SSL_select_next_proto((unsigned char **)out, outlen,
+				  svc_tls_alpn, sizeof(svc_tls_alpn) - 1,
+				  in, inlen) != OPENSSL_NPN_NEGOTIATED)
+		return SSL_TLSEXT_ERR_ALERT_FATAL;
+	return SSL_TLSEXT_ERR_OK;
+}
+
+/*
+ * Set up the server context.  Without a certificate and key, TLS stays
+ * disabled and AUTH_TLS probes are refused.
+ */
+bool
+svc_tls_init(const svc_init_params *params)
+{
+	SSL_CTX *ctx;
+
+	if (!params->tls_cert_file || !params->tls_key_file)
+		return true;
+
+	ctx = SSL_CTX_new(TLS_server_method());
+	if (!ctx) {
+		svc_tls_warn(__func__, "SSL_CTX_new failed");
+		return false;
+	}
+
+	/* RFC 9289 requires TLS 1.3.  No session tickets: they would be
+	 * sent after the handshake, when the kernel owns the records.
+	 */
+	if (!SSL_CTX_set_min_proto_version(ctx, TLS1_3_VERSION)
+	    || !SSL_CTX_set_num_tickets(ctx, 0)) {
+		svc_tls_warn(__func__, "TLS 1.3 not available");
+		goto fail;
+	}
+	SSL_CTX_set_options(ctx, SSL_OP_ENABLE_KTLS);
+	SSL_CTX_set_alpn_select_cb(ctx, svc_tls_alpn_cb, NULL);
+	SSL_CTX_set_keylog_callback(ctx, svc_tls_keylog_cb);
+
+	if (SSL_CTX_use_certificate_chain_file(ctx, params->tls_cert_file)
+	    != 1) {
+		svc_tls_warn(__func__, params->tls_cert_file);
+		goto fail;
+	}
+	if (SSL_CTX_use_PrivateKey_file(ctx, params->tls_key_file,
+					SSL_FILETYPE_PEM) != 1
+	    || SSL_CTX_check_private_key(ctx) != 1) {
+		svc_tls_warn(__func__, params->tls_key_file);
+		goto fail;
+	}
+
+	/* with a CA, clients must present a certificate it signed */
+	if (params->tls_ca_file) {
+		if (SSL_CTX_load_verify_locations(ctx, params->tls_ca_file,
+						  NULL) != 1) {
+			svc_tls_warn(__func__, params->tls_ca_file);
+			goto fail;
+		}
+		SSL_CTX_set_verify(ctx, SSL_VERIFY_PEER
+				   | SSL_VERIFY_FAIL_IF_NO_PEER_CERT, NULL);
+	}
+
+	svc_tls_ctx = ctx;
+	return true;
+
+fail:
+	SSL_CTX_free(ctx);
+	return false;
+}
+
+/*
+ * AUTH_TLS is only a probe: a NULL procedure on a stream transport that
+ * is not yet protected.  The reply verifier is AUTH_NONE with STARTTLS as
+ * its body; the handshake follows on the next receive.  The flag is set
+ * here, before the reply is sent, so that the client cannot start the
+ * handshake before svc_vc_recv() expects it.
+ */
+enum auth_stat
+_svcauth_tls(struct svc_req *req)
+{
+	SVCXPRT *xprt = req->rq_xprt;
+	struct opaque_auth *verf = &req->rq_msg.RPCM_ack.ar_verf;
+
+	if (!svc_tls_ctx
+	    || req->rq_msg.cb_proc != NULLPROC
+	    || xprt->xp_type != XPRT_TCP
+	    || (xprt->xp_flags & (SVC_XPRT_FLAG_TLS
+				  | SVC_XPRT_FLAG_TLS_HANDSHAKE)))
+		return (AUTH_BADCRED);
+
+	(void)_svcauth_none(req);
+
+	verf->oa_flavor = AUTH_NONE;
+	verf->oa_length = sizeof(svc_tls_starttls) - 1;
+	memcpy(verf->oa_body, svc_tls_starttls, verf->oa_length);
+
+	atomic_set_uint16_t_bits(&xprt->xp_flags, SVC_XPRT_FLAG_TLS_HANDSHAKE);
+	return (AUTH_OK);
+}
+
+
+static void
+svc_tls_handshake_end(SVCXPRT *xprt, struct svc_tls_xprt *tx)
+{
+	if (tx->send_hooked) {
+		svc_rqst_xprt_send_complete(xprt);
+		tx->send_hooked = false;
+	}
+
+	/* the kernel holds the keys now, the socket BIO does not close fd */
+	SSL_free(tx->ssl);
+	tx->ssl = NULL;
+
+	atomic_clear_uint16_t_bits(&xprt->xp_flags,
+				   SVC_XPRT_FLAG_TLS_HANDSHAKE);
+}
+
+/*
+ * Run one step of the server side of the handshake, and move the
+ * connection to kTLS once it completes.  Called from svc_vc_recv() on a
+ * work pool thread.  The socket stays non-blocking: when OpenSSL needs
+ * more from the client, the receive event is rearmed; when it cannot
+ * flush, a send event is armed, and svc_rqst routes it back here.  The
+ * whole handshake is bounded by SVC_TLS_HANDSHAKE_TIMEOUT.
+ *
+ * Returns false if the transport must be destroyed.
+ */
+bool
+svc_tls_accept(SVCXPRT *xprt)
+{
+	struct rpc_dplx_rec *rec = REC_XPRT(xprt);
+	struct svc_tls_xprt *tx = rec->tls;
+	struct timespec now;
+	int fd = xprt->xp_fd;
+	int rc;
+
+	(void)clock_gettime(CLOCK_MONOTONIC_FAST, &now);
+
+	if (!tx) {
+		tx = mem_zalloc(sizeof(*tx));
+		rec->tls = tx;
+		tx->deadline = now;
+		timespec_adds(&tx->deadline, SVC_TLS_HANDSHAKE_TIMEOUT);
+
+		tx->ssl = SSL_new(svc_tls_ctx);
+		if (!tx->ssl) {
+			svc_tls_warn(__func__, "SSL_new failed");
+			atomic_clear_uint16_t_bits(&xprt->xp_flags,
+						   SVC_XPRT_FLAG_TLS_HANDSHAKE);
+			return false;
+		}
+		SSL_set_app_data(tx->ssl, tx);
+		if (!SSL_set_fd(tx->ssl, fd)) {
+			svc_tls_warn(__func__, "SSL_set_fd failed");
+			goto fail;
+		}
+	} else if (timespeccmp(&now, &tx->deadline, >)) {
+		__warnx(TIRPC_DEBUG_FLAG_ERROR,
+			"%s: %p fd %d handshake timed out",
+			__func__, xprt, fd);
+		goto fail;
+	}
+
+	ERR_clear_error();
+	rc = SSL_accept(tx->ssl);
+	if (rc != 1) {
+		switch (SSL_get_error(tx->ssl, rc)) {
+		case SSL_ERROR_WANT_READ:
+			if (unlikely(svc_rqst_rearm_events(
+					xprt, SVC_XPRT_FLAG_ADDED_RECV)))
+				goto fail;
+			return true;
+		case SSL_ERROR_WANT_WRITE:
+			if (unlikely(svc_rqst_evchan_write(xprt, NULL,
+							   tx->send_hooked)))
+				goto fail;
+			tx->send_hooked = true;
+			return true;
+		default:
+			svc_tls_warn(__func__, "handshake failed");
+			goto fail;
+		}
+	}
+
+	if (!BIO_get_ktls_send(SSL_get_wbio(tx->ssl))
+	    || !BIO_get_ktls_recv(SSL_get_rbio(tx->ssl))) {
+		__warnx(TIRPC_DEBUG_FLAG_ERROR,
+			"%s: %p fd %d kernel TLS not available for %s",
+			__func__, xprt, fd, SSL_get_cipher_name(tx->ssl));
+		goto fail;
+	}
+	tx->cipher = SSL_CIPHER_get_protocol_id(
+					SSL_get_current_cipher(tx->ssl));
+
+	svc_tls_handshake_end(xprt, tx);
+	atomic_set_uint16_t_bits(&xprt->xp_flags, SVC_XPRT_FLAG_TLS);
+	__warnx(TIRPC_DEBUG_FLAG_SVC_VC,
+		"%s: %p fd %d TLS established",
+		__func__, xprt, fd);
+
+	return !svc_rqst_rearm_events(xprt, SVC_XPRT_FLAG_ADDED_RECV);
+
+fail:
+	svc_tls_handshake_end(xprt, tx);
+	return false;
+}
+
+/*
+ * HKDF-Expand-Label from RFC 8446 section 7.1, with an empty context.
+ */
+static bool
+svc_tls_expand_label(const EVP_MD *md, const unsigned char *secret,
+		     size_t secret_len, const char *label,
+		     unsigned char *out, size_t out_len)
+{
+	static const char prefix[] = "tls13 ";
+	unsigned char info[2 + 1 + 255 + 1];
+	size_t plen = sizeof(prefix) - 1;
+	size_t llen = strlen(label);
+	EVP_PKEY_CTX *pctx;
+	bool ok;
+
+	info[0] = out_len >> 8;
+	info[1] = out_len & 0xff;
+	info[2] = plen + llen;
+	memcpy(&info[3], prefix, plen);
+	memcpy(&info[3 + plen], label, llen);
+	info[3 + plen + llen] = 0;
+
+	pctx = EVP_PKEY_CTX_new_id(EVP_PKEY_HKDF, NULL);
+	if (!pctx)
+		return false;
+
+	ok = EVP_PKEY_derive_init(pctx) > 0
+	  && EVP_PKEY_CTX_set_hkdf_mode(pctx,
+				EVP_PKEY_HKDEF_MODE_EXPAND_ONLY) > 0
+	  && EVP_PKEY_CTX_set_hkdf_md(pctx, md) > 0
+	  && EVP_PKEY_CTX_set1_hkdf_key(pctx, secret, secret_len) > 0
+	  && EVP_PKEY_CTX_add1_hkdf_info(pctx, info, 4 + plen + llen) > 0
+	  && EVP_PKEY_derive(pctx, out, &out_len) > 0;
+
+	EVP_PKEY_CTX_free(pctx);
+	return ok;
+}
+
+/*
+ * The client sent KeyUpdate: step the client traffic secret and give
+ * the kernel the new receive key.  Record sequence numbers restart at 0.
+ */
+static bool
+svc_tls_update_rx(SVCXPRT *xprt, struct svc_tls_xprt *tx)
+{
+	union {
+		struct tls12_crypto_info_aes_gcm_128 aes128;
+		struct tls12_crypto_info_aes_gcm_256 aes256;
+		struct tls12_crypto_info_chacha20_poly1305 chacha;
+	} ci;
+	unsigned char secret[EVP_MAX_MD_SIZE];
+	unsigned char key[32];
+	unsigned char iv[12];
+	const EVP_MD *md;
+	size_t key_len;
+	socklen_t ci_len;
+	bool ok = false;
+
+	switch (tx->cipher) {
+	case SVC_TLS_AES_128_GCM_SHA256:
+		md = EVP_sha256();
+		key_len = TLS_CIPHER_AES_GCM_128_KEY_SIZE;
+		break;
+	case SVC_TLS_AES_256_GCM_SHA384:
+		md = EVP_sha384();
+		key_len = TLS_CIPHER_AES_GCM_256_KEY_SIZE;
+		break;
+	case SVC_TLS_CHACHA20_POLY1305_SHA256:
+		md = EVP_sha256();
+		key_len = TLS_CIPHER_CHACHA20_POLY1305_KEY_SIZE;
+		break;
+	default:
+		__warnx(TIRPC_DEBUG_FLAG_ERROR,
+			"%s: %p fd %d no rekey for cipher %04x",
+			__func__, xprt, xprt->xp_fd, tx->cipher);
+		return false;
+	}
+
+	if (!tx->secret_len
+	    || !svc_tls_expand_label(md, tx->rx_secret, tx->secret_len,
+				     "traffic upd", secret, tx->secret_len)
+	    || !svc_tls_expand_label(md, secret, tx->secret_len,
+				     "key", key, key_len)
+	    || !svc_tls_expand_label(md, secret, tx->secret_len,
+				     "iv", iv, sizeof(iv))) {
+		svc_tls_warn(__func__, "key derivation failed");
+		goto out;
+	}
+
+	memset(&ci, 0, sizeof(ci));
+	switch (tx->cipher) {
+	case SVC_TLS_AES_128_GCM_SHA256:
+		ci.aes128.info.version = TLS_1_3_VERSION;
+		ci.aes128.info.cipher_type = TLS_CIPHER_AES_GCM_128;
+		memcpy(ci.aes128.key, key, key_len);
+		memcpy(ci.aes128.salt, iv, TLS_CIPHER_AES_GCM_128_SALT_SIZE);
+		memcpy(ci.aes128.iv, iv + TLS_CIPHER_AES_GCM_128_SALT_SIZE,
+		       TLS_CIPHER_AES_GCM_128_IV_SIZE);
+		ci_len = sizeof(ci.aes128);
+		break;
+	case SVC_TLS_AES_256_GCM_SHA384:
+		ci.aes256.info.version = TLS_1_3_VERSION;
+		ci.aes256.info.cipher_type = TLS_CIPHER_AES_GCM_256;
+		memcpy(ci.aes256.key, key, key_len);
+		memcpy(ci.aes256.salt, iv, TLS_CIPHER_AES_GCM_256_SALT_SIZE);
+		memcpy(ci.aes256.iv, iv + TLS_CIPHER_AES_GCM_256_SALT_SIZE,
+		       TLS_CIPHER_AES_GCM_256_IV_SIZE);
+		ci_len = sizeof(ci.aes256);
+		break;
+	default:
+		ci.chacha.info.version = TLS_1_3_VERSION;
+		ci.chacha.info.cipher_type = TLS_CIPHER_CHACHA20_POLY1305;
+		memcpy(ci.chacha.key, key, key_len);
+		memcpy(ci.chacha.iv, iv, sizeof(iv));
+		ci_len = sizeof(ci.chacha);
+		break;
+	}
+
+	if (setsockopt(xprt->xp_fd, SOL_TLS, TLS_RX, &ci, ci_len) < 0) {
+		__warnx(TIRPC_DEBUG_FLAG_ERROR,
+			"%s: %p fd %d kernel refused the new key (%d)",
+			__func__, xprt, xprt->xp_fd, errno);
+		goto out;
+	}
+
+	memcpy(tx->rx_secret, secret, tx->secret_len);
+	ok = true;
+	__warnx(TIRPC_DEBUG_FLAG_SVC_VC,
+		"%s: %p fd %d receive key updated",
+		__func__, xprt, xprt->xp_fd);
+out:
+	OPENSSL_cleanse(&ci, sizeof(ci));
+	OPENSSL_cleanse(secret, sizeof(secret));
+	OPENSSL_cleanse(key, sizeof(key));
+	OPENSSL_cleanse(iv, sizeof(iv));
+	return ok;
+}
+
+/*
+ * Handle a (possibly partial) record that is not application data.
+ * Returns 1 to keep reading, 0 when the peer closed, -1 on error.
+ */
+static int
+svc_tls_control(SVCXPRT *xprt, struct svc_tls_xprt *tx, unsigned char type,
+		const void *data, size_t len)
+{
+	size_t mlen;
+
+	if ((tx->ctrl_len && tx->ctrl_type != type)
+	    || len > sizeof(tx->ctrl) - tx->ctrl_len) {
+		errno = EPROTO;
+		return -1;
+	}
+	tx->ctrl_type = type;
+	memcpy(tx->ctrl + tx->ctrl_len, data, len);
+	tx->ctrl_len += len;
+
+	for (;;) {
+		switch (type) {
+		case SVC_TLS_ALERT:
+			if (tx->ctrl_len < 2)
+				return 1;
+			/* close_notify, or any fatal alert, ends it */
+			if (tx->ctrl[1] == SVC_TLS_CLOSE_NOTIFY
+			    || tx->ctrl[0] == SVC_TLS_ALERT_FATAL) {
+				__warnx(TIRPC_DEBUG_FLAG_SVC_VC,
+					"%s: %p fd %d alert %u level %u",
+					__func__, xprt, xprt->xp_fd,
+					tx->ctrl[1], tx->ctrl[0]);
+				return 0;
+			}
+			mlen = 2;
+			break;
+		case SVC_TLS_HANDSHAKE:
+			if (tx->ctrl_len < 4)
+				return 1;
+			mlen = 4 + ((tx->ctrl[1] << 16) | (tx->ctrl[2] << 8)
+				    | tx->ctrl[3]);
+			if (mlen > sizeof(tx->ctrl)) {
+				errno = EPROTO;
+				return -1;
+			}
+			if (tx->ctrl_len < mlen)
+				return 1;
+			if (tx->ctrl[0] != SVC_TLS_KEY_UPDATE || mlen != 5) {
+				__warnx(TIRPC_DEBUG_FLAG_ERROR,
+					"%s: %p fd %d unexpected handshake message %u",
+					__func__, xprt, xprt->xp_fd,
+					tx->ctrl[0]);
+				errno = EPROTO;
+				return -1;
+			}
+			if (!svc_tls_update_rx(xprt, tx)) {
+				errno = EPROTO;
+				return -1;
+			}
+			/* Answering would need our own KeyUpdate queued in
+			 * order with replies on the unlocked send path.
+			 */
+			if (tx->ctrl[4]) {
+				__warnx(TIRPC_DEBUG_FLAG_ERROR,
+					"%s: %p fd %d peer requested a send key update",
+					__func__, xprt, xprt->xp_fd);
+				errno = ECONNABORTED;
+				return -1;
+			}
+			break;
+		default:
+			__warnx(TIRPC_DEBUG_FLAG_ERROR,
+				"%s: %p fd %d unexpected record type %u",
+				__func__, xprt, xprt->xp_fd, type);
+			errno = EPROTO;
+			return -1;
+		}
+
+		tx->ctrl_len -= mlen;
+		if (!tx->ctrl_len)
+			return 1;
+		memmove(tx->ctrl, tx->ctrl + mlen, tx->ctrl_len);
+	}
+}
+
+/*
+ * recv() for a kTLS socket.  A plain recv() fails with EIO when the next
+ * record is not application data, as for an alert or a KeyUpdate, so read
+ * with the record type as ancillary data and deal with those here.  The
+ * result is that of recv(): a close_notify or a fatal alert reads as EOF.
+ */
+ssize_t
+svc_tls_recv(SVCXPRT *xprt, void *buf, size_t len, int flags)
+{
+	struct svc_tls_xprt *tx = REC_XPRT(xprt)->tls;
+	char cbuf[CMSG_SPACE(sizeof(unsigned char))];
+	struct cmsghdr *cmsg;
+	struct msghdr msg;
+	struct iovec iov;
+	unsigned char type;
+	ssize_t rlen;
+	int rc;
+
+	for (;;) {
+		iov.iov_base = buf;
+		iov.iov_len = len;
+		memset(&msg, 0, sizeof(msg));
+		msg.msg_iov = &iov;
+		msg.msg_iovlen = 1;
+		msg.msg_control = cbuf;
+		msg.msg_controllen = sizeof(cbuf);
+
+		rlen = recvmsg(xprt->xp_fd, &msg, flags);
+		if (rlen <= 0)
+			return rlen;
+
+		cmsg = CMSG_FIRSTHDR(&msg);
+		if (!cmsg
+		    || cmsg->cmsg_level != SOL_TLS
+		    || cmsg->cmsg_type != TLS_GET_RECORD_TYPE)
+			return rlen;
+
+		type = *(unsigned char *)CMSG_DATA(cmsg);
+		if (type == SVC_TLS_APPLICATION_DATA)
+			return rlen;
+
+		rc = svc_tls_control(xprt, tx, type, buf, rlen);
+		if (rc <= 0)
+			return rc;
+	}
+}
+
+void
+svc_tls_destroy(SVCXPRT *xprt)
+{
+	struct rpc_dplx_rec *rec = REC_XPRT(xprt);
+	struct svc_tls_xprt *tx = rec->tls;
+
+	if (!tx)
+		return;
+
+	if (tx->ssl)
+		SSL_free(tx->ssl);
+	OPENSSL_cleanse(tx, sizeof(*tx));
+	mem_free(tx, sizeof(*tx));
+	rec->tls = NULL;
+}
@@ -434,6 +434,10 @@ svc_vc_rendezvous(SVCXPRT *xprt)
 #if defined(TIRPC_EPOLL)
 			case SVC_EVENT_EPOLL:
 				break;
+#endif
+#if defined(TIRPC_IO_URING)
+			case SVC_EVENT_URING:
+				break;
 #endif
 			default:
 				abort();	/* XXX */
@@ -564,6 +568,10 @@ svc_vc_destroy_task(struct work_pool_entry *wpe)
 	if (rec->xprt.xp_ops->xp_free_user_data)
 		rec->xprt.xp_ops->xp_free_user_data(&rec->xprt);
 
+#if defined(TIRPC_TLS)
+	svc_tls_destroy(&rec->xprt);
+#endif
+
 	if (rec->xprt.xp_tp)
 		mem_free(rec->xprt.xp_tp, 0);
 	if (rec->xprt.xp_netid)
@@ -669,6 +677,20 @@ svc_vc_stat(SVCXPRT *xprt)
 	return (XPRT_IDLE);
 }
 
+/*
+ * Under kTLS, a plain recv() fails with EIO when the next record is an
+ * alert or a post-handshake message; svc_tls_recv() takes care of those.
+ */
+static inline ssize_t
+svc_vc_read(SVCXPRT *xprt, void *buf, size_t len, int flags)
+{
+#if defined(TIRPC_TLS)
+	if (xprt->xp_flags & SVC_XPRT_FLAG_TLS)
+		return svc_tls_recv(xprt, buf, len, flags);
+#endif
+	return recv(xprt->xp_fd, buf, len, flags);
+}
+
 static enum xprt_stat
 svc_vc_recv(SVCXPRT *xprt)
 {
@@ -689,10 +711,21 @@ svc_vc_recv(SVCXPRT *xprt)
 	/* no need for locking, only one svc_rqst_xprt_task() per event.
 	 * depends upon svc_rqst_rearm_events() for ordering.
 	 */
+#if defined(TIRPC_TLS)
+	if (unlikely(xprt->xp_flags & SVC_XPRT_FLAG_TLS_HANDSHAKE)) {
+		/* the STARTTLS reply went out, carry on with the handshake */
+		if (!svc_tls_accept(xprt))
+			SVC_DESTROY(xprt);
+		return SVC_STAT(xprt);
+	}
+#endif
+
 	have = TAILQ_LAST(&rec->ioq.ioq_uv.uvqh.qh, poolq_head_s);
 	if (!have) {
 		xioq = xdr_ioq_create(xd->sx_dr.pagesz, xd->sx_dr.maxrec,
 				      UIO_FLAG_BUFQ);
+		/* the record is kept until the request is freed */
+		xioq->xdrs[0].x_flags |= XDR_FLAG_INPLACE;
 		(rec->ioq.ioq_uv.uvqh.qcount)++;
 		TAILQ_INSERT_TAIL(&rec->ioq.ioq_uv.uvqh.qh, &xioq->ioq_s, q);
 	} else {
@@ -702,8 +735,8 @@ svc_vc_recv(SVCXPRT *xprt)
 	if (!xd->sx_fbtbc) {
 again:
 
-		rlen = recv(xprt->xp_fd, &xd->sx_fbtbc, BYTES_PER_XDR_UNIT,
-			    hap_again ? MSG_DONTWAIT : MSG_WAITALL);
+		rlen = svc_vc_read(xprt, &xd->sx_fbtbc, BYTES_PER_XDR_UNIT,
+				   hap_again ? MSG_DONTWAIT : MSG_WAITALL);
 
 		if (unlikely(rlen < 0)) {
 			code = errno;
@@ -913,7 +946,7 @@ again:
 		flags = uv->u.uio_flags;
 	}
 
-	rlen = recv(xprt->xp_fd, uv->v.vio_tail, xd->sx_fbtbc, MSG_DONTWAIT);
+	rlen = svc_vc_read(xprt, uv->v.vio_tail, xd->sx_fbtbc, MSG_DONTWAIT);
 
 	if (unlikely(rlen < 0)) {
 		code = errno;
@@ -997,7 +1030,10 @@ again:
 	TAILQ_REMOVE(&rec->ioq.ioq_uv.uvqh.qh, &xioq->ioq_s, q);
 	xdr_ioq_reset(xioq, 0);
 
-	if (unlikely(svc_rqst_rearm_events(xprt, SVC_XPRT_FLAG_ADDED_RECV))) {
+	/* when blocked, receive is rearmed as a request in flight finishes */
+	if (!svc_rqst_recv_blocked(xprt)
+	    && unlikely(svc_rqst_rearm_events(xprt,
+					      SVC_XPRT_FLAG_ADDED_RECV))) {
 		__warnx(TIRPC_DEBUG_FLAG_ERROR,
 			"%s: %p fd %d svc_rqst_rearm_events failed (will set dead)",
 			__func__, xprt, xprt->xp_fd);
@@ -33,6 +33,15 @@
  *
  * This provides simple work queues using pthreads and TAILQ primitives.
  *
+ * Work and idle workers are kept per CPU (struct work_pool_shard).  A
+ * submission goes to the shard of the submitting CPU and wakes a worker
+ * idle there if there is one, so in the common case only that shard's
+ * mutex is taken.  Otherwise a worker idle on another CPU is woken, and it
+ * steals the entry.  The pool-wide n_idle and n_queued counters close the
+ * race between a submitter finding no idle worker and a worker finding no
+ * work: the submitter bumps n_queued before looking at n_idle, the worker
+ * bumps n_idle before looking at n_queued.
+ *
  * @note    Loosely based upon previous thrdpool by
  *          Matt Benjamin <matt@cohortfs.com>
  */
@@ -57,6 +66,8 @@
 #include <intrinsic.h>
 #include <urcu-bp.h>
 #include <assert.h>
+#include <sched.h>
+#include <unistd.h>
 
 #include <rpc/work_pool.h>
 
@@ -67,15 +78,29 @@
 
 static int work_pool_spawn(struct work_pool *pool);
 
+static inline struct work_pool_shard *
+work_pool_shard_of(struct work_pool *pool)
+{
+	int cpu = 0;
+
+#if defined(__linux__)
+	cpu = sched_getcpu();
+	if (unlikely(cpu < 0))
+		cpu = 0;
+#endif
+	return &pool->shards[cpu % pool->n_shards];
+}
+
 int
 work_pool_init(struct work_pool *pool, const char *name,
 		struct work_pool_params *params)
 {
+	long ncpu = sysconf(_SC_NPROCESSORS_CONF);
+	uint32_t ix;
 	int rc;
 
 	memset(pool, 0, sizeof(*pool));
 	poolq_head_setup(&pool->pqh);
-	TAILQ_INIT(&pool->wptqh);
 
 	pool->timeout_ms = WORK_POOL_TIMEOUT_MS;
 
@@ -96,6 +121,17 @@ work_pool_init(struct work_pool *pool, const char *name,
 		pool->params.thrd_max = pool->params.thrd_min;
 	};
 
+	/* No point in more shards than workers */
+	pool->n_shards = (ncpu < 1) ? 1 : ncpu;
+	if (pool->n_shards > pool->params.thrd_max)
+		pool->n_shards = pool->params.thrd_max;
+
+	pool->shards = mem_calloc(pool->n_shards, sizeof(*pool->shards));
+	for (ix = 0; ix < pool->n_shards; ix++) {
+		poolq_head_setup(&pool->shards[ix].pqh);
+		TAILQ_INIT(&pool->shards[ix].wptqh);
+	}
+
 	rc = pthread_attr_init(&pool->attr);
 	if (rc) {
 		__warnx(TIRPC_DEBUG_FLAG_ERROR,
@@ -132,11 +168,97 @@ work_pool_init(struct work_pool *pool, const char *name,
 	return work_pool_spawn(pool);
 }
 
+/**
+ * @brief Take the first entry queued on a shard
+ *
+ * @note The caller holds the shard mutex.
+ */
+static inline struct poolq_entry *
+work_pool_take(struct work_pool *pool, struct work_pool_shard *shard)
+{
+	struct poolq_entry *have = TAILQ_FIRST(&shard->pqh.qh);
+
+	if (have) {
+		TAILQ_REMOVE(&shard->pqh.qh, have, q);
+		atomic_dec_uint32_t(&pool->n_queued);
+	}
+	return (have);
+}
+
+/**
+ * @brief Take an entry queued on some other shard
+ *
+ * @note The caller does not hold any shard mutex.
+ */
+static struct poolq_entry *
+work_pool_steal(struct work_pool *pool, struct work_pool_shard *home)
+{
+	struct work_pool_shard *shard;
+	struct poolq_entry *have;
+	uint32_t start = home - pool->shards;
+	uint32_t ix;
+
+	for (ix = 1; ix < pool->n_shards
+		     && atomic_fetch_uint32_t(&pool->n_queued); ix++) {
+		shard = &pool->shards[(start + ix) % pool->n_shards];
+
+		/* unlocked peek, only a hint */
+		if (TAILQ_EMPTY(&shard->pqh.qh))
+			continue;
+
+		pthread_mutex_lock(&shard->pqh.qmutex);
+		have = work_pool_take(pool, shard);
+		pthread_mutex_unlock(&shard->pqh.qmutex);
+
+		if (have)
+			return (have);
+	}
+	return (NULL);
+}
+
+/**
+ * @brief Remove an idle worker from its shard
+ *
+ * @note The caller holds the shard mutex.
+ */
+static inline void
+work_pool_unpark(struct work_pool *pool, struct work_pool_thread *wpt)
+{
+	wpt->shard->pqh.qcount--;
+	TAILQ_REMOVE(&wpt->shard->wptqh, wpt, wptq);
+	atomic_dec_uint32_t(&pool->n_idle);
+}
+
+/**
+ * @brief Add another worker if the pool is running short of idle ones
+ */
+static inline void
+work_pool_grow(struct work_pool *pool)
+{
+	bool spawn;
+
+	if (atomic_fetch_uint32_t(&pool->n_idle) >= pool->params.thrd_min
+	 || atomic_fetch_uint32_t(&pool->n_threads) >= pool->params.thrd_max)
+		return;
+
+	pthread_mutex_lock(&pool->pqh.qmutex);
+	spawn = pool->n_threads < pool->params.thrd_max;
+	if (spawn)
+		pool->n_threads++;
+	pthread_mutex_unlock(&pool->pqh.qmutex);
+
+	if (spawn) {
+		/* busy, so dynamically add another thread */
+		(void)work_pool_spawn(pool);
+	}
+}
+
 /**
  * @brief The worker thread
  *
  * This is the body of the worker thread. The argument is a pointer to
- * its working context, kept in a list for each pool.
+ * its working context.  While idle, it is kept in the list of the shard of
+ * the CPU it last ran on.
  *
  * @param[in] arg 	thread context
  */
@@ -146,51 +268,54 @@ work_pool_thread(void *arg)
 {
 	struct work_pool_thread *wpt = arg;
 	struct work_pool *pool = wpt->pool;
+	struct work_pool_shard *shard;
 	struct poolq_entry *have;
 	struct timespec ts;
 	int rc;
-	bool spawn;
 
 	rcu_register_thread();
 
 	pthread_cond_init(&wpt->pqcond, NULL);
-	pthread_mutex_lock(&pool->pqh.qmutex);
 
 	wpt->worker_index = atomic_inc_uint32_t(&pool->worker_index);
 	snprintf(wpt->worker_name, sizeof(wpt->worker_name), "%.5s%" PRIu32,
 		 pool->name, wpt->worker_index);
 	__ntirpc_pkg_params.thread_name_(wpt->worker_name);
 
+	shard = work_pool_shard_of(pool);
+	pthread_mutex_lock(&shard->pqh.qmutex);
+
 	do {
 		/* testing at top of loop allows pre-specification of work,
 		 * and thread termination after timeout with no work (below).
 		 */
 		if (wpt->work) {
 			wpt->work->wpt = wpt;
-			spawn = pool->pqh.qcount < pool->params.thrd_min
-			      && pool->n_threads < pool->params.thrd_max;
-			if (spawn)
-				pool->n_threads++;
-			pthread_mutex_unlock(&pool->pqh.qmutex);
+			pthread_mutex_unlock(&shard->pqh.qmutex);
 
-			if (spawn) {
-				/* busy, so dynamically add another thread */
-				(void)work_pool_spawn(pool);
-			}
+			work_pool_grow(pool);
 
 			__warnx(TIRPC_DEBUG_FLAG_WORKER,
 				"%s() %s task %p",
 				__func__, wpt->worker_name, wpt->work);
 			wpt->work->fun(wpt->work);
 			wpt->work = NULL;
-			pthread_mutex_lock(&pool->pqh.qmutex);
+
+			/* we may have been migrated while working */
+			shard = work_pool_shard_of(pool);
+			pthread_mutex_lock(&shard->pqh.qmutex);
 		}
 		/*
-		 * Check for any queued work to avoid scheduling.
+		 * Check for any queued work to avoid scheduling,
+		 * locally first, then on the other CPUs.
 		 */
-		have = TAILQ_FIRST(&pool->pqh.qh);
+		have = work_pool_take(pool, shard);
+		if (!have && atomic_fetch_uint32_t(&pool->n_queued)) {
+			pthread_mutex_unlock(&shard->pqh.qmutex);
+			have = work_pool_steal(pool, shard);
+			pthread_mutex_lock(&shard->pqh.qmutex);
+		}
 		if (have) {
-			TAILQ_REMOVE(&pool->pqh.qh, have, q);
 			wpt->work = (struct work_pool_entry *)have;
 			continue;
 		}
@@ -198,8 +323,20 @@ work_pool_thread(void *arg)
 		/*
 		 * Add myself to waiting queue.
 		 */
-		pool->pqh.qcount++;
-		TAILQ_INSERT_TAIL(&pool->wptqh, wpt, wptq);
+		shard->pqh.qcount++;
+		TAILQ_INSERT_TAIL(&shard->wptqh, wpt, wptq);
+		wpt->shard = shard;
+		wpt->wakeup = false;
+		atomic_inc_uint32_t(&pool->n_idle);
+
+		/*
+		 * Work may have been queued on another shard after we looked,
+		 * by a submitter that did not see us idle yet.
+		 */
+		if (atomic_fetch_uint32_t(&pool->n_queued)) {
+			work_pool_unpark(pool, wpt);
+			continue;
+		}
 
 		__warnx(TIRPC_DEBUG_FLAG_WORKER,
 			"%s() %s waiting",
@@ -208,13 +345,11 @@ work_pool_thread(void *arg)
 		clock_gettime(CLOCK_REALTIME_FAST, &ts);
 		timespec_addms(&ts, pool->timeout_ms);
 
-		wpt->wakeup = false;
-
-		/* Note: the mutex is the pool _head,
+		/* Note: the mutex is the shard _head,
 		 * but the condition is per worker,
 		 * making the signal efficient!
 		 */
-		rc = pthread_cond_timedwait(&wpt->pqcond, &pool->pqh.qmutex,
+		rc = pthread_cond_timedwait(&wpt->pqcond, &shard->pqh.qmutex,
 					    &ts);
 
 		/*
@@ -232,8 +367,7 @@ work_pool_thread(void *arg)
 		 * it will try to wakeup me.
 		 */
 		if (!wpt->wakeup) {
-			pool->pqh.qcount--;
-			TAILQ_REMOVE(&pool->wptqh, wpt, wptq);
+			work_pool_unpark(pool, wpt);
 		} else {
 			continue;
 		}
@@ -245,8 +379,11 @@ work_pool_thread(void *arg)
 			break;
 		}
 	} while (wpt->work || wpt->wakeup ||
-		 pool->pqh.qcount < pool->params.thrd_min);
+		 atomic_fetch_uint32_t(&pool->n_idle) < pool->params.thrd_min);
 
+	pthread_mutex_unlock(&shard->pqh.qmutex);
+
+	pthread_mutex_lock(&pool->pqh.qmutex);
 	pool->n_threads--;
 	pthread_mutex_unlock(&pool->pqh.qmutex);
 
@@ -279,9 +416,32 @@ work_pool_spawn(struct work_pool *pool)
 	return (0);
 }
 
+/**
+ * @brief Wake an idle worker of a shard, if any
+ *
+ * @note The caller holds the shard mutex.
+ */
+static inline bool
+work_pool_wake(struct work_pool *pool, struct work_pool_shard *shard)
+{
+	struct work_pool_thread *wpt = TAILQ_LAST(&shard->wptqh, work_pool_s);
+
+	if (!wpt)
+		return (false);
+
+	work_pool_unpark(pool, wpt);
+	assert(!wpt->wakeup);
+	wpt->wakeup = true;
+	pthread_cond_signal(&wpt->pqcond);
+	return (true);
+}
+
 int
 work_pool_submit(struct work_pool *pool, struct work_pool_entry *work)
 {
+	struct work_pool_shard *shard;
+	uint32_t start, ix;
+	bool woken;
 	int rc = 0;
 
 	if (unlikely(!pool->params.thrd_max)) {
@@ -289,23 +449,39 @@ work_pool_submit(struct work_pool *pool, struct work_pool_entry *work)
 		return (0);
 	}
 
-	pthread_mutex_lock(&pool->pqh.qmutex);
+	shard = work_pool_shard_of(pool);
+	pthread_mutex_lock(&shard->pqh.qmutex);
 	/*
 	 * Insert in work queue so that running thread can
 	 * pickup without scheduling.
 	 */
-	TAILQ_INSERT_TAIL(&pool->pqh.qh, &work->pqe, q);
-	struct work_pool_thread *wpt = TAILQ_LAST(&pool->wptqh, work_pool_s);
-	if (wpt) {
-		pool->pqh.qcount--;
-		TAILQ_REMOVE(&pool->wptqh, wpt, wptq);
-		assert(!wpt->wakeup);
-		wpt->wakeup = true;
-		pthread_cond_signal(&wpt->pqcond);
-	} else {
-		assert(pool->pqh.qcount == 0);
+	TAILQ_INSERT_TAIL(&shard->pqh.qh, &work->pqe, q);
+	atomic_inc_uint32_t(&pool->n_queued);
+	woken = work_pool_wake(pool, shard);
+	pthread_mutex_unlock(&shard->pqh.qmutex);
+
+	if (woken || !atomic_fetch_uint32_t(&pool->n_idle))
+		return rc;
+
+	/*
+	 * Nobody idle on this CPU, wake a worker idle elsewhere,
+	 * it will steal the entry.
+	 */
+	start = shard - pool->shards;
+	for (ix = 1; ix < pool->n_shards; ix++) {
+		shard = &pool->shards[(start + ix) % pool->n_shards];
+
+		/* unlocked peek, only a hint */
+		if (!shard->pqh.qcount)
+			continue;
+
+		pthread_mutex_lock(&shard->pqh.qmutex);
+		woken = work_pool_wake(pool, shard);
+		pthread_mutex_unlock(&shard->pqh.qmutex);
+
+		if (woken)
+			break;
 	}
-	pthread_mutex_unlock(&pool->pqh.qmutex);
 	return rc;
 }
 
@@ -317,18 +493,27 @@ work_pool_shutdown(struct work_pool *pool)
 		.tv_sec = 0,
 		.tv_nsec = 3000,
 	};
+	uint32_t ix;
 
 	pthread_mutex_lock(&pool->pqh.qmutex);
 	pool->timeout_ms = 1;
 	pool->params.thrd_max =
 	pool->params.thrd_min = 0;
+	pthread_mutex_unlock(&pool->pqh.qmutex);
+
+	for (ix = 0; ix < pool->n_shards; ix++) {
+		struct work_pool_shard *shard = &pool->shards[ix];
 
-	wpt = TAILQ_FIRST(&pool->wptqh);
-	while (wpt) {
-		pthread_cond_signal(&wpt->pqcond);
-		wpt = TAILQ_NEXT(wpt, wptq);
+		pthread_mutex_lock(&shard->pqh.qmutex);
+		wpt = TAILQ_FIRST(&shard->wptqh);
+		while (wpt) {
+			pthread_cond_signal(&wpt->pqcond);
+			wpt = TAILQ_NEXT(wpt, wptq);
+		}
+		pthread_mutex_unlock(&shard->pqh.qmutex);
 	}
 
+	pthread_mutex_lock(&pool->pqh.qmutex);
 	while (pool->n_threads > 0) {
 		pthread_mutex_unlock(&pool->pqh.qmutex);
 		__warnx(TIRPC_DEBUG_FLAG_WORKER,
@@ -339,6 +524,10 @@ work_pool_shutdown(struct work_pool *pool)
 	}
 	pthread_mutex_unlock(&pool->pqh.qmutex);
 
+	for (ix = 0; ix < pool->n_shards; ix++)
+		poolq_head_destroy(&pool->shards[ix].pqh);
+	mem_free(pool->shards, pool->n_shards * sizeof(*pool->shards));
+
 	mem_free(pool->name, 0);
 	poolq_head_destroy(&pool->pqh);
 
@@ -57,17 +57,292 @@
 
 static uint64_t next_id;
 
-#if 0				/* jemalloc docs warn about reclaim */
-#define alloc_buffer(size) mem_aligned(0x8, (size))
-#else
-#define alloc_buffer(size) mem_alloc((size))
-#endif				/* 0 */
-#define free_buffer(addr,size) mem_free((addr), size)
+/*
+ * Buffer and header caches.
+ *
+ * Each RPC allocates a receive buffer, a reply buffer, their xdr_ioq and
+ * xdr_ioq_uv headers, and frees them again, usually on another thread.
+ * Objects are cached per thread in magazines of one size class; whole
+ * magazines are exchanged with a global depot, so neither the depot lock
+ * nor the allocator is touched for most allocations.
+ *
+ * Buffers are classed by powers of two from 4 KiB to 1 MiB.  Larger
+ * buffers go straight to the allocator.
+ *
+ * A magazine that can hold objects (loaded in a thread, or full in the
+ * depot) is charged its capacity in bytes against IOQ_CACHE_BYTES, however
+ * many threads there are.  When a thread cannot charge a fresh magazine,
+ * it frees to the allocator instead.  Empty depot magazines are uncharged.
+ */
+#define IOQ_CLASS_MIN_SHIFT	12
+#define IOQ_BUF_CLASSES		9
+#define IOQ_CLASS_UV		(IOQ_BUF_CLASSES)	/* xdr_ioq_uv */
+#define IOQ_CLASS_IOQ		(IOQ_BUF_CLASSES + 1)	/* xdr_ioq */
+#define IOQ_CLASSES		(IOQ_BUF_CLASSES + 2)
+
+#define IOQ_MAG_ROUNDS		32
+#define IOQ_MAG_BYTES		(1024 * 1024)	/* bound for large classes */
+#define IOQ_DEPOT_MAX		16	/* full magazines kept per class */
+#define IOQ_CACHE_BYTES		(64 * 1024 * 1024)	/* whole process */
+
+struct ioq_mag {
+	struct ioq_mag *next;
+	u_int rounds;
+	void *round[IOQ_MAG_ROUNDS];
+};
+
+struct ioq_depot {
+	mutex_t mtx;
+	struct ioq_mag *full;
+	struct ioq_mag *empty;
+	u_int n_full;
+	u_int capacity;		/* rounds per magazine */
+	size_t size;		/* object size */
+	CACHE_PAD(0);
+};
+
+struct ioq_cache {
+	struct ioq_mag *mag[IOQ_CLASSES];
+};
+
+static struct ioq_depot ioq_depot[IOQ_CLASSES];
+static pthread_once_t ioq_cache_once = PTHREAD_ONCE_INIT;
+static pthread_key_t ioq_cache_key;
+static __thread struct ioq_cache *ioq_cache;
+static int64_t ioq_cache_bytes;	/* charged magazine capacity */
+
+static inline bool
+ioq_mag_charge(struct ioq_depot *dp)
+{
+	int64_t bytes = dp->capacity * dp->size;
+
+	if (atomic_add_int64_t(&ioq_cache_bytes, bytes) > IOQ_CACHE_BYTES) {
+		atomic_sub_int64_t(&ioq_cache_bytes, bytes);
+		return (false);
+	}
+	return (true);
+}
+
+static inline void
+ioq_mag_uncharge(struct ioq_depot *dp)
+{
+	atomic_sub_int64_t(&ioq_cache_bytes, dp->capacity * dp->size);
+}
+
+static inline int
+ioq_buf_class(size_t size)
+{
+	int shift;
+
+	if (size <= (1UL << IOQ_CLASS_MIN_SHIFT))
+		return (0);
+
+	shift = (sizeof(unsigned long) * 8) - __builtin_clzl(size - 1);
+	if (shift >= IOQ_CLASS_MIN_SHIFT + IOQ_BUF_CLASSES)
+		return (-1);
+
+	return (shift - IOQ_CLASS_MIN_SHIFT);
+}
+
+/* thread exit:  hand the magazines back to the depot, or free them */
+static void
+ioq_cache_exit(void *arg)
+{
+	struct ioq_cache *tc = arg;
+	struct ioq_depot *dp;
+	struct ioq_mag *mag;
+	int c;
+
+	for (c = 0; c < IOQ_CLASSES; c++) {
+		mag = tc->mag[c];
+		if (!mag)
+			continue;
+		dp = &ioq_depot[c];
+
+		mutex_lock(&dp->mtx);
+		if (mag->rounds && dp->n_full < IOQ_DEPOT_MAX) {
+			mag->next = dp->full;
+			dp->full = mag;
+			dp->n_full++;
+			mag = NULL;
+		}
+		mutex_unlock(&dp->mtx);
+
+		if (mag) {
+			while (mag->rounds)
+				mem_free(mag->round[--mag->rounds], dp->size);
+			mem_free(mag, sizeof(*mag));
+			ioq_mag_uncharge(dp);
+		}
+	}
+	mem_free(tc, sizeof(*tc));
+	ioq_cache = NULL;
+}
+
+static void
+ioq_cache_init(void)
+{
+	struct ioq_depot *dp;
+	int c;
+
+	for (c = 0; c < IOQ_CLASSES; c++) {
+		dp = &ioq_depot[c];
+		mutex_init(&dp->mtx, NULL);
+
+		if (c == IOQ_CLASS_UV)
+			dp->size = sizeof(struct xdr_ioq_uv);
+		else if (c == IOQ_CLASS_IOQ)
+			dp->size = sizeof(struct xdr_ioq);
+		else
+			dp->size = 1UL << (IOQ_CLASS_MIN_SHIFT + c);
+
+		dp->capacity = IOQ_MAG_BYTES / dp->size;
+		if (dp->capacity > IOQ_MAG_ROUNDS)
+			dp->capacity = IOQ_MAG_ROUNDS;
+		if (dp->capacity < 1)
+			dp->capacity = 1;
+	}
+	(void)pthread_key_create(&ioq_cache_key, ioq_cache_exit);
+}
+
+static inline struct ioq_cache *
+ioq_cache_get(void)
+{
+	if (likely(ioq_cache))
+		return (ioq_cache);
+
+	(void)pthread_once(&ioq_cache_once, ioq_cache_init);
+	ioq_cache = mem_zalloc(sizeof(struct ioq_cache));
+	(void)pthread_setspecific(ioq_cache_key, ioq_cache);
+	return (ioq_cache);
+}
+
+/* returns NULL when the caller must allocate */
+static void *
+ioq_cache_alloc(int c)
+{
+	struct ioq_cache *tc = ioq_cache_get();
+	struct ioq_mag *mag = tc->mag[c];
+	struct ioq_depot *dp;
+
+	if (likely(mag && mag->rounds))
+		return (mag->round[--mag->rounds]);
+
+	/* trade the empty magazine for a full one */
+	dp = &ioq_depot[c];
+	mutex_lock(&dp->mtx);
+	if (!dp->full) {
+		mutex_unlock(&dp->mtx);
+		return (NULL);
+	}
+	tc->mag[c] = dp->full;
+	dp->full = dp->full->next;
+	dp->n_full--;
+	if (mag) {
+		mag->next = dp->empty;
+		dp->empty = mag;
+	}
+	mutex_unlock(&dp->mtx);
+
+	if (mag)
+		ioq_mag_uncharge(dp);
+
+	mag = tc->mag[c];
+	return (mag->round[--mag->rounds]);
+}
+
+/* returns false when the caller must free */
+static bool
+ioq_cache_free(int c, void *p)
+{
+	struct ioq_cache *tc = ioq_cache_get();
+	struct ioq_mag *mag = tc->mag[c];
+	struct ioq_depot *dp = &ioq_depot[c];
+
+	if (likely(mag && mag->rounds < dp->capacity)) {
+		mag->round[mag->rounds++] = p;
+		return (true);
+	}
+
+	/* trade the full magazine for an empty one */
+	if (!ioq_mag_charge(dp)) {
+		/* over the global budget */
+		return (false);
+	}
+
+	mutex_lock(&dp->mtx);
+	if (mag) {
+		if (dp->n_full >= IOQ_DEPOT_MAX) {
+			/* enough cached already */
+			mutex_unlock(&dp->mtx);
+			ioq_mag_uncharge(dp);
+			return (false);
+		}
+		mag->next = dp->full;
+		dp->full = mag;
+		dp->n_full++;
+	}
+	mag = dp->empty;
+	if (mag)
+		dp->empty = mag->next;
+	mutex_unlock(&dp->mtx);
+
+	if (!mag)
+		mag = mem_alloc(sizeof(*mag));
+	mag->rounds = 0;
+	tc->mag[c] = mag;
+
+	mag->round[mag->rounds++] = p;
+	return (true);
+}
+
+static inline void *
+alloc_buffer(size_t size)
+{
+	int c = ioq_buf_class(size);
+	void *p;
+
+	if (c < 0)
+		return (mem_alloc(size));
+
+	p = ioq_cache_alloc(c);
+	if (!p)
+		p = mem_alloc(ioq_depot[c].size);
+	return (p);
+}
+
+static inline void
+free_buffer(void *addr, size_t size)
+{
+	int c = ioq_buf_class(size);
+
+	if (c < 0 || !ioq_cache_free(c, addr))
+		mem_free(addr, size);
+}
+
+static inline struct xdr_ioq_uv *
+alloc_uv(void)
+{
+	struct xdr_ioq_uv *uv = ioq_cache_alloc(IOQ_CLASS_UV);
+
+	if (!uv)
+		return (mem_zalloc(sizeof(struct xdr_ioq_uv)));
+
+	memset(uv, 0, sizeof(struct xdr_ioq_uv));
+	return (uv);
+}
+
+static inline void
+free_uv(struct xdr_ioq_uv *uv)
+{
+	if (!ioq_cache_free(IOQ_CLASS_UV, uv))
+		mem_free(uv, sizeof(*uv));
+}
 
 struct xdr_ioq_uv *
 xdr_ioq_uv_create(size_t size, u_int uio_flags)
 {
-	struct xdr_ioq_uv *uv = mem_zalloc(sizeof(struct xdr_ioq_uv));
+	struct xdr_ioq_uv *uv = alloc_uv();
 
 	if (size) {
 		uv->v.vio_base = alloc_buffer(size);
@@ -199,10 +474,10 @@ xdr_ioq_uv_release(struct xdr_ioq_uv *uv)
 			__warnx(TIRPC_DEBUG_FLAG_XDR, "Call uio_release");
 			uv->u.uio_refer->uio_release(uv->u.uio_refer,
 						     UIO_FLAG_NONE);
-			mem_free(uv, sizeof(*uv));
+			free_uv(uv);
 		} else if (uv->u.uio_flags & UIO_FLAG_FREE) {
 			free_buffer(uv->v.vio_base, ioquv_size(uv));
-			mem_free(uv, sizeof(*uv));
+			free_uv(uv);
 		} else if (uv->u.uio_flags & UIO_FLAG_BUFQ) {
 			uv->u.uio_references = 1;	/* keeping one */
 			xdr_ioq_uv_recycle(uv->u.uio_p1, &uv->uvq);
@@ -292,7 +567,12 @@ xdr_ioq_setup(struct xdr_ioq *xioq)
 struct xdr_ioq *
 xdr_ioq_create(size_t min_bsize, size_t max_bsize, u_int uio_flags)
 {
-	struct xdr_ioq *xioq = mem_zalloc(sizeof(struct xdr_ioq));
+	struct xdr_ioq *xioq = ioq_cache_alloc(IOQ_CLASS_IOQ);
+
+	if (xioq)
+		memset(xioq, 0, sizeof(struct xdr_ioq));
+	else
+		xioq = mem_zalloc(sizeof(struct xdr_ioq));
 
 	xdr_ioq_setup(xioq);
 	xioq->xdrs[0].x_flags |= XDR_FLAG_FREE;
@@ -375,9 +655,9 @@ xdr_ioq_uv_append(struct xdr_ioq *xioq, u_int ioq_flags)
 			xioq->ioq_uv.plength -= len;
 			assert(uv->u.uio_flags & UIO_FLAG_FREE);
 
-			base = mem_alloc(xioq->ioq_uv.max_bsize);
+			base = alloc_buffer(xioq->ioq_uv.max_bsize);
 			memcpy(base, uv->v.vio_head, len);
-			mem_free(uv->v.vio_base, size);
+			free_buffer(uv->v.vio_base, size);
 			uv->v.vio_base =
 			uv->v.vio_head = base + 0;
 			uv->v.vio_tail = base + len;
@@ -779,7 +1059,9 @@ xdr_ioq_destroy(struct xdr_ioq *xioq, size_t qsize)
 	pthread_cond_destroy(&xioq->ioq_cond);
 
 	if (xioq->xdrs[0].x_flags & XDR_FLAG_FREE) {
-		mem_free(xioq, qsize);
+		/* only xdr_ioq_create() sets it */
+		if (!ioq_cache_free(IOQ_CLASS_IOQ, xioq))
+			mem_free(xioq, qsize);
 	}
 }
 
@@ -77,6 +77,7 @@ xdrmem_ncreate(XDR *xdrs, char *addr, u_int size, enum xdr_op op)
 	xdrs->x_private = NULL;
 	xdrs->x_lib[0] = NULL;
 	xdrs->x_lib[1] = NULL;
+	xdrs->x_flags = XDR_FLAG_NONE;
 	xdrs->x_data = addr;
 	xdrs->x_v.vio_base = addr;
 	xdrs->x_v.vio_head = addr;
@@ -853,6 +853,7 @@ static inline void update_atomic_fields(struct gsh_export *export,
 	atomic_store_uint64_t(&export->PrefReaddir, src->PrefReaddir);
 	atomic_store_uint64_t(&export->MaxOffsetWrite, src->MaxOffsetWrite);
 	atomic_store_uint64_t(&export->MaxOffsetRead, src->MaxOffsetRead);
+	atomic_store_uint32_t(&export->req_class, src->req_class);
 	atomic_store_uint32_t(&export->options, src->options);
 	atomic_store_uint32_t(&export->options_set, src->options_set);
 }
@@ -1798,6 +1799,17 @@ static struct config_item_list squash_types[] = {
 	CONFIG_LIST_EOL
 };
 
+/**
+ * @brief Worker priority classes for the Request_Class parameter
+ */
+
+static struct config_item_list req_classes[] = {
+	CONFIG_LIST_TOK("auto", EXPORT_REQ_CLASS_AUTO),
+	CONFIG_LIST_TOK("interactive", EXPORT_REQ_CLASS_INTERACTIVE),
+	CONFIG_LIST_TOK("bulk", EXPORT_REQ_CLASS_BULK),
+	CONFIG_LIST_EOL
+};
+
 /**
  * @brief Delegations types list for the Delegations parameter
  */
@@ -2046,6 +2058,8 @@ static struct config_item fsal_params[] = {
 		       _struct_, MaxOffsetWrite),			\
 	CONF_ITEM_UI64("MaxOffsetRead", 512, UINT64_MAX, INT64_MAX,	\
 		       _struct_, MaxOffsetRead),			\
+	CONF_ITEM_TOKEN("Request_Class", EXPORT_REQ_CLASS_AUTO,		\
+			req_classes, _struct_, req_class),		\
 	CONF_ITEM_BOOLBIT_SET("UseCookieVerifier",			\
 		false, EXPORT_OPTION_USE_COOKIE_VERIFIER,		\
 		_struct_, options, options_set),			\
@@ -201,8 +201,11 @@ static struct config_item core_params[] = {
 		       nfs_core_param, drc.disabled),
 	CONF_ITEM_UI32("DRC_Recycle_Hiwat", 1, 1000000, DRC_RECYCLE_HIWAT,
 			nfs_core_param, drc.recycle_hiwat),
-	CONF_ITEM_UI32("DRC_TCP_Npart", 1, 20, DRC_TCP_NPART,
-		       nfs_core_param, drc.tcp.npart),
+	CONF_ITEM_UI64("DRC_Max_Memory", 0, UINT64_MAX, DRC_MAX_MEMORY,
+		       nfs_core_param, drc.max_memory),
+	CONF_ITEM_DEPRECATED("DRC_TCP_Npart",
+			     "TCP DRCs are indexed by XID and no longer partitioned"
+			     ),
 	CONF_ITEM_UI32("DRC_TCP_Size", 1, 32767, DRC_TCP_SIZE,
 		       nfs_core_param, drc.tcp.size),
 	CONF_ITEM_UI32("DRC_TCP_Cachesz", 1, 255, DRC_TCP_CACHESZ,
@@ -227,6 +230,8 @@ static struct config_item core_params[] = {
 		       nfs_core_param, drc.udp.checksum),
 	CONF_ITEM_UI32("RPC_Max_Connections", 1, 1000000, 1024,
 		       nfs_core_param, rpc.max_connections),
+	CONF_ITEM_UI32("RPC_Max_Requests_Per_Connection", 0, 65536, 512,
+		       nfs_core_param, rpc.max_conn_requests),
 	CONF_ITEM_UI32("RPC_Idle_Timeout_S", 0, 60*60, 300,
 		       nfs_core_param, rpc.idle_timeout_s),
 	CONF_ITEM_UI32("MaxRPCSendBufferSize", 1, 1048576*9,
@@ -239,6 +244,18 @@ static struct config_item core_params[] = {
 		       nfs_core_param, rpc.ioq_thrd_min),
 	CONF_ITEM_UI32("RPC_Ioq_ThrdMax", 2, 1024*128, 200,
 		       nfs_core_param, rpc.ioq_thrd_max),
+	CONF_ITEM_UI32("RPC_Bulk_Worker_Share", 1, 100, 100,
+		       nfs_core_param, rpc.bulk_worker_share),
+	CONF_ITEM_BOOL("RPC_IO_Uring", false,
+		       nfs_core_param, rpc.io_uring),
+	CONF_ITEM_UI32("RPC_Listen_Shards", 1, RPC_LISTEN_SHARDS_MAX, 1,
+		       nfs_core_param, rpc.listen_shards),
+	CONF_ITEM_PATH("RPC_TLS_Certificate", 1, MAXPATHLEN, NULL,
+		       nfs_core_param, rpc.tls_cert_file),
+	CONF_ITEM_PATH("RPC_TLS_Key", 1, MAXPATHLEN, NULL,
+		       nfs_core_param, rpc.tls_key_file),
+	CONF_ITEM_PATH("RPC_TLS_CA", 1, MAXPATHLEN, NULL,
+		       nfs_core_param, rpc.tls_ca_file),
 	CONF_ITEM_UI32("RPC_GSS_Npart", 1, 1021, 13,
 		       nfs_core_param, rpc.gss.ctx_hash_partitions),
 	CONF_ITEM_UI32("RPC_GSS_Max_Ctx", 1, 1024*1024, 16384,
@@ -449,6 +466,8 @@ static struct config_item version4_params[] = {
 		       nfs_version4_parameter, enforce_utf8_vld),
 	CONF_ITEM_UI32("Max_Client_Ids", 0, UINT32_MAX, 0,
 		       nfs_version4_parameter, max_client_ids),
+	CONF_ITEM_UI32("Compound_Parallel_Reads", 0, NFS4_MAX_OPERATIONS, 0,
+		       nfs_version4_parameter, compound_parallel_reads),
 	CONFIG_EOL
 };
 
@@ -0,0 +1,266 @@
+// SPDX-License-Identifier: LGPL-3.0-or-later
+/*
+ * vim:noexpandtab:shiftwidth=8:tabstop=8:
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 3 of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc.,
+ * 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+ *
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdint.h>
+#include <string.h>
+
+#include "CUnit/Basic.h"
+
+#include "abstract_mem.h"
+#include "../FSAL/Stackable_FSALs/FSAL_MDCACHE/mdcache_dirent_index.h"
+
+/* Capacity of a fresh index, which holds up to 12 dirents before growing */
+#define IDX_SLOTS 16
+
+#define N_VALS 1000
+
+/* The index never looks inside a dirent, anything addressable will do */
+static char vals[N_VALS];
+
+#define DIRENT(n) ((struct mdcache_dir_entry__ *) &vals[n])
+
+static struct mdc_dirent_index idx;
+
+/**
+ * @brief Find the nth key, from 1 up, whose home slot is @a slot
+ */
+static uint64_t key_with_home(uint32_t slot, int nth)
+{
+	struct mdc_dirent_index shape = { .mask = IDX_SLOTS - 1 };
+	uint64_t key;
+
+	for (key = 1; ; key++) {
+		if (mdc_dirent_index_home(&shape, key) == slot && --nth == 0)
+			return key;
+	}
+}
+
+static int slot_of(struct mdcache_dir_entry__ *dirent)
+{
+	uint32_t i;
+
+	for (i = 0; i <= idx.mask; i++) {
+		if (idx.slots[i].dirent == dirent)
+			return i;
+	}
+
+	return -1;
+}
+
+int init_suite(void)
+{
+	memset(&idx, 0, sizeof(idx));
+	return 0;
+}
+
+int clean_suite(void)
+{
+	mdc_dirent_index_free(&idx);
+	return 0;
+}
+
+void idx_setup(void)
+{
+	memset(&idx, 0, sizeof(idx));
+}
+
+void idx_teardown(void)
+{
+	mdc_dirent_index_free(&idx);
+}
+
+/*
+ *  BEGIN BASIC TESTS
+ */
+
+/* A probe run starting in the last slot continues at slot 0 */
+void wraparound_insert(void)
+{
+	uint64_t k0 = key_with_home(IDX_SLOTS - 1, 1);
+	uint64_t k1 = key_with_home(IDX_SLOTS - 1, 2);
+	uint64_t k2 = key_with_home(IDX_SLOTS - 1, 3);
+
+	mdc_dirent_index_insert(&idx, k0, DIRENT(0));
+	mdc_dirent_index_insert(&idx, k1, DIRENT(1));
+	mdc_dirent_index_insert(&idx, k2, DIRENT(2));
+
+	CU_ASSERT_EQUAL(idx.mask, IDX_SLOTS - 1);
+	CU_ASSERT_EQUAL(idx.count, 3);
+	CU_ASSERT_EQUAL(slot_of(DIRENT(0)), IDX_SLOTS - 1);
+	CU_ASSERT_EQUAL(slot_of(DIRENT(1)), 0);
+	CU_ASSERT_EQUAL(slot_of(DIRENT(2)), 1);
+
+	CU_ASSERT_PTR_EQUAL(mdc_dirent_index_lookup(&idx, k0), DIRENT(0));
+	CU_ASSERT_PTR_EQUAL(mdc_dirent_index_lookup(&idx, k1), DIRENT(1));
+	CU_ASSERT_PTR_EQUAL(mdc_dirent_index_lookup(&idx, k2), DIRENT(2));
+}
+
+/* Deleting the head of a wrapped run shifts the rest back across slot 0 */
+void wraparound_delete(void)
+{
+	uint64_t k0 = key_with_home(IDX_SLOTS - 1, 1);
+	uint64_t k1 = key_with_home(IDX_SLOTS - 1, 2);
+	uint64_t k2 = key_with_home(IDX_SLOTS - 1, 3);
+
+	mdc_dirent_index_insert(&idx, k0, DIRENT(0));
+	mdc_dirent_index_insert(&idx, k1, DIRENT(1));
+	mdc_dirent_index_insert(&idx, k2, DIRENT(2));
+
+	CU_ASSERT_TRUE(mdc_dirent_index_remove(&idx, k0, DIRENT(0)));
+
+	CU_ASSERT_EQUAL(idx.count, 2);
+	CU_ASSERT_EQUAL(slot_of(DIRENT(1)), IDX_SLOTS - 1);
+	CU_ASSERT_EQUAL(slot_of(DIRENT(2)), 0);
+	CU_ASSERT_PTR_NULL(idx.slots[1].dirent);
+
+	CU_ASSERT_PTR_NULL(mdc_dirent_index_lookup(&idx, k0));
+	CU_ASSERT_PTR_EQUAL(mdc_dirent_index_lookup(&idx, k1), DIRENT(1));
+	CU_ASSERT_PTR_EQUAL(mdc_dirent_index_lookup(&idx, k2), DIRENT(2));
+}
+
+/* Backward shift skips entries whose home lies between the hole and them */
+void backward_shift_delete(void)
+{
+	uint64_t ka = key_with_home(IDX_SLOTS - 2, 1);
+	uint64_t kb = key_with_home(IDX_SLOTS - 2, 2);
+	uint64_t kc = key_with_home(0, 1);
+	uint64_t kd = key_with_home(IDX_SLOTS - 2, 3);
+
+	/* a and b fill the last two slots, c is at home in slot 0 and d
+	 * probes past it to slot 1.
+	 */
+	mdc_dirent_index_insert(&idx, ka, DIRENT(0));
+	mdc_dirent_index_insert(&idx, kb, DIRENT(1));
+	mdc_dirent_index_insert(&idx, kc, DIRENT(2));
+	mdc_dirent_index_insert(&idx, kd, DIRENT(3));
+
+	CU_ASSERT_EQUAL(slot_of(DIRENT(0)), IDX_SLOTS - 2);
+	CU_ASSERT_EQUAL(slot_of(DIRENT(1)), IDX_SLOTS - 1);
+	CU_ASSERT_EQUAL(slot_of(DIRENT(2)), 0);
+	CU_ASSERT_EQUAL(slot_of(DIRENT(3)), 1);
+
+	CU_ASSERT_TRUE(mdc_dirent_index_remove(&idx, ka, DIRENT(0)));
+
+	/* b and d move back, c must stay in its home slot */
+	CU_ASSERT_EQUAL(idx.count, 3);
+	CU_ASSERT_EQUAL(slot_of(DIRENT(1)), IDX_SLOTS - 2);
+	CU_ASSERT_EQUAL(slot_of(DIRENT(3)), IDX_SLOTS - 1);
+	CU_ASSERT_EQUAL(slot_of(DIRENT(2)), 0);
+	CU_ASSERT_PTR_NULL(idx.slots[1].dirent);
+
+	CU_ASSERT_PTR_EQUAL(mdc_dirent_index_lookup(&idx, kb), DIRENT(1));
+	CU_ASSERT_PTR_EQUAL(mdc_dirent_index_lookup(&idx, kc), DIRENT(2));
+	CU_ASSERT_PTR_EQUAL(mdc_dirent_index_lookup(&idx, kd), DIRENT(3));
+}
+
+/* Dirents sharing a key are removed individually, absent ones not at all */
+void duplicate_keys(void)
+{
+	mdc_dirent_index_insert(&idx, 42, DIRENT(0));
+	mdc_dirent_index_insert(&idx, 42, DIRENT(1));
+
+	CU_ASSERT_FALSE(mdc_dirent_index_remove(&idx, 42, DIRENT(2)));
+	CU_ASSERT_FALSE(mdc_dirent_index_remove(&idx, 43, DIRENT(0)));
+	CU_ASSERT_EQUAL(idx.count, 2);
+
+	CU_ASSERT_TRUE(mdc_dirent_index_remove(&idx, 42, DIRENT(0)));
+	CU_ASSERT_PTR_EQUAL(mdc_dirent_index_lookup(&idx, 42), DIRENT(1));
+	CU_ASSERT_TRUE(mdc_dirent_index_remove(&idx, 42, DIRENT(1)));
+	CU_ASSERT_PTR_NULL(mdc_dirent_index_lookup(&idx, 42));
+	CU_ASSERT_EQUAL(idx.count, 0);
+}
+
+/* Growing rehashes everything, and the load stays under 3/4 */
+void grow_and_drain(void)
+{
+	int i;
+
+	for (i = 0; i < N_VALS; i++)
+		mdc_dirent_index_insert(&idx, i, DIRENT(i));
+
+	CU_ASSERT_EQUAL(idx.count, N_VALS);
+	CU_ASSERT(idx.count * 4 <= (idx.mask + 1) * 3);
+
+	for (i = 0; i < N_VALS; i += 2)
+		CU_ASSERT_TRUE(mdc_dirent_index_remove(&idx, i, DIRENT(i)));
+
+	CU_ASSERT_EQUAL(idx.count, N_VALS / 2);
+
+	for (i = 0; i < N_VALS; i++) {
+		if (i % 2 == 0) {
+			CU_ASSERT_PTR_NULL(mdc_dirent_index_lookup(&idx, i));
+		} else {
+			CU_ASSERT_PTR_EQUAL(mdc_dirent_index_lookup(&idx, i),
+					    DIRENT(i));
+		}
+	}
+
+	for (i = 1; i < N_VALS; i += 2)
+		CU_ASSERT_TRUE(mdc_dirent_index_remove(&idx, i, DIRENT(i)));
+
+	CU_ASSERT_EQUAL(idx.count, 0);
+
+	for (i = 0; i <= idx.mask; i++)
+		CU_ASSERT_PTR_NULL(idx.slots[i].dirent);
+}
+
+/* The main() function for setting up and running the tests.
+ * Returns a CUE_SUCCESS on successful running, another
+ * CUnit error code on failure.
+ */
+int main(int argc, char *argv[])
+{
+	/* initialize the CUnit test registry...  get this party started */
+	if (CU_initialize_registry() != CUE_SUCCESS)
+		return CU_get_error();
+
+	CU_TestInfo dirent_index_arr[] = {
+		{"Insert wrapping around the end.", wraparound_insert}
+		,
+		{"Delete wrapping around the end.", wraparound_delete}
+		,
+		{"Backward shift delete.", backward_shift_delete}
+		,
+		{"Duplicate keys.", duplicate_keys}
+		,
+		{"Grow and drain.", grow_and_drain}
+		,
+		CU_TEST_INFO_NULL,
+	};
+
+	CU_SuiteInfo suites[] = {
+		{"Dirent index operations", init_suite, clean_suite,
+		 idx_setup, idx_teardown, dirent_index_arr}
+		,
+		CU_SUITE_INFO_NULL,
+	};
+
+	CU_register_suites(suites);
+
+	/* Run all tests using the CUnit Basic interface */
+	CU_basic_set_mode(CU_BRM_VERBOSE);
+	CU_basic_run_tests();
+	CU_cleanup_registry();
+
+	return CU_get_error();
+}